@@ -1,5 +1,5 @@
 QT -= gui
-QT += widgets xml
+QT += widgets
 
 CONFIG += c++17
 CONFIG -= app_bundle
@@ -16,19 +16,57 @@ include(version.pri)
 SOURCES += \
     src/abstractnodewidget.cpp \
     src/arrange.cpp \
+    src/changejournal.cpp \
+    src/edgerouter.cpp \
+    src/encodedtext.cpp \
+    src/grapharchive.cpp \
+    src/graphimporter.cpp \
+    src/graphloader.cpp \
+    src/graphsnapshot.cpp \
     src/graphwidget.cpp \
     src/groupwidget.cpp \
+    src/icontable.cpp \
     src/itemwidget.cpp \
+    src/layoutcache.cpp \
+    src/layoutgraph.cpp \
+    src/layoutrandom.cpp \
     src/link.cpp \
+    src/linkdescriptor.cpp \
+    src/multilevellayout.cpp \
+    src/nodedescriptor.cpp \
+    src/parallel.cpp \
+    src/slotallocator.cpp \
+    src/sortkeys.cpp \
+    src/spatialindex.cpp \
+    src/stresslayout.cpp \
     src/xmlfunctions.cpp
 
 HEADERS += \
     src/abstractnodewidget.h \
     src/arrange.h \
+    src/changejournal.h \
+    src/edgerouter.h \
+    src/encodedtext.h \
+    src/grapharchive.h \
+    src/graphimporter.h \
+    src/graphloader.h \
+    src/graphsnapshot.h \
     src/graphwidget.h \
     src/groupwidget.h \
+    src/icontable.h \
     src/itemwidget.h \
+    src/layoutcache.h \
+    src/layoutgraph.h \
+    src/layoutrandom.h \
     src/link.h \
+    src/linkdescriptor.h \
+    src/multilevellayout.h \
+    src/nodedescriptor.h \
+    src/parallel.h \
+    src/slotallocator.h \
+    src/sortkeys.h \
+    src/spatialindex.h \
+    src/stresslayout.h \
     src/xmlfunctions.h
 
 # includes dir
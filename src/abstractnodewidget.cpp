@@ -6,14 +6,13 @@
 #include <algorithm>
 
 #include <cmath>
-#include <random>
 
 #include "itemwidget.h"
 #include "xmlfunctions.h"
 #include "qnamespace.h"
 #include "graphwidget.h"
-
-#define RANDOM_ITERS 5
+#include "spatialindex.h"
+#include "arrange.h"
 
 using namespace QNodeGraph;
 
@@ -40,7 +39,7 @@ void AbstractNodeWidget::init(const QString &id, QWidget *parent)
     this->id=id;
     this->text=id;
     this->subText="";
-    this->description="";
+    this->description.setText("");
 
     this->textFont=(GRAPH->getDefaultNodeTextFont());
     this->subTextFont=(GRAPH->getDefaultNodeSubTextFont());
@@ -63,12 +62,6 @@ void AbstractNodeWidget::init(const QString &id, QWidget *parent)
     verticalOffset = 0;
 }
 
-AbstractNodeWidget::AbstractNodeWidget(QWidget *parent, const QString & xml, const QString & type) : QWidget(parent)
-{
-    init("",parent);
-    setXML(type,xml);
-}
-
 AbstractNodeWidget::AbstractNodeWidget(const QString &id, QWidget * parent, const QString & text, const QString &subtext) : QWidget(parent)
 {
     init(id,parent);
@@ -84,98 +77,173 @@ AbstractNodeWidget::AbstractNodeWidget(const QString &id, QWidget *parent)
 
 AbstractNodeWidget::~AbstractNodeWidget()
 {
+    GRAPH->getChangeJournal()->markRemoved(this);
+    Arrange::countChildNode(parentWidget(),-1);
 }
 
 bool AbstractNodeWidget::setXML(const QString & widgetName, const QString & xml)
 {
-    QString errorMsg;
-    int errorLine;
-    int errorColumn;
-
-    QDomDocument doc;
-    if (!doc.setContent(xml,false, &errorMsg, &errorLine, &errorColumn))
-        return false;
+    QXmlStreamReader reader(xml);
 
-    QDomElement myroot = doc.documentElement();
     // Not a ItemWidget/GroupWidget element
-    if (myroot.tagName() != widgetName)
+    if (!reader.readNextStartElement() || reader.name() != widgetName)
         return false;
 
-    QDomNode child = myroot.firstChild();
-    while (!child.isNull())
+    return readXML(reader);
+}
+
+bool AbstractNodeWidget::readXML(QXmlStreamReader &xml, IconTable *icons)
+{
+    while (xml.readNextStartElement())
     {
-        if (child.toElement().tagName() == "properties")
+        if (xml.name() == QLatin1String("properties"))
         {
-            setNodeXMLLocalProperties(child);
+            NodeDescriptor node;
+            NodeDescriptor::readProperties(xml,&node);
+            setNodeDescriptor(node,icons);
         }
-        else if (child.toElement().tagName() == "data")
+        else if (xml.name() == QLatin1String("data"))
         {
-            // from base64
-            QByteArray bArrayElement = QByteArray::fromBase64(QByteArray(child.toElement().text().toUtf8()));
-            embeddedData = QString().fromUtf8(bArrayElement.data(),bArrayElement.size());
+            embeddedData = EncodedText::fromBase64(xml.readElementText().toLatin1());
         }
-        else
+        else if (!readXMLLocal(xml,icons))
         {
-            setXMLLocal(child);
+            xml.skipCurrentElement();
         }
-
-        child = child.nextSibling();
     }
 
     show();
-    return true;
+    return !xml.hasError();
+}
+
+void AbstractNodeWidget::setNodeDescriptor(const NodeDescriptor &node, IconTable *icons)
+{
+    if (node.has(NodeDescriptor::PROP_ID))
+        setId(node.id);
+    if (node.has(NodeDescriptor::PROP_POS))
+        move(node.pos);
+    if (node.has(NodeDescriptor::PROP_TEXT))
+        text = node.text;
+    if (node.has(NodeDescriptor::PROP_SUBTEXT))
+        subText = node.subText;
+    if (node.has(NodeDescriptor::PROP_DESCRIPTION))
+        description = node.description;
+    if (node.has(NodeDescriptor::PROP_TEXTFONT))
+        textFont.fromString(node.textFont);
+    if (node.has(NodeDescriptor::PROP_SUBTEXTFONT))
+        subTextFont.fromString(node.subTextFont);
+    if (node.has(NodeDescriptor::PROP_BORDERCOLOR))
+        borderColor = node.borderColor;
+    if (node.has(NodeDescriptor::PROP_SELECTEDBORDERCOLOR))
+        selectedBorderColor = node.selectedBorderColor;
+    if (node.has(NodeDescriptor::PROP_TEXTCOLOR))
+        textColor = node.textColor;
+    if (node.has(NodeDescriptor::PROP_SUBTEXTCOLOR))
+        subTextColor = node.subTextColor;
+    if (node.has(NodeDescriptor::PROP_FILLCOLOR))
+        fillColor = node.fillColor;
+    if (node.has(NodeDescriptor::PROP_FILLCOLOR2))
+        fillColor2 = node.fillColor2;
+    if (node.has(NodeDescriptor::PROP_FILLMODE))
+        fillMode = (AbstractNodeWidget::ItemBoxFillMode)node.fillMode;
+    if (node.has(NodeDescriptor::PROP_BORDERROUNDRECTPIXELS))
+        borderRoundRectPixels = node.borderRoundRectPixels;
+    if (node.has(NodeDescriptor::PROP_ANCHORED))
+        anchored = node.anchored;
+    if (node.has(NodeDescriptor::PROP_DATA))
+        embeddedData = node.embeddedData;
+
+    setNodeDescriptorLocal(node,icons);
+
+    // Texts, fonts and icons change the node size
+    recalculateSize();
+    update();
+}
+
+void AbstractNodeWidget::getNodeDescriptor(NodeDescriptor *node) const
+{
+    node->properties |= NodeDescriptor::PROP_ID | NodeDescriptor::PROP_POS | NodeDescriptor::PROP_TEXT | NodeDescriptor::PROP_SUBTEXT |
+                        NodeDescriptor::PROP_DESCRIPTION | NodeDescriptor::PROP_TEXTFONT | NodeDescriptor::PROP_SUBTEXTFONT |
+                        NodeDescriptor::PROP_BORDERCOLOR | NodeDescriptor::PROP_SELECTEDBORDERCOLOR | NodeDescriptor::PROP_TEXTCOLOR |
+                        NodeDescriptor::PROP_SUBTEXTCOLOR | NodeDescriptor::PROP_FILLCOLOR | NodeDescriptor::PROP_FILLCOLOR2 |
+                        NodeDescriptor::PROP_FILLMODE | NodeDescriptor::PROP_BORDERROUNDRECTPIXELS | NodeDescriptor::PROP_ANCHORED |
+                        NodeDescriptor::PROP_DATA;
+    node->id = id;
+    node->pos = pos();
+    node->text = text;
+    node->subText = subText;
+    node->description = description;
+    node->textFont = textFont.toString();
+    node->subTextFont = subTextFont.toString();
+    node->borderColor = borderColor;
+    node->selectedBorderColor = selectedBorderColor;
+    node->textColor = textColor;
+    node->subTextColor = subTextColor;
+    node->fillColor = fillColor;
+    node->fillColor2 = fillColor2;
+    node->fillMode = fillMode;
+    node->borderRoundRectPixels = borderRoundRectPixels;
+    node->anchored = anchored;
+    node->embeddedData = embeddedData;
+
+    getNodeDescriptorLocal(node);
 }
 
 /* Export into XML */
 QString AbstractNodeWidget::getXML(const QString & widgetName, bool xmltag)
 {
     QString exportedXML;
-    if (xmltag) exportedXML = "<?xml version=\"1.0\" encoding='UTF-8'?>";
+    QXmlStreamWriter xml(&exportedXML);
+    if (xmltag) xml.writeStartDocument();
 
-    exportedXML.append(QString::asprintf("<%s>",widgetName.toStdString().c_str()));
-    exportedXML.append("<properties>");
+    writeXML(xml,widgetName);
+
+    if (xmltag) xml.writeEndDocument();
+    return exportedXML;
+}
+
+void AbstractNodeWidget::writeXML(QXmlStreamWriter &xml, const QString &widgetName, IconTable *icons, bool contents)
+{
+    xml.writeStartElement(widgetName);
+    xml.writeStartElement("properties");
 
     if (1)
     {
-        exportedXML.append( XMLFunctions::createSimpleTag("id",(QString)id.toUtf8().toBase64()) );
+        XMLFunctions::writeSimpleTag(xml, "id",(QString)id.toUtf8().toBase64());
 
-        exportedXML.append(QString("<pos x=\"%1\" y=\"%2\"></pos>\n").arg(
-                               QString().setNum(pos().x()),
-                               QString().setNum(pos().y()))
-                           );
+        xml.writeEmptyElement("pos");
+        xml.writeAttribute("x",QString::number(pos().x()));
+        xml.writeAttribute("y",QString::number(pos().y()));
 
-        exportedXML.append( XMLFunctions::createSimpleTag("text",(QString)text.toUtf8().toBase64()) );
-        exportedXML.append( XMLFunctions::createSimpleTag("subText",(QString)subText.toUtf8().toBase64()) );
-        exportedXML.append( XMLFunctions::createSimpleTag("description",(QString)description.toUtf8().toBase64()) );
+        XMLFunctions::writeSimpleTag(xml, "text",(QString)text.toUtf8().toBase64());
+        XMLFunctions::writeSimpleTag(xml, "subText",(QString)subText.toUtf8().toBase64());
+        XMLFunctions::writeSimpleTag(xml, "description",(QString)description.toBase64());
 
-        exportedXML.append( XMLFunctions::createSimpleTag("textFont",(QString)textFont.toString().toUtf8().toBase64()) );
-        exportedXML.append( XMLFunctions::createSimpleTag("subTextFont",(QString)subTextFont.toString().toUtf8().toBase64()) );
+        XMLFunctions::writeSimpleTag(xml, "textFont",(QString)textFont.toString().toUtf8().toBase64());
+        XMLFunctions::writeSimpleTag(xml, "subTextFont",(QString)subTextFont.toString().toUtf8().toBase64());
 
-        exportedXML.append(XMLFunctions::createColorXMLTag("borderColor",borderColor));
-        exportedXML.append(XMLFunctions::createColorXMLTag("selectedBorderColor",selectedBorderColor));
-        exportedXML.append(XMLFunctions::createColorXMLTag("textColor",textColor));
-        exportedXML.append(XMLFunctions::createColorXMLTag("subTextColor",subTextColor));
-        exportedXML.append(XMLFunctions::createColorXMLTag("fillColor",fillColor));
-        exportedXML.append(XMLFunctions::createColorXMLTag("fillColor2",fillColor2));
+        XMLFunctions::writeColorXMLTag(xml, "borderColor",borderColor);
+        XMLFunctions::writeColorXMLTag(xml, "selectedBorderColor",selectedBorderColor);
+        XMLFunctions::writeColorXMLTag(xml, "textColor",textColor);
+        XMLFunctions::writeColorXMLTag(xml, "subTextColor",subTextColor);
+        XMLFunctions::writeColorXMLTag(xml, "fillColor",fillColor);
+        XMLFunctions::writeColorXMLTag(xml, "fillColor2",fillColor2);
 
-        exportedXML.append( XMLFunctions::createSimpleTag("fillMode", (uint64_t)fillMode));
-        exportedXML.append( XMLFunctions::createSimpleTag("borderRoundRectPixels", (uint64_t)borderRoundRectPixels));
+        XMLFunctions::writeSimpleTag(xml, "fillMode", (uint64_t)fillMode);
+        XMLFunctions::writeSimpleTag(xml, "borderRoundRectPixels", (uint64_t)borderRoundRectPixels);
 
-        exportedXML.append( XMLFunctions::createSimpleTag("anchored", anchored));
+        XMLFunctions::writeSimpleTag(xml, "anchored", anchored);
 
-        exportedXML+=getXMLLocalProperties();
+        writeXMLLocalProperties(xml,icons);
     }
 
-    exportedXML.append("</properties>");
+    xml.writeEndElement(); // properties
 
-    exportedXML+=getXMLLocal();
+    if (contents)
+        writeXMLLocal(xml,icons);
 
-    exportedXML.append("<data>");
-    exportedXML.append(QString(embeddedData.toUtf8().toBase64()));
-    exportedXML.append("</data>");
-    exportedXML.append(QString::asprintf("</%s>",widgetName.toStdString().c_str()));
-
-    return exportedXML;
+    xml.writeTextElement("data",QString(embeddedData.toBase64()));
+    xml.writeEndElement(); // widgetName
 }
 
 void AbstractNodeWidget::setSelectionMark(bool x)
@@ -191,13 +259,22 @@ bool AbstractNodeWidget::getSelectionMark() const
 
 void AbstractNodeWidget::setDescription(const QString & description)
 {
-    this->description = description;
+    this->description.setText(description);
+    journalChange(ChangeJournal::CHANGE_RESTYLED);
+}
+
+QString AbstractNodeWidget::getDescription() const
+{
+    return description.getText();
 }
 
 void AbstractNodeWidget::setId(const QString & nodeId)
 {
+    QString oldId = id;
     this->id = nodeId;
     setInternalObjectID();
+    if (oldId!=nodeId)
+        GRAPH->getChangeJournal()->markRenamed(this,oldId);
 }
 
 QString AbstractNodeWidget::getID() const
@@ -215,6 +292,20 @@ QString AbstractNodeWidget::getSubText() const
     return subText;
 }
 
+QByteArray AbstractNodeWidget::getSortKey(SortKeys::Field field, bool natural) const
+{
+    const QString & source = field==SortKeys::FIELD_ID? id : (field==SortKeys::FIELD_TEXT? text : subText);
+    int slot = (field*2)+(natural?1:0);
+
+    // Rebuild only when the value was changed since the last time
+    if (sortKeys[slot].isNull() || sortKeySources[slot]!=source)
+    {
+        sortKeySources[slot] = source;
+        sortKeys[slot] = SortKeys::makeKey(source,natural);
+    }
+    return sortKeys[slot];
+}
+
 bool AbstractNodeWidget::compareID(const QString &groupId) const
 {
     return (this->id == groupId);
@@ -240,24 +331,28 @@ QRect AbstractNodeWidget::getAbsoluteRect() const
 void AbstractNodeWidget::setSubText(const QString &subText)
 {
     this->subText = subText;
+    journalChange(ChangeJournal::CHANGE_RESTYLED);
     recalculateSize();
 }
 
 void AbstractNodeWidget::setText(const QString & text)
 {
     this->text = text;
+    journalChange(ChangeJournal::CHANGE_RESTYLED);
     recalculateSize();
 }
 
 void AbstractNodeWidget::setTextFont(const QFont &font)
 {
     textFont = font;
+    journalChange(ChangeJournal::CHANGE_RESTYLED);
     recalculateSize();
 }
 
 void AbstractNodeWidget::setAnchor(bool x)
 {
     anchored = x;
+    journalChange(ChangeJournal::CHANGE_RESTYLED);
 }
 
 bool AbstractNodeWidget::getAnchor() const
@@ -268,17 +363,20 @@ bool AbstractNodeWidget::getAnchor() const
 void AbstractNodeWidget::setSubTextFont(const QFont & font)
 {
     subTextFont = font;
+    journalChange(ChangeJournal::CHANGE_RESTYLED);
     recalculateSize();
 }
 
 void AbstractNodeWidget::setTextColor(const QColor &textColor)
 {
     this->textColor = textColor;
+    journalChange(ChangeJournal::CHANGE_RESTYLED);
 }
 
 void AbstractNodeWidget::setSubTextColor(const QColor &subTextColor)
 {
     this->subTextColor = subTextColor;
+    journalChange(ChangeJournal::CHANGE_RESTYLED);
 }
 
 void AbstractNodeWidget::setMouseOver(bool x)
@@ -289,6 +387,7 @@ void AbstractNodeWidget::setMouseOver(bool x)
 void AbstractNodeWidget::setBorderColor(const QColor & borderColor)
 {
     this->borderColor = borderColor;
+    journalChange(ChangeJournal::CHANGE_RESTYLED);
 }
 
 void AbstractNodeWidget::setSelected(bool x)
@@ -307,6 +406,7 @@ int AbstractNodeWidget::getBorderRoundRectPixels() const
 void AbstractNodeWidget::setBorderRoundRectPixels(int newRoundRectPixels)
 {
     borderRoundRectPixels = newRoundRectPixels;
+    journalChange(ChangeJournal::CHANGE_RESTYLED);
 }
 
 
@@ -318,6 +418,7 @@ const QColor &AbstractNodeWidget::getFillColor() const
 void AbstractNodeWidget::setFillColor(const QColor &newFillColor)
 {
     fillColor = newFillColor;
+    journalChange(ChangeJournal::CHANGE_RESTYLED);
 }
 
 AbstractNodeWidget::ItemBoxFillMode AbstractNodeWidget::getFillMode() const
@@ -328,6 +429,7 @@ AbstractNodeWidget::ItemBoxFillMode AbstractNodeWidget::getFillMode() const
 void AbstractNodeWidget::setFillMode(AbstractNodeWidget::ItemBoxFillMode newFillMode)
 {
     fillMode = newFillMode;
+    journalChange(ChangeJournal::CHANGE_RESTYLED);
 }
 
 QPoint AbstractNodeWidget::getCenterPoint() const
@@ -353,6 +455,7 @@ double AbstractNodeWidget::getExternalRadius() const
 void AbstractNodeWidget::setSelectedBorderColor(const QColor &selectedBorderColor)
 {
     this->selectedBorderColor = selectedBorderColor;
+    journalChange(ChangeJournal::CHANGE_RESTYLED);
 }
 
 bool AbstractNodeWidget::getIsSelected() const
@@ -363,128 +466,57 @@ bool AbstractNodeWidget::getIsSelected() const
 /* Embedded XML: Useful to extend the capabilities of the item */
 QString AbstractNodeWidget::getEmbeddedData() const
 {
-    return embeddedData;
+    return embeddedData.getText();
 }
 
 void AbstractNodeWidget::setEmbeddedData(const QString &embeddedData)
 {
-    this->embeddedData=embeddedData;
+    this->embeddedData.setText(embeddedData);
+    journalChange(ChangeJournal::CHANGE_RESTYLED);
 }
 
-void AbstractNodeWidget::moveToRandom()
+void AbstractNodeWidget::moveToRandom(SpatialIndex *siblings)
 {
-    auto parentSize = ((QWidget *)parent())->size();
+    QWidget * container = (QWidget *)parent();
+    auto parentSize = container->size();
     auto lsize = size();
-    // TODO: avoid overlap groups and intems...
 
-    int pVerticalOffset = parent()->objectName().startsWith("GROUP-")? ((AbstractNodeWidget *)parent())->getVerticalOffset() : 0;
+    int pVerticalOffset = container->objectName().startsWith("GROUP-")? ((AbstractNodeWidget *)container)->getVerticalOffset() : 0;
+    QRect area(0,pVerticalOffset,parentSize.width(),std::max(0,parentSize.height()-pVerticalOffset));
 
-    std::mt19937 rg{std::random_device{}()};
-    std::uniform_int_distribution<int> pickX(1, parentSize.width()-lsize.width());
-    std::uniform_int_distribution<int> pickY(1, parentSize.height()-lsize.height()-pVerticalOffset);
+    LayoutRandom * rg = GRAPH->getLayoutRandom();
+    int x = rg->bounded(area.left(), area.right()+1-lsize.width());
+    int y = rg->bounded(area.top(), area.bottom()+1-lsize.height());
+    QPoint nextPos(x,y);
 
-    for (int i=0;i<RANDOM_ITERS;i++)
+    if (!GRAPH->getAllowOverlap() && siblings)
     {
-        QPoint nextRelativePos = QPoint(pickX(rg),pickY(rg));
-
-        // TODO: Not enough space? extend the graphic...
-
-        if (moveRelative(nextRelativePos, i==RANDOM_ITERS-1))
-            break;
-
-        // If the nodes overflow the graphic, put in the place...
-        //  GraphWidget::checkAndFixChildrenPositions((QWidget *)parent(),pVerticalOffset);
+        // Placed one after another: this node is an obstacle for the next ones
+        nextPos = siblings->findFreePosition(lsize,nextPos,area);
+        siblings->insert(QRect(nextPos,lsize));
     }
-
-    toPaint = QRect(0,0,0,0);
-}
-
-bool AbstractNodeWidget::setNodeXMLLocalProperties(const QDomNode & master)
-{
-    QDomNode child = master.firstChild();
-    while (!child.isNull())
+    else if (!GRAPH->getAllowOverlap())
     {
-        if (child.toElement().tagName() == "id")
+        // Nearest free place to the random point (using the siblings as obstacles)
+        QList<AbstractNodeWidget *> nodes = GraphWidget::allChildrenItemsAndGroups(container);
+        QVector<QSize> sizes;
+        sizes.reserve(nodes.count());
+        for (auto sibling : nodes)
+            sizes.append(sibling->size());
+
+        SpatialIndex index(SpatialIndex::cellSizeFor(sizes));
+        for (auto sibling : nodes)
         {
-            QByteArray bArrayElement = QByteArray::fromBase64(QByteArray(child.toElement().text().toUtf8()));
-            setId(QString().fromUtf8(bArrayElement.data(),bArrayElement.size()));
-        }
-        else if (child.toElement().tagName() == "pos")
-        {
-            int x = child.toElement().attribute("x").toUInt();
-            int y = child.toElement().attribute("y").toUInt();
-            move(x,y);
-        }
-        else if (child.toElement().tagName() == "text")
-        {
-            QByteArray bArrayElement = QByteArray::fromBase64(QByteArray(child.toElement().text().toUtf8()));
-            text = QString().fromUtf8(bArrayElement.data(),bArrayElement.size());
-        }
-        else if (child.toElement().tagName() == "subText")
-        {
-            QByteArray bArrayElement = QByteArray::fromBase64(QByteArray(child.toElement().text().toUtf8()));
-            subText = QString().fromUtf8(bArrayElement.data(),bArrayElement.size());
-        }
-        else if (child.toElement().tagName() == "description")
-        {
-            QByteArray bArrayElement = QByteArray::fromBase64(QByteArray(child.toElement().text().toUtf8()));
-            description = QString().fromUtf8(bArrayElement.data(),bArrayElement.size());
-        }
-        else if (child.toElement().tagName() == "textFont")
-        {
-            QByteArray bArrayElement = QByteArray::fromBase64(QByteArray(child.toElement().text().toUtf8()));
-            textFont.fromString( QString().fromUtf8(bArrayElement.data(),bArrayElement.size()) );
-        }
-        else if (child.toElement().tagName() == "subTextFont")
-        {
-            QByteArray bArrayElement = QByteArray::fromBase64(QByteArray(child.toElement().text().toUtf8()));
-            subTextFont.fromString( QString().fromUtf8(bArrayElement.data(),bArrayElement.size()) );
-        }
-        else if (child.toElement().tagName() == "borderColor")
-        {
-            borderColor = XMLFunctions::colorFromXML(child);
-        }
-        else if (child.toElement().tagName() == "selectedBorderColor")
-        {
-            selectedBorderColor = XMLFunctions::colorFromXML(child);
-        }
-        else if (child.toElement().tagName() == "textColor")
-        {
-            textColor = XMLFunctions::colorFromXML(child);
-        }
-        else if (child.toElement().tagName() == "subTextColor")
-        {
-            subTextColor = XMLFunctions::colorFromXML(child);
-        }
-        else if (child.toElement().tagName() == "fillColor")
-        {
-            fillColor = XMLFunctions::colorFromXML(child);
-        }
-        else if (child.toElement().tagName() == "fillColor2")
-        {
-            fillColor2 = XMLFunctions::colorFromXML(child);
-        }
-        else if (child.toElement().tagName() == "fillMode")
-        {
-            fillMode = ((AbstractNodeWidget::ItemBoxFillMode)child.toElement().text().toUInt());
-        }
-        else if (child.toElement().tagName() == "borderRoundRectPixels")
-        {
-            borderRoundRectPixels = child.toElement().text().toUInt();
-        }
-        else if (child.toElement().tagName() == "anchored")
-        {
-            anchored = child.toElement().text().toUInt()==1?true:false;
-        }
-        else
-        {
-            setXMLLocalProperties(child);
+            if (sibling!=this)
+                index.insert(sibling->geometry());
         }
 
-        child = child.nextSibling();
+        nextPos = index.findFreePosition(lsize,nextPos,area);
     }
 
-    return true;
+    move(nextPos);
+
+    toPaint = QRect(0,0,0,0);
 }
 
 const QColor &AbstractNodeWidget::getFillColor2() const
@@ -495,6 +527,7 @@ const QColor &AbstractNodeWidget::getFillColor2() const
 void AbstractNodeWidget::setFillColor2(const QColor &newFillColor2)
 {
     fillColor2 = newFillColor2;
+    journalChange(ChangeJournal::CHANGE_RESTYLED);
 }
 
 int AbstractNodeWidget::getVerticalOffset() const
@@ -568,6 +601,26 @@ void AbstractNodeWidget::focusOutEvent(QFocusEvent *)
     update();
 }
 
+void AbstractNodeWidget::moveEvent(QMoveEvent *)
+{
+    journalChange(ChangeJournal::CHANGE_MOVED);
+    GRAPH->getEdgeRouter()->markNode(this);
+}
+
+void AbstractNodeWidget::resizeEvent(QResizeEvent *)
+{
+    GRAPH->getEdgeRouter()->markNode(this);
+
+    // Only the group sizes are saved (the items are sized by their contents)
+    if (objectName().startsWith("GROUP-"))
+        journalChange(ChangeJournal::CHANGE_MOVED);
+}
+
+void AbstractNodeWidget::journalChange(ChangeJournal::Change change)
+{
+    GRAPH->getChangeJournal()->markNode(this,change);
+}
+
 void AbstractNodeWidget::grabPositionOffset(const QPoint & offset)
 {
     absOffset = getAbsolutePos();
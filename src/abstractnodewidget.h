@@ -7,8 +7,14 @@
 #include <QSize>
 #include <QPoint>
 #include <QList>
-#include <QDomDocument>
-#include <QDomElement>
+#include <QXmlStreamWriter>
+#include <QXmlStreamReader>
+
+#include "nodedescriptor.h"
+#include "encodedtext.h"
+#include "icontable.h"
+#include "changejournal.h"
+#include "sortkeys.h"
 
 #define PI 3.14159265
 
@@ -21,6 +27,8 @@
 namespace QNodeGraph
 {
 
+class SpatialIndex;
+
 class AbstractNodeWidget : public QWidget
 {
     Q_OBJECT
@@ -29,12 +37,6 @@ public:
 
     /////////////////////////////////////////////////////////////////////
     // INIT:
-    /**
-     * @brief AbstractNodeWidget Constructor
-     * @param parent parent container
-     * @param xml XML to initialize
-     */
-    AbstractNodeWidget(QWidget *parent, const QString &xml, const QString & type);
     /**
      * @brief AbstractNodeWidget Constructor
      * @param id node ID
@@ -101,6 +103,13 @@ public:
      * @return node subtext
      */
     QString getSubText() const;
+    /**
+     * @brief getSortKey Get the sort key of the ID, text or subtext (cached while the value does not change)
+     * @param field field to sort by
+     * @param natural compare the numbers by value ("host2" before "host10")
+     * @return normalized byte key
+     */
+    QByteArray getSortKey(SortKeys::Field field, bool natural) const;
     /**
      * @brief setTextColor Set Text Color
      * @param textColor Text Color
@@ -128,6 +137,11 @@ public:
      * @param description description
      */
     void setDescription(const QString &description);
+    /**
+     * @brief getDescription Get Description
+     * @return description
+     */
+    QString getDescription() const;
 
     /////////////////////////////////////////////////////////////////////
     // DECORATION:
@@ -225,8 +239,10 @@ public:
 
     /**
      * @brief moveToRandom Move this element to a random point of the graphic.
+     * @param siblings index of the nodes of the container shared by a bulk insert (this node is added to it),
+     *                 or nullptr to index the siblings now
      */
-    void moveToRandom();
+    void moveToRandom(SpatialIndex * siblings = nullptr);
     /**
      * @brief setAnchor Anchor the node position in the graph
      * @param x true to anchor
@@ -246,12 +262,39 @@ public:
      * @return XML structure with all the node properties.
      */
     QString getXML(const QString &widgetName, bool xmltag=false);
+    /**
+     * @brief writeXML Write the XML of this object into a stream writer
+     * @param xml XML writer
+     * @param widgetName element name (eg. ItemWidget, GroupWidget)
+     * @param icons document icon table (the icons are referenced by key), or nullptr to write the icons inline
+     * @param contents write the group items or the item links (false when they are stored apart)
+     */
+    void writeXML(QXmlStreamWriter & xml, const QString &widgetName, IconTable * icons = nullptr, bool contents = true);
     /**
      * @brief setXML Setup this node from an XML
+     * @param widgetName element name (eg. ItemWidget, GroupWidget)
      * @param xml XML with the node data
      * @return true if succeed, false otherwise
      */
     bool setXML(const QString &widgetName, const QString &xml);
+    /**
+     * @brief readXML Setup this node from a XML stream reader (single pass, the element is not parsed again)
+     * @param xml XML reader positioned at the node start element (it is left after the end element)
+     * @param icons document icon table (to resolve the icon keys), or nullptr
+     * @return true if succeed, false otherwise
+     */
+    bool readXML(QXmlStreamReader & xml, IconTable * icons = nullptr);
+    /**
+     * @brief setNodeDescriptor Set the properties found in a node descriptor
+     * @param node node descriptor
+     * @param icons document icon table (to resolve the icon keys), or nullptr
+     */
+    void setNodeDescriptor(const NodeDescriptor & node, IconTable * icons = nullptr);
+    /**
+     * @brief getNodeDescriptor Get the node properties as a node descriptor (the icon is not included, see ItemWidget::getIcon)
+     * @param node output descriptor
+     */
+    void getNodeDescriptor(NodeDescriptor * node) const;
     /**
      * @brief getEmbeddedData Get embedded data
      * @return embedded data
@@ -293,17 +336,22 @@ public:
 
 protected:
     // XML SET/GET
-    bool setNodeXMLLocalProperties(const QDomNode &master);
-
-    virtual QString getXMLLocal()=0;
-    virtual QString getXMLLocalProperties()=0;
+    virtual void writeXMLLocal(QXmlStreamWriter & xml, IconTable * icons)=0;
+    virtual void writeXMLLocalProperties(QXmlStreamWriter & xml, IconTable * icons)=0;
 
-    virtual bool setXMLLocalProperties(const QDomNode & child)=0;
-    virtual bool setXMLLocal(const QDomNode & child)=0;
+    virtual bool readXMLLocal(QXmlStreamReader & xml, IconTable * icons)=0;
+    virtual void setNodeDescriptorLocal(const NodeDescriptor & node, IconTable * icons)=0;
+    virtual void getNodeDescriptorLocal(NodeDescriptor * node) const=0;
 
     virtual void recalculateSize()=0;
     virtual void setInternalObjectID()=0;
 
+    /**
+     * @brief journalChange Mark the node as changed in the graph change journal (see ChangeJournal)
+     * @param change change
+     */
+    void journalChange(ChangeJournal::Change change);
+
     // Parent
     QWidget * nodeGraphParent, *groupParent;
 
@@ -312,7 +360,13 @@ protected:
 
     int borderRoundRectPixels;
 
-    QString id, text, subText, description, embeddedData;
+    QString id, text, subText;
+    // Decoded on the first use (and saved as read while not modified)
+    EncodedText description, embeddedData;
+
+    // Sort keys cache (by field and natural mode) and the value used to make each key
+    mutable QString sortKeySources[6];
+    mutable QByteArray sortKeys[6];
     QFont textFont, subTextFont;
     AbstractNodeWidget::ItemBoxFillMode fillMode;
 
@@ -358,6 +412,8 @@ protected slots:
     virtual void keyPressEvent ( QKeyEvent * event );
     virtual void keyReleaseEvent ( QKeyEvent * event );
     virtual void focusOutEvent ( QFocusEvent * ) ;
+    virtual void moveEvent ( QMoveEvent * event );
+    virtual void resizeEvent ( QResizeEvent * event );
 
 signals:
     // Double click over element (check if are node item or group)
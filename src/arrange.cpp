@@ -2,9 +2,19 @@
 #include "graphwidget.h"
 #include "groupwidget.h"
 #include "itemwidget.h"
+#include "layoutcache.h"
+#include "layoutgraph.h"
+#include "multilevellayout.h"
+#include "parallel.h"
+#include "slotallocator.h"
+#include "sortkeys.h"
+#include "spatialindex.h"
+#include "stresslayout.h"
+#include "layoutrandom.h"
 
 #include <QDebug>
 #include <cmath>
+#include <algorithm>
 
 using namespace QNodeGraph;
 
@@ -14,6 +24,10 @@ Arrange::Arrange()
 
 int Arrange::triggerAutoArrange(QWidget *v)
 {
+    // Arranged once when the load ends
+    if (getGraph(v)->getLoading())
+        return -100; // NOT USED.
+
     Mode arrangeMode;
     SortBy sortBy;
     int spacing=0;
@@ -29,14 +43,14 @@ bool Arrange::getAutoArrange(QWidget *v, Mode *mode, SortBy * sortBy, int * spac
     if (v->objectName().startsWith("GROUP-"))
     {
         *mode = (Mode) ((GroupWidget *)v)->getAutoArrangeAlgorithm();
-        *sortBy = (SortBy) ((GroupWidget *)v)->getAutoArrangeAlgorithm();
+        *sortBy = (SortBy) ((GroupWidget *)v)->getSortBy();
         *spacing = ((GroupWidget *)v)->getAutoArrangeSpacing();
         return ((GroupWidget *)v)->getAutoArrange();
     }
     else
     {
         *mode = (Mode) ((GraphWidget *)v)->getAutoArrangeAlgorithm();
-        *sortBy = (SortBy) ((GraphWidget *)v)->getAutoArrangeAlgorithm();
+        *sortBy = (SortBy) ((GraphWidget *)v)->getSortBy();
         *spacing = ((GraphWidget *)v)->getAutoArrangeSpacing();
         return ((GraphWidget *)v)->getAutoArrange();
     }
@@ -44,78 +58,380 @@ bool Arrange::getAutoArrange(QWidget *v, Mode *mode, SortBy * sortBy, int * spac
     return false;
 }
 
-void Arrange::resetAllLayerAndSortPositionInfo(QWidget *v)
+bool Arrange::getAutoArrangeIncremental(QWidget *v)
 {
-    for (auto i : GraphWidget::allChildrenItems(v))
+    if (v->objectName().startsWith("GROUP-"))
+        return ((GroupWidget *)v)->getAutoArrangeIncremental();
+    else
+        return ((GraphWidget *)v)->getAutoArrangeIncremental();
+}
+
+bool Arrange::getAutoArrangeByComponents(QWidget *v)
+{
+    if (v->objectName().startsWith("GROUP-"))
+        return ((GroupWidget *)v)->getAutoArrangeByComponents();
+    else
+        return ((GraphWidget *)v)->getAutoArrangeByComponents();
+}
+
+void Arrange::setIncrementalCount(QWidget *v, int count)
+{
+    if (v->objectName().startsWith("GROUP-"))
+        ((GroupWidget *)v)->setAutoArrangeIncrementalCount(count);
+    else
+        ((GraphWidget *)v)->setAutoArrangeIncrementalCount(count);
+}
+
+void Arrange::countChildNode(QWidget *v, int delta)
+{
+    if (v->objectName().startsWith("GROUP-"))
+        ((GroupWidget *)v)->setChildNodesCount( ((GroupWidget *)v)->getChildNodesCount()+delta );
+    else
+        ((GraphWidget *)v)->setChildNodesCount( ((GraphWidget *)v)->getChildNodesCount()+delta );
+}
+
+bool Arrange::relayoutThresholdCrossed(QWidget *v)
+{
+    int count, threshold, nodesCount;
+    if (v->objectName().startsWith("GROUP-"))
+    {
+        count = ((GroupWidget *)v)->getAutoArrangeIncrementalCount()+1;
+        threshold = ((GroupWidget *)v)->getAutoArrangeRelayoutThreshold();
+        nodesCount = ((GroupWidget *)v)->getChildNodesCount();
+    }
+    else
     {
-        i->setLayer(-1);
-        i->setSortPosition(-1);
+        count = ((GraphWidget *)v)->getAutoArrangeIncrementalCount()+1;
+        threshold = ((GraphWidget *)v)->getAutoArrangeRelayoutThreshold();
+        nodesCount = ((GraphWidget *)v)->getChildNodesCount();
     }
+    setIncrementalCount(v,count);
+
+    // Percentage of the nodes that were placed without the full algorithm
+    return (count*100) > (threshold*std::max(1,nodesCount));
 }
 
-ItemWidget *Arrange::getUnarrangedItemWithMaxLinks(QWidget *v)
+bool Arrange::isFreeArea(QWidget *v, const QRect &r, const SpatialIndex &siblings)
 {
-    ItemWidget * element = nullptr;
+    int pVerticalOffset = v->objectName().startsWith("GROUP-")? ((AbstractNodeWidget *)v)->getVerticalOffset() : 0;
+
+    if (r.x()<0 || r.y()<pVerticalOffset || r.x()+r.width()>v->size().width() || r.y()+r.height()>v->size().height())
+        return false;
+
+    return !siblings.intersects(r);
+}
 
-    for (auto item1 : GraphWidget::allChildrenItems(v))
+SpatialIndex Arrange::siblingsIndex(QWidget *v, AbstractNodeWidget *self)
+{
+    QList<AbstractNodeWidget *> nodes = GraphWidget::allChildrenItemsAndGroups(v);
+    QVector<QSize> sizes;
+    sizes.reserve(nodes.count());
+    for (auto node : nodes)
+        sizes.append(node->size());
+
+    SpatialIndex index(SpatialIndex::cellSizeFor(sizes));
+    for (auto node : nodes)
     {
-        ItemWidget * item2 = element;
+        if (node!=self)
+            index.insert(node->geometry());
+    }
+    return index;
+}
 
-        if (item1->getLayer()==-1)
-        {
-            if (element==nullptr)
-                element = item1;
+int Arrange::triggerAutoArrangeOnNewItem(QWidget *v, ItemWidget *item)
+{
+    // Arranged once when the load ends
+    if (getGraph(v)->getLoading())
+        return -100; // NOT USED.
 
-            else if ( item1->getLinks().count() > item2->getLinks().count() )
-            {
-                element = item1;
-            }
-        }
+    Mode arrangeMode;
+    SortBy sortBy;
+    int spacing=0;
+    if (!getAutoArrange(v,&arrangeMode,&sortBy, &spacing))
+        return -100; // NOT USED.
+
+    if (!getAutoArrangeIncremental(v) || (QWidget *)item->parent()!=v)
+        return arrange(v,spacing,arrangeMode,sortBy);
+
+    // Sorted rows/columns can't take the new item at the end without breaking the order.
+    if (sortBy!=SORTBY_INSERT_POS && (arrangeMode==ARRANGEALG_ROWS || arrangeMode==ARRANGEALG_COLUMNS))
+        return arrange(v,spacing,arrangeMode,sortBy);
+
+    if (relayoutThresholdCrossed(v) || placeIncremental(v,item,nullptr,arrangeMode,spacing)!=0)
+        return arrange(v,spacing,arrangeMode,sortBy);
+
+    return 0;
+}
+
+int Arrange::triggerAutoArrangeOnNewLink(QWidget *v, ItemWidget *item1, ItemWidget *item2)
+{
+    // Arranged once when the load ends
+    if (getGraph(v)->getLoading())
+        return -100; // NOT USED.
+
+    Mode arrangeMode;
+    SortBy sortBy;
+    int spacing=0;
+    if (!getAutoArrange(v,&arrangeMode,&sortBy, &spacing))
+        return -100; // NOT USED.
+
+    if (!getAutoArrangeIncremental(v))
+        return arrange(v,spacing,arrangeMode,sortBy);
+
+    // Links are not part of the rows/columns/random placement.
+    if (arrangeMode!=ARRANGEALG_HTREE && arrangeMode!=ARRANGEALG_VTREE && arrangeMode!=ARRANGEALG_STAR)
+        return 0;
+
+    // The new leaf (linked only to the other item) goes next to the already placed item.
+    ItemWidget * leaf = nullptr, * placedItem = nullptr;
+    if (item2->getLinksCount()==1 && item1->getLayer()>=0)
+    {
+        leaf = item2;
+        placedItem = item1;
+    }
+    else if (item1->getLinksCount()==1 && item2->getLayer()>=0)
+    {
+        leaf = item1;
+        placedItem = item2;
     }
 
-    return element;
+    if (relayoutThresholdCrossed(v))
+        return arrange(v,spacing,arrangeMode,sortBy);
+
+    // Link between already placed items (or different containers), keep the current layout until the threshold is crossed.
+    if (!leaf || leaf->parent()!=placedItem->parent())
+        return 0;
+
+    if (placeIncremental((QWidget *)leaf->parent(),leaf,placedItem,arrangeMode,spacing)!=0)
+        return arrange(v,spacing,arrangeMode,sortBy);
+
+    return 0;
 }
 
-void Arrange::assignLayerToItemsRecursively(QList<ItemWidget *> layerZeroItems)
+bool Arrange::isGraphMode(Mode mode)
 {
-    for ( auto r0item :  layerZeroItems )
+    switch (mode)
     {
-        r0item->assignLayerRecursively(0);
+    case ARRANGEALG_HTREE:
+    case ARRANGEALG_VTREE:
+    case ARRANGEALG_STAR:
+    case ARRANGEALG_MULTILEVEL:
+    case ARRANGEALG_STRESS:
+        return true;
+    default:
+        return false;
     }
 }
 
-QList<ItemWidget *> Arrange::getLayerZeroItems(QWidget *v)
+int Arrange::layoutGraph(LayoutGraph *graph, Mode mode)
 {
-    QList<ItemWidget *> layerZeroItems;
+    switch (mode)
+    {
+    case ARRANGEALG_HTREE:
+    case ARRANGEALG_VTREE:
+    case ARRANGEALG_STAR:
+        return layeredLayout(graph,getLayerZeroItems(*graph),mode);
+    case ARRANGEALG_MULTILEVEL:
+        return MultilevelLayout::layout(graph);
+    case ARRANGEALG_STRESS:
+        return StressLayout::layout(graph);
+    default:
+        return -1;
+    }
+}
 
-    bool automatic = true;
+int Arrange::arrange(QWidget *v, int spacing, Mode mode, SortBy sortBy)
+{
+    // Full layout, start counting the incremental placements again
+    setIncrementalCount(v,0);
+
+    // The randomized algorithms give a different result each time
+    if (mode==ARRANGEALG_RANDOM || mode==ARRANGEALG_STRATIFIED)
+        return runArrange(v,spacing,mode,sortBy);
+
+    // Nothing changed since a previous arrange: reuse his result
+    LayoutCache * cache = getGraph(v)->getLayoutCache();
+    quint64 key = LayoutCache::fingerprint(v,mode,sortBy,spacing,getAutoArrangeByComponents(v));
+    if (cache->restore(v,key,mode))
+        return 0;
+
+    int r = runArrange(v,spacing,mode,sortBy);
+    if (r==0)
+        cache->store(v,key,mode);
+    return r;
+}
 
-    for (auto item : GraphWidget::allChildrenItems(v))
+int Arrange::arrangeByComponents(QWidget *v, int spacing, Mode mode)
+{
+    if (!isGraphMode(mode))
+        return -1;
+
+    LayoutGraph graph = LayoutGraph::fromContainer(v);
+    LayoutComponents components = graph.findComponents();
+    int componentsCount = components.roots.count();
+
+    if (componentsCount<=1)
     {
-        if (item->getBelongsToLayerZero())
-        {
-            automatic = false;
-            layerZeroItems += item;
-            item->assignLayerRecursively(0);
-        }
+        int r = layoutGraph(&graph,mode);
+        if (r==0)
+            graph.apply();
+        return r;
     }
 
-    if (automatic)
+    QVector<QVector<int>> members(componentsCount);
+    for (int i=0; i<graph.count(); i++)
+        members[components.membership[i]].append(i);
+
+    // Biggest components first, so they don't end up being the last task
+    QVector<int> order(componentsCount);
+    for (int c=0; c<componentsCount; c++)
+        order[c] = c;
+    std::stable_sort(order.begin(),order.end(), [&members](int a, int b) -> bool { return members[a].count() > members[b].count(); });
+
+    // Arrange each component in his own area (in parallel)
+    QVector<LayoutGraph> parts(componentsCount);
+    QVector<int> results(componentsCount,0);
+    QVector<QRect> boxes(componentsCount);
+    LayoutGraph * partsData = parts.data();
+    int * resultsData = results.data();
+    QRect * boxesData = boxes.data();
+    const LayoutGraph & sourceGraph = graph;
+    const QVector<QVector<int>> & sourceMembers = members;
+    const QVector<int> & sourceOrder = order;
+
+    Parallel::forEach(componentsCount, [&](int i) {
+        int c = sourceOrder[i];
+        LayoutGraph & part = partsData[c];
+        part = sourceGraph.subGraph(sourceMembers[c]);
+        part.area = componentArea(part,sourceGraph.area,spacing,mode);
+        part.verticalOffset = 0;
+        resultsData[c] = layoutGraph(&part,mode);
+
+        QRect box;
+        for (int k=0; k<part.count(); k++)
+            box |= QRect(part.positions[k],part.sizes[k]);
+        boxesData[c] = box;
+    });
+
+    for (int c=0; c<componentsCount; c++)
     {
-        // Set arrange layer to -1 for everyone:
-        resetAllLayerAndSortPositionInfo(v);
+        if (results[c]!=0)
+            return results[c];
+    }
+
+    // Pack the components into the container
+    QVector<QSize> boxSizes(componentsCount);
+    for (int c=0; c<componentsCount; c++)
+        boxSizes[c] = boxes[c].size();
+
+    QSize packedSize;
+    QVector<QPoint> origins = packShelves(boxSizes,graph.area.width(),spacing,&packedSize);
 
-        ItemWidget * item;
-        while ((item=getUnarrangedItemWithMaxLinks(v)))
+    graph.layers.fill(-1,graph.count());
+    graph.sortPositions.fill(-1,graph.count());
+    for (int c=0; c<componentsCount; c++)
+    {
+        QPoint translation = origins[c] - boxes[c].topLeft() + QPoint(0,graph.verticalOffset);
+        for (int k=0; k<members[c].count(); k++)
         {
-            item->assignLayerRecursively(0);
+            int node = members[c][k];
+            graph.positions[node] = parts[c].positions[k] + translation;
+            graph.layers[node] = parts[c].layers.value(k,-1);
+            graph.sortPositions[node] = parts[c].sortPositions.value(k,-1);
         }
+    }
+
+    // Expand the container if the components does not fit
+    if (graph.verticalOffset+packedSize.height()>v->size().height())
+        v->resize(v->size().width(),graph.verticalOffset+packedSize.height());
+
+    graph.apply();
+
+    return 0;
+}
+
+QSize Arrange::componentArea(const LayoutGraph &graph, const QSize &area, int spacing, Mode mode)
+{
+    // The layered algorithms spread the items, reserve about three times the space used by the items
+    double itemsArea = 0;
+    int maxWidth = 0, maxHeight = 0;
+    for (int i=0; i<graph.count(); i++)
+    {
+        itemsArea += 3.0 * (graph.sizes[i].width()+(spacing*2)) * (graph.sizes[i].height()+(spacing*2));
+        maxWidth = std::max(maxWidth,graph.sizes[i].width()+(spacing*2));
+        maxHeight = std::max(maxHeight,graph.sizes[i].height()+(spacing*2));
+    }
+
+    // Keep the aspect ratio of the container
+    double aspect = area.height()>0 ? ((double)area.width())/area.height() : 1;
+    int width = std::sqrt(itemsArea*aspect);
+    int height = aspect>0 ? width/aspect : width;
+
+    // The star reserves 100px of margin
+    if (mode==ARRANGEALG_STAR)
+    {
+        width+=100;
+        height+=100;
+    }
+
+    width = std::min(std::max(width,maxWidth),std::max(area.width(),maxWidth));
+    height = std::min(std::max(height,maxHeight),std::max(area.height(),maxHeight));
+
+    return QSize(width,height);
+}
+
+QVector<QPoint> Arrange::packShelves(const QVector<QSize> &boxes, int width, int spacing, QSize *packedSize)
+{
+    QVector<int> order(boxes.count());
+    for (int i=0; i<boxes.count(); i++)
+        order[i] = i;
+    std::stable_sort(order.begin(),order.end(), [&boxes](int a, int b) -> bool { return boxes[a].height() > boxes[b].height(); });
 
-        for (auto chItem : GraphWidget::allChildrenItems(v))
+    // Shelves (y, height and next free x), the first box of a shelf sets his height
+    QVector<QPoint> origins(boxes.count());
+    QVector<int> shelfY, shelfHeight, shelfX;
+    int usedWidth = 0;
+
+    for (int i : order)
+    {
+        // First shelf with room for the box (the boxes are sorted by height, so they always fit in height)
+        int shelf = 0;
+        while (shelf<shelfX.count() && shelfX[shelf]+boxes[i].width()+spacing>width)
+            shelf++;
+
+        // Next shelf
+        if (shelf==shelfX.count())
         {
-            if (chItem->getLayer()==0)
-                layerZeroItems.append(chItem);
+            shelfY.append(shelf? shelfY[shelf-1]+shelfHeight[shelf-1]+spacing : spacing);
+            shelfHeight.append(boxes[i].height());
+            shelfX.append(spacing);
         }
+
+        origins[i] = QPoint(shelfX[shelf],shelfY[shelf]);
+        shelfX[shelf]+=boxes[i].width()+spacing;
+        usedWidth = std::max(usedWidth,shelfX[shelf]);
+    }
+
+    int shelves = shelfY.count();
+    *packedSize = QSize(usedWidth, shelves? shelfY[shelves-1]+shelfHeight[shelves-1]+spacing : spacing);
+    return origins;
+}
+
+QVector<int> Arrange::getLayerZeroItems(const LayoutGraph &graph)
+{
+    QVector<int> layerZeroItems;
+
+    for (int i=0; i<graph.count(); i++)
+    {
+        if (graph.layerZero[i])
+            layerZeroItems.append(i);
+    }
+
+    if (layerZeroItems.isEmpty())
+    {
+        // One root per connected component (the item with more links)
+        layerZeroItems = graph.findComponents().roots;
+        std::sort(layerZeroItems.begin(),layerZeroItems.end());
     }
 
     return layerZeroItems;
@@ -134,197 +450,324 @@ int Arrange::getLayerCount(QWidget *v)
     return layerCount;
 }
 
-QList<ItemWidget *> Arrange::getItemsFromLayer(QWidget *v, int layer)
+int Arrange::horizontalTree(QWidget *v)
 {
-    QList<ItemWidget *> items;
-
-    for (auto item : GraphWidget::allChildrenItems(v))
-    {
-        if (item->getLayer()==layer)
-            items.append(item);
-    }
+    return arrangeGraph(v,ARRANGEALG_HTREE);
+}
 
-    return items;
+int Arrange::verticalTree(QWidget *v)
+{
+    return arrangeGraph(v,ARRANGEALG_VTREE);
 }
 
-int Arrange::horizontalTree(QWidget *v, QList<ItemWidget *> layerZero)
+int Arrange::star(QWidget *v)
 {
-    resetAllLayerAndSortPositionInfo(v); // Set sorting layer to -1 for everyone
-    assignLayerToItemsRecursively(layerZero);
+    return arrangeGraph(v,ARRANGEALG_STAR);
+}
 
-    int layerCount = getLayerCount(v);
-    int prevLayerItemsCount = -1;
+int Arrange::arrangeGraph(QWidget *v, Mode mode)
+{
+    LayoutGraph graph = LayoutGraph::fromContainer(v);
 
-    // Determine horizontal spacing
-    int horizontalSpacing = v->size().width()/(layerCount+1);
+    int r = layoutGraph(&graph,mode);
+    if (r==0)
+        graph.apply();
+    return r;
+}
 
-    for (int layer=0; layer<layerCount; layer++)
+int Arrange::hierarchical(QWidget *v, int spacing)
+{
+    // Containers by depth: the container, his groups, the groups of his groups...
+    QVector<QList<QWidget *>> depths;
+    depths.append(QList<QWidget *>() << v);
+    for (;;)
     {
-        // Setup each layer.
-        QList<ItemWidget *> layerItems = getItemsFromLayer(v,layer);
-
-        // Determine how many slots there are in the layer
-        int layerSlots = layerItems.count();
-        if (prevLayerItemsCount>0 && layerItems.count()<=prevLayerItemsCount)
-            layerSlots = prevLayerItemsCount+1;
-
-        // Determine vertical spacing
-        int verticalSpacing = v->size().height()/(layerSlots+1);
-
-        // Configure weight for each element
-        for ( int i = 0; i < layerItems.size(); i++ )
+        QList<QWidget *> next;
+        for (auto container : depths.last())
         {
-            ItemWidget * item = layerItems[i];
+            for (auto group : GraphWidget::allChildrenGroups(container))
+                next.append(group);
+        }
+        if (next.isEmpty())
+            break;
+        depths.append(next);
+    }
 
-            if (layer==0)
-                // Configure original weightiness for layer 0
-                item->setSortPosition( (i+1)*(verticalSpacing) );
-            else
-                // Determine weightiness for layer >1
-                item->calcSortPosition();
+    // Deepest groups first, so every group has his final size when his container is arranged
+    for (int d=depths.count()-1; d>=1; d--)
+    {
+        const QList<QWidget *> & groups = depths[d];
+        int count = groups.count();
+
+        QVector<LayoutGraph> graphs(count);
+        QVector<Mode> modes(count);
+        QVector<int> spacings(count), results(count,0);
+        QVector<QSize> sizes(count);
+        QVector<bool> arranged(count);
+        for (int i=0; i<count; i++)
+        {
+            SortBy sortBy;
+            // Groups with auto arrange disabled keep their contents, and are placed with their current size
+            arranged[i] = getAutoArrange(groups[i],&modes[i],&sortBy,&spacings[i]);
+            if (arranged[i])
+                graphs[i] = LayoutGraph::fromHierarchy(groups[i]);
         }
 
-        // Sorted items...
-        QVector<ItemWidget *> layerSortedSlots(layerSlots);
-        // nullptr-Initialize vector
-        for ( int i = 0; i < layerSlots; i++ )
+        // Groups are independent, arrange their contents in parallel
+        LayoutGraph * graphsData = graphs.data();
+        const Mode * modesData = modes.constData();
+        const int * spacingsData = spacings.constData();
+        const bool * arrangedData = arranged.constData();
+        int * resultsData = results.data();
+        QSize * sizesData = sizes.data();
+        Parallel::forEach(count, [=](int i) {
+            if (arrangedData[i])
+                resultsData[i] = groupLayout(&graphsData[i],modesData[i],spacingsData[i],&sizesData[i]);
+        });
+
+        for (int i=0; i<count; i++)
         {
-            layerSortedSlots[i]=nullptr;
+            if (results[i]!=0)
+                return results[i];
         }
 
-        // Fill slots with items
-        for ( int i = 0; i < layerItems.size(); i++ )
+        for (int i=0; i<count; i++)
         {
-            ItemWidget * item = layerItems[i];
+            if (!arranged[i])
+                continue;
+            graphs[i].apply();
+            groups[i]->resize(sizes[i]);
+            removeOverlaps(groups[i],spacings[i]);
+        }
+    }
 
-            int bestPosition = (item->getSortPosition()/verticalSpacing)-1;
+    // Top level: items and groups placed by the links between them (aggregated by group)
+    LayoutGraph graph = LayoutGraph::fromHierarchy(v);
+    int r = layoutGraph(&graph,ARRANGEALG_MULTILEVEL);
+    if (r!=0)
+        return r;
+    graph.apply();
 
-            // bestPosition is an heuristic, therefore, adjust into his borders
-            if (bestPosition>=layerSlots)
-                bestPosition = layerSlots-1;
-            if (bestPosition<0)
-                bestPosition = 0;
+    return removeOverlaps(v,spacing);
+}
 
-            // Fit
-            int diff_p = 0, diff_m = 0;
-            while ( layerSortedSlots[bestPosition+diff_p] && layerSortedSlots[bestPosition-diff_m] )
-            {
-                if (bestPosition-diff_m>0)
-                    diff_m++;
-                if (bestPosition+diff_p<(layerSlots-1))
-                    diff_p++;
-            }
-            if (layerSortedSlots[bestPosition-diff_m]==nullptr)
-                bestPosition = bestPosition-diff_m;
-            else if (layerSortedSlots[bestPosition+diff_p]==nullptr)
-                bestPosition = bestPosition+diff_p;
+int Arrange::groupLayout(LayoutGraph *graph, Mode mode, int spacing, QSize *size)
+{
+    if (!graph->count())
+    {
+        *size = graph->area;
+        return 0;
+    }
+
+    // The group grows to fit the contents: keep his aspect ratio, but don't limit the area
+    int titleHeight = graph->verticalOffset;
+    graph->area = componentArea(*graph,graph->area*16,spacing,mode);
+    graph->verticalOffset = 0;
+
+    if (isGraphMode(mode))
+    {
+        int r = layoutGraph(graph,mode);
+        if (r!=0)
+            return r;
+    }
+    else
+    {
+        // Rows, columns, random... are placed on shelves
+        QSize packedSize;
+        graph->positions = packShelves(graph->sizes,graph->area.width(),spacing,&packedSize);
+    }
+
+    // Move the contents below the title, with the spacing as margin
+    QRect box;
+    for (int i=0; i<graph->count(); i++)
+        box |= QRect(graph->positions[i],graph->sizes[i]);
+
+    QPoint translation = QPoint(spacing,titleHeight+spacing) - box.topLeft();
+    for (int i=0; i<graph->count(); i++)
+        graph->positions[i] += translation;
 
-            // Final best position
-            layerSortedSlots[bestPosition] = item;
+    *size = QSize(box.width()+(spacing*2), titleHeight+box.height()+(spacing*2));
+    return 0;
+}
+
+int Arrange::assignLayers(LayoutGraph *graph, const QVector<int> &roots)
+{
+    int n = graph->count();
+    graph->layers.fill(-1,n);
+    graph->sortPositions.fill(-1,n);
+
+    // Breadth first from every layer zero item (items marked for layer zero only accept the layer zero)
+    QVector<int> queue;
+    queue.reserve(n);
+    for (int root : roots)
+    {
+        if (graph->layers[root]==-1)
+        {
+            graph->layers[root] = 0;
+            queue.append(root);
         }
+    }
 
-        // The final move
-        for ( int i = 0; i < layerSlots; i++ )
+    int layerCount = queue.isEmpty()? 0 : 1;
+    for (int head=0; head<queue.count(); head++)
+    {
+        int node = queue[head];
+        int nextLayer = graph->layers[node]+1;
+
+        for (int i=0; i<graph->degree(node); i++)
         {
-            ItemWidget * item = layerSortedSlots[i];
-            if (item)
+            int next = graph->neighbour(node,i);
+            if (graph->layers[next]==-1 && !graph->layerZero[next])
             {
-                item->setSortPosition(verticalSpacing*(i+1));
-                if (!item->getAnchor())
-                    item->move(horizontalSpacing*(layer+1) - (item->size().width()/2) , verticalSpacing*(i+1));
+                graph->layers[next] = nextLayer;
+                layerCount = std::max(layerCount,nextLayer+1);
+                queue.append(next);
             }
         }
-
-        prevLayerItemsCount = layerItems.count();
     }
-    return 0;
+
+    return layerCount;
 }
 
-int Arrange::verticalTree(QWidget *v, QList<ItemWidget *> layerZero)
+int Arrange::layeredLayout(LayoutGraph *graph, const QVector<int> &roots, Mode mode)
 {
-    resetAllLayerAndSortPositionInfo(v); // Set sorting layer to -1 for everyone
-    assignLayerToItemsRecursively(layerZero);
+    int layerCount = assignLayers(graph,roots);
 
-    int layerCount = getLayerCount(v);
-    int prevLayerItemsCount = -1;
+    if (mode==ARRANGEALG_STAR && !layerCount)
+        return -1;
+
+    int width = graph->area.width();
+    int height = graph->area.height();
+
+    // Bucket the nodes by layer (keeping the container order)
+    QVector<QVector<int>> layerNodes(layerCount);
+    for (int i=0; i<graph->count(); i++)
+    {
+        if (graph->layers[i]>=0)
+            layerNodes[graph->layers[i]].append(i);
+    }
+
+    // Determine the spacing between layers
+    int layerSpacing;
+    switch (mode)
+    {
+    case ARRANGEALG_HTREE:
+        layerSpacing = width/(layerCount+1);
+        break;
+    case ARRANGEALG_VTREE:
+        layerSpacing = height/(layerCount+1);
+        break;
+    default:
+    case ARRANGEALG_STAR:
+        layerSpacing = (width>height ? height-100 : width-100 ) / (layerCount);
+        break;
+    }
 
-    // Determine horizontal spacing
-    int verticalSpacing = v->size().height()/(layerCount+1);
+    int prevLayerItemsCount = -1;
 
     for (int layer=0; layer<layerCount; layer++)
     {
-        // Setup each layer.
-        QList<ItemWidget *> layerItems = getItemsFromLayer(v,layer);
+        const QVector<int> & layerItems = layerNodes[layer];
 
         // Determine how many slots there are in the layer
         int layerSlots = layerItems.count();
         if (prevLayerItemsCount>0 && layerItems.count()<=prevLayerItemsCount)
             layerSlots = prevLayerItemsCount+1;
 
-        // Determine horiz spacing
-        int horizontalSpacing = v->size().width()/(layerSlots+1);
+        // Determine the spacing between slots (pixels for trees, degrees for the star)
+        double slotSpacing;
+        switch (mode)
+        {
+        case ARRANGEALG_HTREE:
+            slotSpacing = std::max(1,height/(layerSlots+1));
+            break;
+        case ARRANGEALG_VTREE:
+            slotSpacing = std::max(1,width/(layerSlots+1));
+            break;
+        default:
+        case ARRANGEALG_STAR:
+            slotSpacing = 360/((double)layerSlots);
+            break;
+        }
 
-        // Configure weightiness
+        // Configure weight for each element
         for ( int i = 0; i < layerItems.size(); i++ )
         {
-            ItemWidget * item = layerItems[i];
+            int node = layerItems[i];
 
             if (layer==0)
+            {
                 // Configure original weightiness for layer 0
-                item->setSortPosition( (i+1)*(horizontalSpacing) );
+                graph->sortPositions[node] = (mode==ARRANGEALG_STAR)? i*slotSpacing : (i+1)*slotSpacing;
+            }
             else
-                // Determine weightiness for layer >1
-                item->calcSortPosition();
+            {
+                // Determine weightiness for layer >1 (average from the already placed parents)
+                int parentCount = 0;
+                int weightSum = 0;
+                for (int j=0; j<graph->degree(node); j++)
+                {
+                    int parent = graph->neighbour(node,j);
+                    if (graph->sortPositions[parent]>=0 && graph->layers[parent]!=layer)
+                    {
+                        parentCount++;
+                        weightSum+=graph->sortPositions[parent];
+                    }
+                }
+                if (parentCount>0)
+                    graph->sortPositions[node] = weightSum/parentCount;
+            }
         }
 
-        // Sorted items...
-        QVector<ItemWidget *> layerSortedSlots(layerSlots);
-        // Initialize vector with nullptr
-        for ( int i = 0; i < layerSlots; i++ )
+        // Fill slots with items (nearest free slot to the heuristic best position)
+        QVector<int> layerSortedSlots(layerSlots,-1);
+        SlotAllocator allocator(layerSlots);
+        for ( int node : layerItems )
         {
-            layerSortedSlots[i]=nullptr;
+            int bestPosition = (int)(graph->sortPositions[node]/slotSpacing)-1;
+            layerSortedSlots[allocator.allocate(bestPosition)] = node;
         }
 
-        // Fill slots with items
-        for ( int i = 0; i < layerItems.size(); i++ )
+        // The final position
+        for ( int i = 0; i < layerSlots; i++ )
         {
-            ItemWidget * item = layerItems[i];
-
-            int bestPosition = (item->getSortPosition()/horizontalSpacing)-1;
+            int node = layerSortedSlots[i];
+            if (node<0)
+                continue;
 
-            // bestPosition is an heuristic, therefore, adjust into his borders
-            if (bestPosition>=layerSlots)
-                bestPosition = layerSlots-1;
-            if (bestPosition<0)
-                bestPosition = 0;
+            const QSize & nodeSize = graph->sizes[node];
 
-            // Fit
-            int diff_p = 0, diff_m = 0;
-            while ( layerSortedSlots[bestPosition+diff_p] && layerSortedSlots[bestPosition-diff_m] )
+            switch (mode)
             {
-                if (bestPosition-diff_m>0)
-                    diff_m++;
-                if (bestPosition+diff_p<(layerSlots-1))
-                    diff_p++;
-            }
-            if (layerSortedSlots[bestPosition-diff_m]==nullptr)
-                bestPosition = bestPosition-diff_m;
-            else if (layerSortedSlots[bestPosition+diff_p]==nullptr)
-                bestPosition = bestPosition+diff_p;
+            case ARRANGEALG_HTREE:
+            {
+                graph->sortPositions[node] = slotSpacing*(i+1);
+                graph->positions[node] = QPoint( layerSpacing*(layer+1) - (nodeSize.width()/2) , slotSpacing*(i+1) );
+            }break;
+            case ARRANGEALG_VTREE:
+            {
+                graph->sortPositions[node] = slotSpacing*(i+1);
+                graph->positions[node] = QPoint( slotSpacing*(i+1), layerSpacing*(layer+1) - (nodeSize.height()/2) );
+            }break;
+            default:
+            case ARRANGEALG_STAR:
+            {
+                graph->sortPositions[node] = slotSpacing*i;
 
-            // Final best position
-            layerSortedSlots[bestPosition] = item;
-        }
+                int r = (layerSpacing*(layer+1))/2;
+                if (layerSlots==1)
+                    r = 0;
+                double degrees = slotSpacing*i;
+                double radians = (((double)degrees)/180.0)*PI;
 
-        // The final move
-        for ( int i = 0; i < layerSlots; i++ )
-        {
-            ItemWidget * item = layerSortedSlots[i];
-            if (item)
-            {
-                item->setSortPosition(horizontalSpacing*(i+1));
-                if (!item->getAnchor())
-                    item->move(   horizontalSpacing*(i+1), verticalSpacing*(layer+1) - (item->size().height()/2) );
+                int x = (width/2);
+                int xplus = ((double)r)*(cos(radians));
+                x = x + xplus;
+
+                int y = (height/2) - ((double)r)*(sin(radians)) ;
+
+                graph->positions[node] = QPoint( x - (nodeSize.width()/2), y );
+            }break;
             }
         }
 
@@ -333,324 +776,617 @@ int Arrange::verticalTree(QWidget *v, QList<ItemWidget *> layerZero)
     return 0;
 }
 
-int Arrange::star(QWidget *v, QList<ItemWidget *> layerZero)
+int Arrange::random(QWidget *v)
 {
-    resetAllLayerAndSortPositionInfo(v); // Set sorting layer to -1 for everyone
-    assignLayerToItemsRecursively(layerZero);
-
-    int prevLayerItemsCount = -1;
-    int layerCount = getLayerCount(v);
-
-    if (!layerCount)
-        return -1;
+    QList<AbstractNodeWidget *> nodes = GraphWidget::allChildrenItemsAndGroups(v);
+    QRect area = getContainerArea(v);
+    bool allowOverlap = getGraph(v)->getAllowOverlap();
+
+    QVector<QSize> sizes;
+    sizes.reserve(nodes.count());
+    for (auto node : nodes)
+        sizes.append(node->size());
+
+    // Anchored nodes are obstacles, the rest are placed one by one in the nearest free place to a random point
+    SpatialIndex index(SpatialIndex::cellSizeFor(sizes));
+    for (auto node : nodes)
+    {
+        if (node->getAnchor())
+            index.insert(node->geometry());
+    }
 
-    // Determine horizontal spacing
-    int horizontalSpacing = (v->size().width()>v->size().height() ? v->size().height()-100 : v->size().width()-100 ) / (layerCount);
+    LayoutRandom * rg = getGraph(v)->getLayoutRandom();
 
-    for (int layer=0; layer<layerCount; layer++)
+    for (auto node : nodes)
     {
-        // Setup each layer.
-        QList<ItemWidget *> layerItems = getItemsFromLayer(v,layer);
+        if (node->getAnchor())
+            continue;
 
-        // Determine how many slots there are in the layer
-        int layerSlots = layerItems.count();
-        if (prevLayerItemsCount>0 && layerItems.count()<=prevLayerItemsCount) layerSlots = prevLayerItemsCount+1;
+        int x = rg->bounded(area.left(), area.right()+1-node->width());
+        int y = rg->bounded(area.top(), area.bottom()+1-node->height());
 
-        // Determine vertical spacing
-        double verticalSpacing = 360/((double)layerSlots);
+        QPoint pos(x,y);
+        if (!allowOverlap)
+            pos = index.findFreePosition(node->size(),pos,area);
 
-        // Configure weightiness
-        for ( int i = 0; i < layerItems.size(); i++ )
-        {
-            ItemWidget * item = layerItems[i];
-            if (layer==0)
-                // Configure original weightiness for layer 0
-                item->setSortPosition( i*(verticalSpacing) );
-            else
-                // Determine weightiness for layer >1
-                item->calcSortPosition();
-        }
-
-        // Sorted items...
-        QVector<ItemWidget *> layerSortedSlots(layerSlots);
-        // nullptr-Initialize vector
-        for ( int i = 0; i < layerSlots; i++ ) {   layerSortedSlots[i]=nullptr;    }
+        index.insert(QRect(pos,node->size()));
+        node->move(pos);
+    }
 
-        // Fill slots with items
-        for ( int i = 0; i < layerItems.size(); i++ )
-        {
-            ItemWidget * item = layerItems[i];
+    // Expand the container if the nodes does not fit
+    if (index.getBottom()>=v->height())
+        v->resize(v->width(),index.getBottom()+1);
 
-            int bestPosition = (item->getSortPosition()/verticalSpacing)-1;
+    return 0;
+}
 
-            // bestPosition is an heuristic, therefore, adjust into his borders
-            if (bestPosition>=layerSlots)
-                bestPosition = layerSlots-1;
-            if (bestPosition<0)
-                bestPosition = 0;
+int Arrange::stratified(QWidget *v)
+{
+    QList<AbstractNodeWidget *> nodes = GraphWidget::allChildrenItemsAndGroups(v);
+    QRect area = getContainerArea(v);
+    bool allowOverlap = getGraph(v)->getAllowOverlap();
+    LayoutRandom * rg = getGraph(v)->getLayoutRandom();
 
-            // Fit
-            int diff_p = 0, diff_m = 0;
-            while ( layerSortedSlots[bestPosition+diff_p] && layerSortedSlots[bestPosition-diff_m] )
-            {
-                if (bestPosition-diff_m>0)
-                    diff_m++;
-                if (bestPosition+diff_p<(layerSlots-1))
-                    diff_p++;
-            }
-            if (layerSortedSlots[bestPosition-diff_m]==nullptr)
-                bestPosition = bestPosition-diff_m;
-            else if (layerSortedSlots[bestPosition+diff_p]==nullptr)
-                bestPosition = bestPosition+diff_p;
+    QVector<QSize> sizes;
+    QVector<int> movable;
+    sizes.reserve(nodes.count());
+    movable.reserve(nodes.count());
 
-            // Final optimus position
-            layerSortedSlots[bestPosition] = item;
-        }
+    for (int i=0; i<nodes.count(); i++)
+    {
+        sizes.append(nodes[i]->size());
+        if (!nodes[i]->getAnchor())
+            movable.append(i);
+    }
 
-        // The final move
-        for ( double i = 0; i < layerSlots; i=i+1.0 )
-        {
-            ItemWidget * item = layerSortedSlots[i];
-            if (item)
-            {
-                item->setSortPosition(verticalSpacing*i);
+    // Anchored nodes are obstacles
+    SpatialIndex index(SpatialIndex::cellSizeFor(sizes));
+    for (auto node : nodes)
+    {
+        if (node->getAnchor())
+            index.insert(node->geometry());
+    }
 
-                int r = (horizontalSpacing*(layer+1))/2;
-                if (layerSlots==1)
-                    r = 0;
-                double degrees = verticalSpacing*i;
-                double radians = (((double)degrees)/180.0)*PI;
+    int n = movable.count();
+    if (!n)
+        return 0;
+
+    // Grid with about one cell per node, keeping the aspect ratio of the area
+    int width = std::max(1,area.width());
+    int height = std::max(1,area.height());
+    int cols = std::max(1,(int)std::ceil(std::sqrt(((double)n*width)/height)));
+    int rows = (n+cols-1)/cols;
+    double cellWidth = ((double)width)/cols;
+    double cellHeight = ((double)height)/rows;
+
+    // Random cell for each node (Fisher-Yates)
+    QVector<int> cells(rows*cols);
+    for (int i=0; i<cells.count(); i++)
+        cells[i] = i;
+    for (int i=cells.count()-1; i>0; i--)
+        std::swap(cells[i],cells[rg->bounded(0,i)]);
+
+    // Jittered position inside the cell
+    for (int k=0; k<n; k++)
+    {
+        AbstractNodeWidget * node = nodes[movable[k]];
+        int cell = cells[k];
 
-                int x = (v->size().width()/2);
-                int xplus = ((double)r)*(cos(radians));
-                x = x + xplus;
+        int cellX = area.left() + (int)((cell%cols)*cellWidth);
+        int cellY = area.top() + (int)((cell/cols)*cellHeight);
+        int x = rg->bounded(cellX, cellX+(int)cellWidth-node->width());
+        int y = rg->bounded(cellY, cellY+(int)cellHeight-node->height());
 
-                int y = (v->size().height()/2) - ((double)r)*(sin(radians)) ;
+        QPoint pos(x,y);
+        if (!allowOverlap)
+            pos = index.findFreePosition(node->size(),pos,area);
 
-                if (!item->getAnchor())
-                    item->move(x - (item->size().width()/2) ,y);
-            }
-        }
-        prevLayerItemsCount = layerItems.count();
+        index.insert(QRect(pos,node->size()));
+        node->move(pos);
     }
+
+    // Expand the container if the nodes does not fit
+    if (index.getBottom()>=v->height())
+        v->resize(v->width(),index.getBottom()+1);
+
     return 0;
 }
 
-int Arrange::random(QWidget *v)
+int Arrange::removeOverlaps(QWidget *v, int spacing)
 {
-    for (auto item : GraphWidget::allChildrenItemsAndGroups(v))
+    QList<AbstractNodeWidget *> nodes = GraphWidget::allChildrenItemsAndGroups(v);
+    QRect area = getContainerArea(v);
+
+    QVector<QRect> rects;
+    QVector<QSize> sizes;
+    rects.reserve(nodes.count());
+    sizes.reserve(nodes.count());
+    for (auto node : nodes)
     {
-        item->moveToRandom();
+        rects.append(node->geometry());
+        sizes.append(node->size());
     }
 
-    return 0;
-}
+    SpatialIndex index(SpatialIndex::cellSizeFor(sizes)+spacing);
 
-int Arrange::rowsMover(QWidget *v, int spacing, SortBy sortBy, bool group, XY * accumulated)
-{
-    QList<AbstractNodeWidget *> nodes;
-    if (group)
+    // Anchored nodes stays where they are
+    QVector<int> order;
+    order.reserve(nodes.count());
+    for (int i=0; i<nodes.count(); i++)
     {
-        for (auto i : GraphWidget::allChildrenGroups(v))
-            nodes.push_back(i);
+        if (nodes[i]->getAnchor())
+            index.insert(rects[i]);
+        else
+            order.append(i);
     }
-    else
+
+    // Scan-line: top to bottom, left to right. Each node keeps his place if it's free,
+    // otherwise it goes to the nearest free place.
+    std::stable_sort(order.begin(),order.end(), [&rects](int a, int b) -> bool {
+        if (rects[a].top()!=rects[b].top())
+            return rects[a].top() < rects[b].top();
+        return rects[a].left() < rects[b].left();
+    });
+
+    for (int i : order)
     {
-        for (auto i : GraphWidget::allChildrenItems(v))
-            nodes.push_back(i);
+        QRect r = rects[i];
+
+        // Keep into the container area
+        if (r.top()<area.top())
+            r.moveTop(area.top());
+        if (r.right()>area.right())
+            r.moveLeft(std::max(area.left(),area.right()+1-r.width()));
+        if (r.left()<area.left())
+            r.moveLeft(area.left());
+
+        if (index.intersects(r,spacing))
+            r.moveTo(index.findFreePosition(r.size(),r.topLeft(),area,spacing));
+
+        index.insert(r);
+        if (r!=rects[i])
+            nodes[i]->move(r.topLeft());
     }
 
+    // Expand the container if the nodes does not fit
+    if (index.getBottom()>=v->height())
+        v->resize(v->width(),index.getBottom()+1);
+
+    return 0;
+}
+
+GraphWidget *Arrange::getGraph(QWidget *v)
+{
+    if (v->objectName().startsWith("GROUP-"))
+        return (GraphWidget *)v->parentWidget();
+    return (GraphWidget *)v;
+}
+
+QRect Arrange::getContainerArea(QWidget *v)
+{
+    int pVerticalOffset = v->objectName().startsWith("GROUP-")? ((AbstractNodeWidget *)v)->getVerticalOffset() : 0;
+    return QRect(0,pVerticalOffset,v->width(),std::max(0,v->height()-pVerticalOffset));
+}
+
+bool Arrange::sortNodes(QList<AbstractNodeWidget *> *nodes, SortBy sortBy)
+{
+    SortKeys::Field field;
+    bool natural = (sortBy==SORTBY_OBJECT_ID_NATURAL || sortBy==SORTBY_TEXT_NATURAL || sortBy==SORTBY_SUBTEXT_NATURAL);
+
     switch (sortBy)
     {
     case SORTBY_INSERT_POS:
-        break;
+        return true;
     case SORTBY_OBJECT_ID:
-        std::sort(nodes.begin(), nodes.end(), [](const AbstractNodeWidget* a, const AbstractNodeWidget* b) -> bool { return a->getID() < b->getID(); });
+    case SORTBY_OBJECT_ID_NATURAL:
+        field = SortKeys::FIELD_ID;
         break;
     case SORTBY_TEXT:
-        std::sort(nodes.begin(), nodes.end(), [](const AbstractNodeWidget* a, const AbstractNodeWidget* b) -> bool { return a->getText() < b->getText(); });
+    case SORTBY_TEXT_NATURAL:
+        field = SortKeys::FIELD_TEXT;
         break;
     case SORTBY_SUBTEXT:
-        std::sort(nodes.begin(), nodes.end(), [](const AbstractNodeWidget* a, const AbstractNodeWidget* b) -> bool { return a->getSubText() < b->getSubText(); });
+    case SORTBY_SUBTEXT_NATURAL:
+        field = SortKeys::FIELD_SUBTEXT;
         break;
     default:
-        return -1;
+        return false;
     }
 
-    // First draw groups...
-    int currentRow = 0;
+    // One key per node, then sort the indexes
+    QVector<QByteArray> keys;
+    keys.reserve(nodes->count());
+    for (auto node : *nodes)
+        keys.append(node->getSortKey(field,natural));
+
+    QList<AbstractNodeWidget *> sorted;
+    sorted.reserve(nodes->count());
+    for (int i : SortKeys::sortedOrder(keys))
+        sorted.append(nodes->at(i));
+    *nodes = sorted;
+
+    return true;
+}
+
+QVector<QPoint> Arrange::rowsPlacement(const QVector<QSize> &sizes, int spacing, QSize *area, XY *accumulated)
+{
+    QVector<QPoint> positions(sizes.count());
     int nodesAtRow = 0;
-    int lastMaxY=0;
+    int rowHeight = 0;
 
     accumulated->x = 0;
 
-    for ( auto node : nodes )
+    for (int i=0; i<sizes.count(); i++)
     {
-rback_sort_rows:
-        auto gsize = node->size();
-
-        XY currentPos = *accumulated;
-        currentPos.x+=spacing;
+        const QSize & size = sizes[i];
 
-        // X:
-        if (accumulated->x+gsize.width()+(spacing*2)>(v->size().width()) )
+        if (accumulated->x+size.width()+(spacing*2)>area->width())
         {
-            if (nodesAtRow == 0)
-            {
-                // not enough room for x, expand x...
-                v->resize(accumulated->x+gsize.width()+(spacing*2),
-                          v->size().height());
-            }
-            else
+            if (nodesAtRow)
             {
-                // reset and move to the next row:
+                // move to the next row
                 nodesAtRow = 0;
-                currentRow++;
-                accumulated->x=0;
-                accumulated->y+=lastMaxY+spacing;
-
-                // reset and size...
-                v->resize(  v->size().width(),
-                            accumulated->y );
-
-                goto rback_sort_rows; // now we are in the next row... try with the same element...
+                accumulated->x = 0;
+                accumulated->y += rowHeight+spacing;
+                rowHeight = 0;
             }
+            // not enough room for x, expand x...
+            if (size.width()+(spacing*2)>area->width())
+                area->setWidth(size.width()+(spacing*2));
         }
 
-        accumulated->x+=spacing+gsize.width();
-        lastMaxY = std::max(lastMaxY,gsize.height());
-        nodesAtRow++;
+        positions[i] = QPoint(accumulated->x+spacing, accumulated->y);
 
-        node->move({currentPos.x,currentPos.y});
+        accumulated->x += spacing+size.width();
+        rowHeight = std::max(rowHeight,size.height());
+        nodesAtRow++;
     }
 
-    accumulated->y+=lastMaxY+spacing;
-
-    v->resize(v->size().width(),
-              accumulated->y);
+    accumulated->y += rowHeight+spacing;
+    area->setHeight(accumulated->y);
 
-    return 0;
+    return positions;
 }
-int Arrange::rows(QWidget *v, int spacing, SortBy sortBy)
+
+QVector<QPoint> Arrange::columnsPlacement(const QVector<QSize> &sizes, int spacing, int verticalOffset, QSize *area, XY *accumulated)
 {
-    for (auto i : GraphWidget::allChildrenItemsAndGroups(v))
+    QVector<QPoint> positions(sizes.count());
+    int nodesAtColumn = 0;
+    int columnWidth = 0;
+
+    accumulated->y = verticalOffset;
+
+    for (int i=0; i<sizes.count(); i++)
     {
-        // Clean the space from elements (avoid unintented intersections):
-        i->move({-10000,-10000});
-    }
+        const QSize & size = sizes[i];
 
-    XY accumulated;
-    accumulated.y = v->objectName().startsWith("GROUP-")? ((AbstractNodeWidget *)v)->getVerticalOffset() : 0;
+        if (accumulated->y+size.height()+(spacing*2)>area->height())
+        {
+            if (nodesAtColumn)
+            {
+                // move to the next column
+                nodesAtColumn = 0;
+                accumulated->y = verticalOffset;
+                accumulated->x += spacing+columnWidth;
+                columnWidth = 0;
+            }
+            // not enough room for y, expand y...
+            if (verticalOffset+size.height()+(spacing*2)>area->height())
+                area->setHeight(verticalOffset+size.height()+(spacing*2));
+        }
 
-    rowsMover(v,spacing,sortBy,true,&accumulated);
-    rowsMover(v,spacing,sortBy,false,&accumulated);
+        positions[i] = QPoint(accumulated->x, accumulated->y+spacing);
 
-    return 0;
+        accumulated->y += spacing+size.height();
+        columnWidth = std::max(columnWidth,size.width());
+        nodesAtColumn++;
+    }
+
+    accumulated->x += columnWidth+spacing;
+    area->setWidth(accumulated->x);
+
+    return positions;
 }
 
-int Arrange::columnsMover(QWidget *v, int spacing, SortBy sortBy, bool group,XY * accumulated)
+int Arrange::arrangeFlow(QWidget *v, int spacing, SortBy sortBy, Mode mode)
 {
-    QList<AbstractNodeWidget *> nodes;
-    if (group)
+    // First the groups, then the items
+    QList<AbstractNodeWidget *> groups, items;
+    for (auto i : GraphWidget::allChildrenGroups(v))
+        groups.push_back(i);
+    for (auto i : GraphWidget::allChildrenItems(v))
+        items.push_back(i);
+
+    if (!sortNodes(&groups,sortBy) || !sortNodes(&items,sortBy))
+        return -1;
+
+    QVector<QSize> groupSizes, itemSizes;
+    groupSizes.reserve(groups.count());
+    itemSizes.reserve(items.count());
+    for (auto i : groups)
+        groupSizes.append(i->size());
+    for (auto i : items)
+        itemSizes.append(i->size());
+
+    int pVerticalOffset = v->objectName().startsWith("GROUP-")? ((AbstractNodeWidget *)v)->getVerticalOffset() : 0;
+    QSize area = v->size();
+    QVector<QPoint> positions;
+
+    switch (mode)
     {
-        for (auto i : GraphWidget::allChildrenGroups(v))
-            nodes.push_back(i);
-    }
-    else
+    case ARRANGEALG_ROWS:
     {
-        for (auto i : GraphWidget::allChildrenItems(v))
-            nodes.push_back(i);
+        XY accumulated;
+        accumulated.y = pVerticalOffset;
+        positions = rowsPlacement(groupSizes,spacing,&area,&accumulated);
+        positions += rowsPlacement(itemSizes,spacing,&area,&accumulated);
+        break;
     }
-
-    switch (sortBy)
+    case ARRANGEALG_COLUMNS:
     {
-    case SORTBY_INSERT_POS:
-        break;
-    case SORTBY_OBJECT_ID:
-        std::sort(nodes.begin(), nodes.end(), [](const AbstractNodeWidget* a, const AbstractNodeWidget* b) -> bool { return a->getID() < b->getID(); });
-        break;
-    case SORTBY_TEXT:
-        std::sort(nodes.begin(), nodes.end(), [](const AbstractNodeWidget* a, const AbstractNodeWidget* b) -> bool { return a->getText() < b->getText(); });
+        XY accumulated;
+        positions = columnsPlacement(groupSizes,spacing,pVerticalOffset,&area,&accumulated);
+        positions += columnsPlacement(itemSizes,spacing,pVerticalOffset,&area,&accumulated);
         break;
-    case SORTBY_SUBTEXT:
-        std::sort(nodes.begin(), nodes.end(), [](const AbstractNodeWidget* a, const AbstractNodeWidget* b) -> bool { return a->getSubText() < b->getSubText(); });
+    }
+    case ARRANGEALG_SHELVES:
+    {
+        // Groups and items are mixed, the shelves are ordered by height
+        QSize packedSize;
+        positions = packShelves(groupSizes+itemSizes,area.width(),spacing,&packedSize);
+        for (auto & position : positions)
+            position.ry() += pVerticalOffset;
+        area = QSize(std::max(area.width(),packedSize.width()), pVerticalOffset+packedSize.height());
         break;
+    }
     default:
         return -1;
     }
-    int pVerticalOffset = v->objectName().startsWith("GROUP-")? ((AbstractNodeWidget *)v)->getVerticalOffset() : 0;
 
-    // First draw groups...
-    int currentColumn = 0;
-    int nodesAtColumn = 0;
-    int lastMaxX=0;
+    // Apply everything in one batch
+    QList<AbstractNodeWidget *> nodes = groups+items;
+    for (int i=0; i<nodes.count(); i++)
+    {
+        if (nodes[i]->pos()!=positions[i])
+            nodes[i]->move(positions[i]);
+    }
+
+    if (area!=v->size())
+        v->resize(area);
+
+    return 0;
+}
+
+int Arrange::rows(QWidget *v, int spacing, SortBy sortBy)
+{
+    return arrangeFlow(v,spacing,sortBy,ARRANGEALG_ROWS);
+}
+
+int Arrange::columns(QWidget *v, int spacing, SortBy sortBy)
+{
+    return arrangeFlow(v,spacing,sortBy,ARRANGEALG_COLUMNS);
+}
 
-    accumulated->y = pVerticalOffset;
+int Arrange::shelves(QWidget *v, int spacing, SortBy sortBy)
+{
+    return arrangeFlow(v,spacing,sortBy,ARRANGEALG_SHELVES);
+}
+
+int Arrange::placeIncremental(QWidget *v, ItemWidget *item, ItemWidget *linkedTo, Mode mode, int spacing)
+{
+    if (item->getAnchor())
+        return 0;
 
-    for ( auto node : nodes )
+    switch ( mode )
     {
-rback_sort_columns:
-        auto gsize = node->size();
+    case ARRANGEALG_ROWS:
+    case ARRANGEALG_SHELVES:
+        return rowsPlace(v,item,spacing);
+    case ARRANGEALG_COLUMNS:
+        return columnsPlace(v,item,spacing);
+    case ARRANGEALG_HTREE:
+    case ARRANGEALG_VTREE:
+    case ARRANGEALG_STAR:
+        return layeredPlace(v,item,linkedTo,mode,spacing);
+    default:
+    case ARRANGEALG_RANDOM:
+        // Already placed in a random position.
+        return 0;
+    }
+}
 
-        XY currentPos = *accumulated;
-        currentPos.y+=spacing;
+int Arrange::rowsPlace(QWidget *v, ItemWidget *item, int spacing)
+{
+    int pVerticalOffset = v->objectName().startsWith("GROUP-")? ((AbstractNodeWidget *)v)->getVerticalOffset() : 0;
 
-        // Y:
-        if (accumulated->y+gsize.height()+(spacing*2)>(v->size().height()) )
-        {
-            if (nodesAtColumn == 0)
-            {
-                // expand y...
-                v->resize(
-                          v->size().width(),
-                          accumulated->y+gsize.height()+(spacing*2)
-                          );
-            }
-            else
-            {
-                // reset:
-                nodesAtColumn = 0;
-                currentColumn++;
-                accumulated->y=pVerticalOffset;
-                accumulated->x+=spacing+lastMaxX;
+    // Items are placed after the groups...
+    int groupsBottom = -1;
+    for (auto group : GraphWidget::allChildrenGroups(v))
+        groupsBottom = std::max(groupsBottom, group->pos().y()+group->size().height());
 
-                // expand x...
-                v->resize(
-                          accumulated->x,
-                          v->size().height()
-                          );
+    // Locate the last row:
+    int lastRowY = -1, lastRowRight = 0, lastRowHeight = 0;
+    for (auto sibling : GraphWidget::allChildrenItems(v))
+    {
+        if (sibling==item)
+            continue;
 
-                goto rback_sort_columns; // now we are in the next row... try with the same element...
-            }
+        int y = sibling->pos().y();
+        if (y>lastRowY)
+        {
+            lastRowY = y;
+            lastRowRight = 0;
+            lastRowHeight = 0;
+        }
+        if (y==lastRowY)
+        {
+            lastRowRight = std::max(lastRowRight, sibling->pos().x()+sibling->size().width());
+            lastRowHeight = std::max(lastRowHeight, sibling->size().height());
         }
+    }
 
-        accumulated->y+=spacing+gsize.height();
-        lastMaxX = std::max(lastMaxX,gsize.width());
-        nodesAtColumn++;
+    QPoint nextPos;
+    if (lastRowY<0)
+        nextPos = QPoint(spacing, groupsBottom<0? pVerticalOffset : groupsBottom+spacing);
+    else if (lastRowRight+item->size().width()+(spacing*2) <= v->size().width())
+        nextPos = QPoint(lastRowRight+spacing, lastRowY);
+    else
+        nextPos = QPoint(spacing, lastRowY+lastRowHeight+spacing);
 
-        node->move({currentPos.x,currentPos.y});
+    // not enough room, expand...
+    if (nextPos.x()+item->size().width()+spacing > v->size().width() || nextPos.y()+item->size().height()+spacing > v->size().height())
+    {
+        v->resize( std::max(v->size().width(), nextPos.x()+item->size().width()+spacing),
+                   std::max(v->size().height(), nextPos.y()+item->size().height()+spacing) );
     }
 
-    accumulated->x+=lastMaxX+spacing;
+    item->move(nextPos);
+    return 0;
+}
+
+int Arrange::columnsPlace(QWidget *v, ItemWidget *item, int spacing)
+{
+    int pVerticalOffset = v->objectName().startsWith("GROUP-")? ((AbstractNodeWidget *)v)->getVerticalOffset() : 0;
 
-    v->resize(accumulated->x,
-              v->size().height() );
+    // Items are placed after the groups...
+    int groupsRight = -1;
+    for (auto group : GraphWidget::allChildrenGroups(v))
+        groupsRight = std::max(groupsRight, group->pos().x()+group->size().width());
+
+    // Locate the last column:
+    int lastColumnX = -1, lastColumnBottom = 0, lastColumnWidth = 0;
+    for (auto sibling : GraphWidget::allChildrenItems(v))
+    {
+        if (sibling==item)
+            continue;
 
+        int x = sibling->pos().x();
+        if (x>lastColumnX)
+        {
+            lastColumnX = x;
+            lastColumnBottom = 0;
+            lastColumnWidth = 0;
+        }
+        if (x==lastColumnX)
+        {
+            lastColumnBottom = std::max(lastColumnBottom, sibling->pos().y()+sibling->size().height());
+            lastColumnWidth = std::max(lastColumnWidth, sibling->size().width());
+        }
+    }
+
+    QPoint nextPos;
+    if (lastColumnX<0)
+        nextPos = QPoint(groupsRight<0? 0 : groupsRight+spacing, pVerticalOffset+spacing);
+    else if (lastColumnBottom+item->size().height()+(spacing*2) <= v->size().height())
+        nextPos = QPoint(lastColumnX, lastColumnBottom+spacing);
+    else
+        nextPos = QPoint(lastColumnX+lastColumnWidth+spacing, pVerticalOffset+spacing);
+
+    // not enough room, expand...
+    if (nextPos.x()+item->size().width()+spacing > v->size().width() || nextPos.y()+item->size().height()+spacing > v->size().height())
+    {
+        v->resize( std::max(v->size().width(), nextPos.x()+item->size().width()+spacing),
+                   std::max(v->size().height(), nextPos.y()+item->size().height()+spacing) );
+    }
+
+    item->move(nextPos);
     return 0;
 }
 
-int Arrange::columns(QWidget *v, int spacing, SortBy sortBy)
+int Arrange::layeredPlace(QWidget *v, ItemWidget *item, ItemWidget *linkedTo, Mode mode, int spacing)
 {
-    for (auto i : GraphWidget::allChildrenItemsAndGroups(v))
+    int layer = linkedTo? linkedTo->getLayer()+1 : 0;
+    int layerCount = std::max(getLayerCount(v), layer+1);
+    int gap = std::max(spacing, 4);
+
+    // Reference item from the same layer (keep the layer line/ring)
+    ItemWidget * layerReference = nullptr;
+    for (auto sibling : GraphWidget::allChildrenItems(v))
     {
-        // Clean the space from elements (avoid unintented intersections):
-        i->move({-10000,-10000});
+        if (sibling!=item && sibling->getLayer()==layer)
+        {
+            layerReference = sibling;
+            break;
+        }
     }
 
-    XY accumulated;
-    accumulated.y = v->objectName().startsWith("GROUP-")? ((AbstractNodeWidget *)v)->getVerticalOffset() : 0;
+    QRect r(QPoint(0,0), item->size());
+    SpatialIndex siblings = siblingsIndex(v,item);
 
-    columnsMover(v,spacing,sortBy,true,&accumulated);
-    columnsMover(v,spacing,sortBy,false,&accumulated);
-    return 0;
+    if (mode==ARRANGEALG_STAR)
+    {
+        int horizontalSpacing = (v->size().width()>v->size().height() ? v->size().height()-100 : v->size().width()-100 ) / (layerCount);
+        QPoint center(v->size().width()/2, v->size().height()/2);
+
+        double radius = (horizontalSpacing*(layer+1))/2;
+        if (layerReference)
+        {
+            QPoint rp = layerReference->pos() + QPoint(layerReference->size().width()/2,0);
+            radius = sqrt( pow(rp.x()-center.x(),2) + pow(center.y()-rp.y(),2) );
+        }
+
+        // Start from the angle of the linked item.
+        double radians = 0;
+        if (linkedTo)
+        {
+            QPoint lp = linkedTo->pos() + QPoint(linkedTo->size().width()/2,0);
+            if (lp!=center)
+                radians = atan2( center.y()-lp.y(), lp.x()-center.x() );
+        }
+
+        double step = (item->size().width()+gap)/std::max(radius,1.0);
+        int maxSteps = std::max(1,(int)ceil(PI/step));
+        for (int i=0; i<=maxSteps; i++)
+        {
+            for (int sign : {1,-1})
+            {
+                double a = radians + sign*i*step;
+                r.moveTo( center.x() + radius*cos(a) - (item->size().width()/2), center.y() - radius*sin(a) );
+                if (isFreeArea(v,r,siblings))
+                {
+                    item->setLayer(layer);
+                    item->setSortPosition( ((int)round(a*180.0/PI)+360)%360 );
+                    item->move(r.topLeft());
+                    return 0;
+                }
+            }
+        }
+        return -1;
+    }
+
+    bool horizontal = (mode==ARRANGEALG_HTREE);
+
+    // Position of the layer line (x for horizontal trees, y for vertical trees)
+    int layerSpacing = horizontal? v->size().width()/(layerCount+1) : v->size().height()/(layerCount+1);
+    int layerLine;
+    if (layerReference)
+        layerLine = horizontal? layerReference->pos().x()+(layerReference->size().width()/2) : layerReference->pos().y()+(layerReference->size().height()/2);
+    else
+        layerLine = layerSpacing*(layer+1);
+
+    // Start next to the linked item and probe both sides of the line
+    int start = linkedTo? (horizontal? linkedTo->pos().y() : linkedTo->pos().x()) : gap;
+    int delta = horizontal? item->size().height()+gap : item->size().width()+gap;
+    int limit = horizontal? v->size().height() : v->size().width();
+
+    for (int i=0; start-(i*delta)>=0 || start+(i*delta)<limit; i++)
+    {
+        for (int sign : {1,-1})
+        {
+            int slot = start + sign*i*delta;
+            if (horizontal)
+                r.moveTo( layerLine-(item->size().width()/2), slot );
+            else
+                r.moveTo( slot, layerLine-(item->size().height()/2) );
+
+            if (isFreeArea(v,r,siblings))
+            {
+                item->setLayer(layer);
+                item->setSortPosition(slot);
+                item->move(r.topLeft());
+                return 0;
+            }
+        }
+    }
+    return -1;
 }
@@ -3,9 +3,12 @@
 
 #include <QWidget>
 #include "graphwidget.h"
+#include "spatialindex.h"
 
 namespace QNodeGraph
 {
+class LayoutGraph;
+
 class Arrange
 {
 public:
@@ -16,13 +19,21 @@ public:
                 ARRANGEALG_COLUMNS=2,
                 ARRANGEALG_HTREE=3,
                 ARRANGEALG_VTREE=4,
-                ARRANGEALG_STAR=5 };
+                ARRANGEALG_STAR=5,
+                ARRANGEALG_STRATIFIED=6,
+                ARRANGEALG_MULTILEVEL=7,
+                ARRANGEALG_STRESS=8,
+                ARRANGEALG_HIERARCHICAL=9,
+                ARRANGEALG_SHELVES=10 };
 
     enum SortBy {
         SORTBY_INSERT_POS=0,
         SORTBY_OBJECT_ID=1,
         SORTBY_TEXT=2,
-        SORTBY_SUBTEXT=3
+        SORTBY_SUBTEXT=3,
+        SORTBY_OBJECT_ID_NATURAL=4,
+        SORTBY_TEXT_NATURAL=5,
+        SORTBY_SUBTEXT_NATURAL=6
     };
 
     /**
@@ -31,6 +42,27 @@ public:
      * @return zero for no errors.
      */
     static int triggerAutoArrange(QWidget * v);
+    /**
+     * @brief triggerAutoArrangeOnNewItem Execute autoarrange after adding an item, placing only the new item when incremental mode is activated
+     * @param v group or graph
+     * @param item new item
+     * @return zero for no errors.
+     */
+    static int triggerAutoArrangeOnNewItem(QWidget * v, ItemWidget * item);
+    /**
+     * @brief triggerAutoArrangeOnNewLink Execute autoarrange after linking two items, placing only the new leaf when incremental mode is activated
+     * @param v group or graph
+     * @param item1 first linked item
+     * @param item2 second linked item
+     * @return zero for no errors.
+     */
+    static int triggerAutoArrangeOnNewLink(QWidget * v, ItemWidget * item1, ItemWidget * item2);
+    /**
+     * @brief countChildNode Account a node created (or destroyed) directly inside the container
+     * @param v container
+     * @param delta 1 when created, -1 when destroyed
+     */
+    static void countChildNode(QWidget * v, int delta);
 
     /**
      * @brief arrange Arrange some widget childrens items using a selected Mode/Sort
@@ -40,8 +72,51 @@ public:
      * @param sortBy sort by (data to be sorted)
      * @return zero for no errors.
      */
-    static int arrange( QWidget * v,int spacing, Mode mode, SortBy sortBy )
+    static int arrange( QWidget * v,int spacing, Mode mode, SortBy sortBy );
+
+    /**
+     * @brief arrangeByComponents Arrange every connected component independently (in parallel) and pack them into the container
+     * @param v group or graph (the height will be expanded if the components does not fit)
+     * @param spacing spacing between components
+     * @param mode algorithm (only the algorithms that use the links, see isGraphMode)
+     * @return zero for no errors.
+     */
+    static int arrangeByComponents( QWidget * v, int spacing, Mode mode );
+    /**
+     * @brief layoutGraph Compute the positions of a layout graph without touching the widgets (safe to call from any thread)
+     * @param graph layout graph
+     * @param mode algorithm (only the algorithms that use the links, see isGraphMode)
+     * @return zero for no errors.
+     */
+    static int layoutGraph( LayoutGraph * graph, Mode mode );
+    /**
+     * @brief isGraphMode Get if the algorithm places the items using the links (and can be used over a layout graph)
+     * @param mode algorithm
+     * @return true for graph algorithms
+     */
+    static bool isGraphMode( Mode mode );
+    /**
+     * @brief removeOverlaps Move the nodes of the container so they don't overlap (deterministic scan-line pass, anchored nodes are not moved)
+     * @param v group or graph (the height will be expanded if the nodes does not fit)
+     * @param spacing minimum space between nodes
+     * @return zero for no errors.
+     */
+    static int removeOverlaps( QWidget * v, int spacing );
+
+private:
+    /**
+     * @brief runArrange Arrange some widget childrens items using a selected Mode/Sort (without the layout cache)
+     * @param v group or graph
+     * @param spacing spacing between items (for col/row)
+     * @param mode algoritm
+     * @param sortBy sort by (data to be sorted)
+     * @return zero for no errors.
+     */
+    static int runArrange( QWidget * v,int spacing, Mode mode, SortBy sortBy )
     {
+        if (getAutoArrangeByComponents(v) && isGraphMode(mode))
+            return arrangeByComponents(v,spacing,mode);
+
         switch ( mode )
         {
         case ARRANGEALG_ROWS:
@@ -49,18 +124,63 @@ public:
         case ARRANGEALG_COLUMNS:
             return columns(v,spacing, sortBy);
         case ARRANGEALG_HTREE:
-            return horizontalTree(v,getLayerZeroItems(v));
+            return horizontalTree(v);
         case ARRANGEALG_VTREE:
-            return verticalTree(v,getLayerZeroItems(v));
+            return verticalTree(v);
         case ARRANGEALG_STAR:
-            return star(v,getLayerZeroItems(v));
+            return star(v);
+        case ARRANGEALG_STRATIFIED:
+            return stratified(v);
+        case ARRANGEALG_MULTILEVEL:
+        case ARRANGEALG_STRESS:
+            return arrangeGraph(v,mode);
+        case ARRANGEALG_HIERARCHICAL:
+            return hierarchical(v,spacing);
+        case ARRANGEALG_SHELVES:
+            return shelves(v,spacing,sortBy);
         default:
         case ARRANGEALG_RANDOM:
             return random(v);
         }
     }
 
-private:
+    /**
+     * @brief getGraph Get the graph of the container
+     * @param v group or graph
+     * @return graph widget
+     */
+    static GraphWidget * getGraph(QWidget * v);
+    /**
+     * @brief getContainerArea Get the area of the container where the nodes can be placed (below the vertical offset)
+     * @param v group or graph
+     * @return area (relative to the container)
+     */
+    static QRect getContainerArea(QWidget * v);
+    /**
+     * @brief getAutoArrangeByComponents Get if the widget is configured to arrange the components independently
+     * @param v widget
+     * @return true for arrange by components
+     */
+    static bool getAutoArrangeByComponents(QWidget * v);
+    /**
+     * @brief componentArea Estimate the area needed to arrange a component
+     * @param graph component
+     * @param area container area (used for the aspect ratio and as the upper limit)
+     * @param spacing spacing between items
+     * @param mode algorithm
+     * @return component area
+     */
+    static QSize componentArea(const LayoutGraph & graph, const QSize & area, int spacing, Mode mode);
+    /**
+     * @brief packShelves Pack boxes into shelves (rows), tallest first, each box goes to the first shelf with room
+     * @param boxes boxes sizes
+     * @param width available width
+     * @param spacing spacing between boxes
+     * @param packedSize output with the total used size
+     * @return top left position for each box
+     */
+    static QVector<QPoint> packShelves(const QVector<QSize> & boxes, int width, int spacing, QSize * packedSize);
+
     /**
      * @brief getAutoArrange Get if the widget is configured for auto-arrange his items..
      * @param v widget
@@ -70,27 +190,59 @@ private:
      */
     static bool getAutoArrange(QWidget * v , Mode *mode, SortBy *sortBy, int *spacing);
     /**
-     * @brief resetAllLayerAndSortPositionInfo Initialize every item with no layer and sort position
-     * @param v items container
+     * @brief getAutoArrangeIncremental Get if the widget is configured for incremental placement of new items
+     * @param v widget
+     * @return true for incremental placement
      */
-    static void resetAllLayerAndSortPositionInfo(QWidget * v);
+    static bool getAutoArrangeIncremental(QWidget * v);
     /**
-     * @brief getUnarrangedItemWithMaxLinks Get Unarranged item with max links
-     * @param v item container
-     * @return item with max links or nullptr if there is not item left
+     * @brief setIncrementalCount Set the incremental placements counter of the widget
+     * @param v widget
+     * @param count placements since the last full arrange
      */
-    static ItemWidget * getUnarrangedItemWithMaxLinks(QWidget * v);
+    static void setIncrementalCount(QWidget * v, int count);
     /**
-     * @brief assignLayerToItemsRecursively Assign layer to items recursively starting with layer zero in r0items
-     * @param layerZeroItems items to start the recursion, each item from this list will start with layer zero
+     * @brief relayoutThresholdCrossed Account one incremental placement and check the disruption threshold
+     * @param v widget
+     * @return true if the full layout should be executed
      */
-    static void assignLayerToItemsRecursively(QList<ItemWidget *> layerZeroItems);
+    static bool relayoutThresholdCrossed(QWidget * v);
     /**
-     * @brief getLayerZeroItems Get items marked with layer zero.
+     * @brief isFreeArea Check if the area in the container is inside it and not used by any other node
      * @param v container
-     * @return list of items.
+     * @param r area (relative to the container)
+     * @param siblings index of the other nodes of the container (see siblingsIndex)
+     * @return true if free
+     */
+    static bool isFreeArea(QWidget * v, const QRect & r, const SpatialIndex & siblings);
+    /**
+     * @brief siblingsIndex Index the geometry of the nodes of the container (built once per placement, queried by every probe)
+     * @param v container
+     * @param self node to be ignored
+     * @return spatial index
+     */
+    static SpatialIndex siblingsIndex(QWidget * v, AbstractNodeWidget * self);
+
+    /* Incremental placement */
+    /**
+     * @brief placeIncremental Slot a new item into the current layout without moving other nodes
+     * @param v items container
+     * @param item item to place
+     * @param linkedTo already placed item linked to the new one (or nullptr)
+     * @param mode algorithm
+     * @param spacing spacing between items
+     * @return 0 if succeed, otherwise the full layout is required
+     */
+    static int placeIncremental(QWidget * v, ItemWidget * item, ItemWidget * linkedTo, Mode mode, int spacing);
+    static int rowsPlace(QWidget * v, ItemWidget * item, int spacing);
+    static int columnsPlace(QWidget * v, ItemWidget * item, int spacing);
+    static int layeredPlace(QWidget * v, ItemWidget * item, ItemWidget * linkedTo, Mode mode, int spacing);
+    /**
+     * @brief getLayerZeroItems Get the items marked with layer zero, or when there is not any, the item with more links from each connected component.
+     * @param graph layout graph of the container
+     * @return list of node indexes (container order).
      */
-    static QList<ItemWidget *> getLayerZeroItems(QWidget * v);
+    static QVector<int> getLayerZeroItems(const LayoutGraph & graph);
     /**
      * @brief getLayerCount Get the layer count from the container
      * @param v container
@@ -98,44 +250,113 @@ private:
      */
     static int getLayerCount(QWidget * v);
     /**
-     * @brief getItemsFromLayer Get Items from an specific Layer
-     * @param v container
-     * @param layer layer number
-     * @return list of items that belongs to this layer
+     * @brief assignLayers Assign layers to the graph nodes breadth first, starting with layer zero in roots
+     * @param graph layout graph (layers and sort positions will be reset)
+     * @param roots layer zero nodes
+     * @return layer count
+     */
+    static int assignLayers(LayoutGraph * graph, const QVector<int> & roots);
+    /**
+     * @brief layeredLayout Compute the layered positions (horizontal tree, vertical tree or star) over the graph
+     * @param graph layout graph (positions, layers and sort positions will be filled)
+     * @param roots layer zero nodes
+     * @param mode ARRANGEALG_HTREE, ARRANGEALG_VTREE or ARRANGEALG_STAR
+     * @return 0 if succeed
+     */
+    static int layeredLayout(LayoutGraph * graph, const QVector<int> & roots, Mode mode);
+    /**
+     * @brief arrangeGraph Arrange the container items using a graph algorithm (see isGraphMode)
+     * @param v items container
+     * @param mode algorithm
+     * @return 0 if succeed
+     */
+    static int arrangeGraph(QWidget * v, Mode mode);
+    /**
+     * @brief hierarchical Arrange the contents of every group (deepest first, the groups of each level in parallel), size
+     *                     the groups to fit them, and then place the container nodes using the links between groups
+     * @param v items container
+     * @param spacing spacing between the top level nodes
+     * @return 0 if succeed
+     */
+    static int hierarchical(QWidget * v, int spacing);
+    /**
+     * @brief groupLayout Compute the positions of the contents of a group with his own algorithm (safe to call from any thread)
+     * @param graph group layout graph (see LayoutGraph::fromHierarchy)
+     * @param mode group algorithm (the algorithms that don't use the links will place the nodes in shelves)
+     * @param spacing group spacing
+     * @param size output group size required to fit the contents
+     * @return 0 if succeed
      */
-    static QList<ItemWidget *> getItemsFromLayer(QWidget * v, int layer);
+    static int groupLayout(LayoutGraph * graph, Mode mode, int spacing, QSize * size);
 
     /* Arrange Algorithms */
     /**
      * @brief horizontalTree Arrange using Horizonal Tree Topology
      * @param v items container
-     * @param layerZero first items to arrange
      * @return 0 if succeed
      */
-    static int horizontalTree(QWidget * v, QList<ItemWidget *> layerZero);
+    static int horizontalTree(QWidget * v);
     /**
      * @brief verticalTree Arrange using Vertical Tree Topology
      * @param v items container
-     * @param layerZero first items to arrange
      * @return 0 if succeed
      */
-    static int verticalTree(QWidget * v, QList<ItemWidget *> layerZero);
+    static int verticalTree(QWidget * v);
     /**
      * @brief star Arrange using star topology
      * @param v items container
-     * @param layerZero first items to arrange
      * @return 0 if succeed
      */
-    static int star(QWidget * v, QList<ItemWidget *> layerZero);
+    static int star(QWidget * v);
     /**
      * @brief random Arrange randomly in the space
      * @param v container
      * @return 0 if succeed
      */
     static int random(QWidget * v);
+    /**
+     * @brief stratified Arrange randomly but evenly spread (one node per cell of a jittered grid)
+     * @param v container
+     * @return 0 if succeed
+     */
+    static int stratified(QWidget * v);
 
-    // helper function:
-    static int rowsMover(QWidget *v, int spacing, SortBy sortBy, bool group, XY *accumulated);
+    /**
+     * @brief sortNodes Sort the nodes using the sort policy (by their cached sort keys)
+     * @param nodes nodes to be sorted (stable, nodes with the same key keep their order)
+     * @param sortBy sort by policy
+     * @return false if the sort policy is not valid
+     */
+    static bool sortNodes(QList<AbstractNodeWidget *> * nodes, SortBy sortBy);
+    /**
+     * @brief rowsPlacement Compute the positions of the boxes by rows (no widget is touched)
+     * @param sizes boxes sizes
+     * @param spacing spacing between boxes
+     * @param area container size, the width is expanded if a box does not fit, the height is set to the used height
+     * @param accumulated current row position, will be moved after the last row
+     * @return top left position for each box
+     */
+    static QVector<QPoint> rowsPlacement(const QVector<QSize> & sizes, int spacing, QSize * area, XY * accumulated);
+    /**
+     * @brief columnsPlacement Compute the positions of the boxes by columns (no widget is touched)
+     * @param sizes boxes sizes
+     * @param spacing spacing between boxes
+     * @param verticalOffset reserved pixels on the top of the container
+     * @param area container size, the height is expanded if a box does not fit, the width is set to the used width
+     * @param accumulated current column position, will be moved after the last column
+     * @return top left position for each box
+     */
+    static QVector<QPoint> columnsPlacement(const QVector<QSize> & sizes, int spacing, int verticalOffset, QSize * area, XY * accumulated);
+    /**
+     * @brief arrangeFlow Place the groups and then the items by rows, columns or shelves, moving every node
+     *                    once and resizing the container (at most) once
+     * @param v nodes container (will be resized)
+     * @param spacing spacing between nodes
+     * @param sortBy sort by policy
+     * @param mode ARRANGEALG_ROWS, ARRANGEALG_COLUMNS or ARRANGEALG_SHELVES
+     * @return 0 if succeed
+     */
+    static int arrangeFlow(QWidget * v, int spacing, SortBy sortBy, Mode mode);
     /**
      * @brief rows Arrange by rows
      * @param v nodes container (will be resized)
@@ -144,9 +365,6 @@ private:
      * @return 0 if succeed
      */
     static int rows(QWidget * v, int spacing, SortBy sortBy);
-
-    // helper function:
-    static int columnsMover(QWidget *v, int spacing, SortBy sortBy, bool group, XY *accumulated);
     /**
      * @brief columns Arrange by columns
      * @param v nodes container (will be resized)
@@ -155,6 +373,14 @@ private:
      * @return 0 if succeed
      */
     static int columns(QWidget * v, int spacing, SortBy sortBy);
+    /**
+     * @brief shelves Arrange in shelves, tallest nodes first, filling the gaps of the previous shelves (mixes heights efficiently)
+     * @param v nodes container (will be resized)
+     * @param spacing spacing between nodes
+     * @param sortBy sort by policy (for nodes with the same height)
+     * @return 0 if succeed
+     */
+    static int shelves(QWidget * v, int spacing, SortBy sortBy);
 };
 
 }
@@ -0,0 +1,660 @@
+#include "changejournal.h"
+#include "graphsnapshot.h"
+#include "graphwidget.h"
+#include "groupwidget.h"
+#include "itemwidget.h"
+#include "link.h"
+#include "nodedescriptor.h"
+
+#include <QDataStream>
+#include <QFile>
+
+using namespace QNodeGraph;
+
+// Journal file header
+#define JOURNAL_MAGIC 0x4A474E51
+#define JOURNAL_VERSION 1
+// Defaults
+#define JOURNAL_FLUSH_INTERVAL 2000
+#define JOURNAL_COMPACT_SIZE (4*1024*1024)
+
+namespace
+{
+
+// Journal records (every record is idempotent, so replaying a journal already included in the snapshot is harmless)
+enum RecordType {
+    JOURNAL_ICON=1,
+    JOURNAL_ADD=2,
+    JOURNAL_REMOVE=3,
+    JOURNAL_MOVE=4,
+    JOURNAL_RESTYLE=5,
+    JOURNAL_LINK=6,
+    JOURNAL_UNLINK=7,
+    JOURNAL_RENAME=8
+};
+
+// FNV-1a (32 bits), detects the blocks that were not completely written
+quint32 checksum(const QByteArray & data)
+{
+    quint32 hash = 0x811c9dc5;
+    for (int i=0; i<data.size(); i++)
+    {
+        hash ^= (unsigned char)data[i];
+        hash *= 0x01000193;
+    }
+    return hash;
+}
+
+bool isGroup(const QWidget * node)
+{
+    return node->objectName().startsWith("GROUP-");
+}
+
+void writeNodeState(QDataStream & out, const NodeDescriptor & node, const QString & embeddedData)
+{
+    out << node.properties << node.id << node.text << node.subText << node.description.getText() << node.pos
+        << node.textFont << node.subTextFont
+        << node.borderColor << node.selectedBorderColor << node.textColor << node.subTextColor << node.fillColor << node.fillColor2
+        << (qint32)node.fillMode << (qint32)node.borderRoundRectPixels << (quint8)node.anchored
+        << node.tags << (qint32)node.zoomOutLevel << node.iconKey << node.iconSize
+        << (qint32)node.textPosition << (qint32)node.shape << (quint8)node.belongsToLayerZero
+        << (qint32)node.textAlignFlags << (qint32)node.subTextAlignFlags << node.titleBackgroundColor
+        << (qint32)node.width << (qint32)node.height << embeddedData;
+}
+
+bool readNodeState(QDataStream & in, NodeDescriptor * node, QString * embeddedData)
+{
+    qint32 fillMode, borderRoundRectPixels, zoomOutLevel, textPosition, shape, textAlignFlags, subTextAlignFlags, width, height;
+    quint8 anchored, belongsToLayerZero;
+    QString description;
+
+    in >> node->properties >> node->id >> node->text >> node->subText >> description >> node->pos
+       >> node->textFont >> node->subTextFont
+       >> node->borderColor >> node->selectedBorderColor >> node->textColor >> node->subTextColor >> node->fillColor >> node->fillColor2
+       >> fillMode >> borderRoundRectPixels >> anchored
+       >> node->tags >> zoomOutLevel >> node->iconKey >> node->iconSize
+       >> textPosition >> shape >> belongsToLayerZero
+       >> textAlignFlags >> subTextAlignFlags >> node->titleBackgroundColor
+       >> width >> height >> *embeddedData;
+
+    node->description.setText(description);
+    node->fillMode = fillMode;
+    node->borderRoundRectPixels = borderRoundRectPixels;
+    node->anchored = anchored;
+    node->zoomOutLevel = zoomOutLevel;
+    node->textPosition = textPosition;
+    node->shape = shape;
+    node->belongsToLayerZero = belongsToLayerZero;
+    node->textAlignFlags = textAlignFlags;
+    node->subTextAlignFlags = subTextAlignFlags;
+    node->width = width;
+    node->height = height;
+
+    return in.status()==QDataStream::Ok;
+}
+
+class JournalWriter
+{
+public:
+    JournalWriter(IconTable * icons, const QSet<QString> * journaledIcons) : out(&payload, QIODevice::WriteOnly)
+    {
+        out.setVersion(QDataStream::Qt_5_0);
+        this->icons = icons;
+        this->journaledIcons = journaledIcons;
+    }
+
+    void writeNode(RecordType type, AbstractNodeWidget * node)
+    {
+        NodeDescriptor descriptor;
+        node->getNodeDescriptor(&descriptor);
+
+        if (!isGroup(node))
+        {
+            // Every distinct icon is stored once in the journal
+            ItemWidget * item = (ItemWidget *)node;
+            descriptor.iconKey = icons->add(item->getIcon(),descriptor.iconSize);
+            if (!descriptor.iconKey.isEmpty())
+            {
+                descriptor.properties |= NodeDescriptor::PROP_ICON;
+                if (!journaledIcons->contains(descriptor.iconKey) && !newIcons.contains(descriptor.iconKey))
+                {
+                    out << (quint8)JOURNAL_ICON << descriptor.iconKey << icons->getData(descriptor.iconKey);
+                    newIcons.insert(descriptor.iconKey);
+                }
+            }
+        }
+
+        out << (quint8)type;
+        if (type==JOURNAL_ADD)
+        {
+            QWidget * parent = node->parentWidget();
+            out << (quint8)isGroup(node) << (parent && isGroup(parent)? ((AbstractNodeWidget *)parent)->getID() : QString());
+        }
+        writeNodeState(out,descriptor,node->getEmbeddedData());
+    }
+
+    void writeMove(AbstractNodeWidget * node)
+    {
+        out << (quint8)JOURNAL_MOVE << node->getID() << node->pos() << node->size();
+    }
+
+    void writeLink(ItemWidget * item1, ItemWidget * item2)
+    {
+        for (auto _link : item1->getLinks())
+        {
+            Link * link = (Link *)_link;
+            if (link->getItem1()!=item2 && link->getItem2()!=item2)
+                continue;
+
+            out << (quint8)JOURNAL_LINK << ((ItemWidget *)link->getItem1())->getID() << ((ItemWidget *)link->getItem2())->getID()
+                << link->getDescription() << link->getColor() << (qint32)link->getType() << (qint32)link->getArcDirection();
+            return;
+        }
+        out << (quint8)JOURNAL_UNLINK << item1->getID() << item2->getID();
+    }
+
+    QByteArray payload;
+    QDataStream out;
+    QSet<QString> newIcons;
+
+private:
+    IconTable * icons;
+    const QSet<QString> * journaledIcons;
+};
+
+class JournalReader
+{
+public:
+    bool apply(const QByteArray & payload)
+    {
+        QDataStream in(payload);
+        in.setVersion(QDataStream::Qt_5_0);
+
+        while (!in.atEnd())
+        {
+            quint8 type;
+            in >> type;
+            if (in.status()!=QDataStream::Ok || !applyRecord(in,type))
+                return false;
+        }
+        return true;
+    }
+
+    GraphWidget * graph;
+    IconTable * icons;
+    QSet<QString> * journaledIcons;
+    QHash<QString, AbstractNodeWidget *> nodes;
+
+private:
+    ItemWidget * item(const QString & id) const
+    {
+        AbstractNodeWidget * node = nodes.value(id);
+        return node && !isGroup(node)? (ItemWidget *)node : nullptr;
+    }
+
+    bool applyRecord(QDataStream & in, quint8 type)
+    {
+        switch (type)
+        {
+        case JOURNAL_ICON:
+        {
+            QString key;
+            QByteArray png;
+            in >> key >> png;
+            icons->insert(key,png);
+            journaledIcons->insert(key);
+            return in.status()==QDataStream::Ok;
+        }
+        case JOURNAL_ADD:
+        case JOURNAL_RESTYLE:
+        {
+            quint8 group = 0;
+            QString parentId, embeddedData;
+            NodeDescriptor descriptor;
+            if (type==JOURNAL_ADD)
+                in >> group >> parentId;
+            if (!readNodeState(in,&descriptor,&embeddedData))
+                return false;
+
+            AbstractNodeWidget * node = nodes.value(descriptor.id);
+            if (!node)
+            {
+                if (type==JOURNAL_RESTYLE)
+                    return true;
+
+                if (group)
+                    node = new GroupWidget(descriptor.id,QSize(descriptor.width,descriptor.height),graph);
+                else
+                {
+                    AbstractNodeWidget * parent = nodes.value(parentId);
+                    if (!parentId.isEmpty() && (!parent || !isGroup(parent)))
+                        return false;
+                    node = new ItemWidget(descriptor.id, parent? (QWidget *)parent : (QWidget *)graph);
+                }
+                nodes.insert(descriptor.id,node);
+            }
+
+            node->setNodeDescriptor(descriptor,icons);
+            node->setEmbeddedData(embeddedData);
+            node->show();
+            return true;
+        }
+        case JOURNAL_REMOVE:
+        {
+            QString id;
+            in >> id;
+            AbstractNodeWidget * node = nodes.take(id);
+            if (node)
+            {
+                // The group items are destroyed with it
+                if (isGroup(node))
+                {
+                    for (auto i : GraphWidget::allChildrenItems(node))
+                        nodes.remove(i->getID());
+                }
+                delete node;
+            }
+            return in.status()==QDataStream::Ok;
+        }
+        case JOURNAL_RENAME:
+        {
+            QString oldId, newId;
+            in >> oldId >> newId;
+            // Renamed in place: the group items and the item links are kept
+            AbstractNodeWidget * node = nodes.take(oldId);
+            if (node)
+            {
+                node->setId(newId);
+                nodes.insert(newId,node);
+            }
+            return in.status()==QDataStream::Ok;
+        }
+        case JOURNAL_MOVE:
+        {
+            QString id;
+            QPoint pos;
+            QSize size;
+            in >> id >> pos >> size;
+            AbstractNodeWidget * node = nodes.value(id);
+            if (node)
+            {
+                node->move(pos);
+                if (isGroup(node))
+                    node->resize(size);
+            }
+            return in.status()==QDataStream::Ok;
+        }
+        case JOURNAL_LINK:
+        {
+            QString id1, id2, description;
+            QColor color;
+            qint32 linkType, direction;
+            in >> id1 >> id2 >> description >> color >> linkType >> direction;
+            ItemWidget * item1 = item(id1), * item2 = item(id2);
+            if (item1 && item2)
+                item1->linkItem(item2,description,color,(Link::Type)linkType,(Link::Direction)direction);
+            return in.status()==QDataStream::Ok;
+        }
+        case JOURNAL_UNLINK:
+        {
+            QString id1, id2;
+            in >> id1 >> id2;
+            ItemWidget * item1 = item(id1), * item2 = item(id2);
+            if (item1 && item2)
+            {
+                // The link object is shared by both items
+                item2->removeLink(item1,false);
+                item1->removeLink(item2,true);
+            }
+            return in.status()==QDataStream::Ok;
+        }
+        default:
+            return false;
+        }
+    }
+};
+
+}
+
+ChangeJournal::ChangeJournal(GraphWidget *graph)
+{
+    this->graph = graph;
+    full = false;
+    enabled = false;
+    compactSize = JOURNAL_COMPACT_SIZE;
+
+    timer.setSingleShot(true);
+    timer.setInterval(JOURNAL_FLUSH_INTERVAL);
+    QObject::connect(&timer, &QTimer::timeout, [this]() { flush(); });
+}
+
+int ChangeJournal::open(const QString &newFile)
+{
+    close();
+    clearPending();
+    icons = IconTable();
+    journaledIcons.clear();
+    file = newFile;
+
+    if (!QFile::exists(file))
+    {
+        // New file: the current graph is the starting point
+        enabled = true;
+        if (!compact())
+        {
+            close();
+            return -1;
+        }
+        return 1;
+    }
+
+    if (!GraphSnapshot::load(graph,file))
+    {
+        file.clear();
+        return -2;
+    }
+
+    enabled = true;
+
+    int r = replay();
+    if (r<0 && !resetJournal())
+    {
+        close();
+        return -3;
+    }
+    return 0;
+}
+
+void ChangeJournal::close()
+{
+    if (enabled)
+        flush();
+
+    timer.stop();
+    enabled = false;
+    clearPending();
+    file.clear();
+}
+
+bool ChangeJournal::flush()
+{
+    timer.stop();
+
+    if (!enabled)
+        return true;
+    if (full)
+    {
+        // A partial graph is not compacted, the load in progress ends with markAll()
+        if (graph->getLoading())
+        {
+            schedule();
+            return true;
+        }
+        return compact();
+    }
+    if (!getDirty())
+        return true;
+
+    JournalWriter writer(&icons,&journaledIcons);
+
+    // Removed and renamed first, in order (another node can be added with the same ID later)
+    for (const auto & ids : qAsConst(removedNodes))
+    {
+        if (ids.second.isEmpty())
+            writer.out << (quint8)JOURNAL_REMOVE << ids.first;
+        else
+            writer.out << (quint8)JOURNAL_RENAME << ids.first << ids.second;
+    }
+
+    // Groups are added before the items (that can be placed inside them)
+    for (int pass=0; pass<2; pass++)
+    {
+        for (auto it = dirtyNodes.constBegin(); it!=dirtyNodes.constEnd(); ++it)
+        {
+            if ((it.value() & CHANGE_ADDED) && isGroup(it.key())==(pass==0))
+                writer.writeNode(JOURNAL_ADD,it.key());
+        }
+    }
+    for (auto it = dirtyNodes.constBegin(); it!=dirtyNodes.constEnd(); ++it)
+    {
+        if (it.value() & CHANGE_ADDED)
+            continue;
+        // The restyle record already includes the position
+        if (it.value() & CHANGE_RESTYLED)
+            writer.writeNode(JOURNAL_RESTYLE,it.key());
+        else
+            writer.writeMove(it.key());
+    }
+
+    // Every link is marked on both items, written once
+    for (auto it = dirtyLinks.constBegin(); it!=dirtyLinks.constEnd(); ++it)
+    {
+        for (auto peer : it.value())
+        {
+            if ((quintptr)peer<(quintptr)it.key())
+                continue;
+            writer.writeLink((ItemWidget *)it.key(),(ItemWidget *)peer);
+        }
+    }
+
+    QFile f(getJournalFile());
+    if (!f.open(QIODevice::WriteOnly | QIODevice::Append))
+        return false;
+
+    // The block is written at once, a partial block is discarded on replay
+    QByteArray block;
+    QDataStream header(&block, QIODevice::WriteOnly);
+    header.setVersion(QDataStream::Qt_5_0);
+    header << (quint32)writer.payload.size() << checksum(writer.payload);
+    block.append(writer.payload);
+
+    if (f.write(block)!=block.size() || !f.flush())
+        return false;
+
+    journaledIcons.unite(writer.newIcons);
+    clearPending();
+
+    if (f.size()>=compactSize)
+    {
+        f.close();
+        return compact();
+    }
+    return true;
+}
+
+bool ChangeJournal::compact()
+{
+    timer.stop();
+
+    if (!enabled)
+        return false;
+
+    // The snapshot is replaced at once, if the journal reset fails the old records are replayed on top of it
+    if (!GraphSnapshot::save(graph,file) || !resetJournal())
+    {
+        schedule();
+        return false;
+    }
+
+    clearPending();
+    return true;
+}
+
+void ChangeJournal::markNode(AbstractNodeWidget *node, Change change)
+{
+    if (!enabled || full || graph->getLoading())
+        return;
+
+    dirtyNodes[node] |= change;
+    schedule();
+}
+
+void ChangeJournal::markRenamed(AbstractNodeWidget *node, const QString &oldId)
+{
+    if (!enabled || full || graph->getLoading())
+        return;
+
+    // Nodes added after the last flush are written with the new ID
+    if (!(dirtyNodes.value(node) & CHANGE_ADDED))
+    {
+        removedNodes.append(qMakePair(oldId,node->getID()));
+        schedule();
+    }
+}
+
+void ChangeJournal::markRemoved(AbstractNodeWidget *node)
+{
+    if (!enabled || full || graph->getLoading())
+        return;
+
+    // Nodes added after the last flush are just forgotten
+    if (!(dirtyNodes.take(node) & CHANGE_ADDED))
+        removedNodes.append(qMakePair(node->getID(),QString()));
+
+    // The links are removed with the node
+    for (auto peer : dirtyLinks.take(node))
+        dirtyLinks[peer].remove(node);
+    schedule();
+}
+
+void ChangeJournal::markLink(AbstractNodeWidget *item1, AbstractNodeWidget *item2)
+{
+    if (!enabled || full || graph->getLoading() || !item1 || !item2)
+        return;
+
+    dirtyLinks[item1].insert(item2);
+    dirtyLinks[item2].insert(item1);
+    schedule();
+}
+
+void ChangeJournal::markAll()
+{
+    if (!enabled)
+        return;
+
+    clearPending();
+    full = true;
+    schedule();
+}
+
+bool ChangeJournal::getEnabled() const
+{
+    return enabled;
+}
+
+bool ChangeJournal::getDirty() const
+{
+    return full || !dirtyNodes.isEmpty() || !dirtyLinks.isEmpty() || !removedNodes.isEmpty();
+}
+
+QString ChangeJournal::getFile() const
+{
+    return file;
+}
+
+QString ChangeJournal::getJournalFile() const
+{
+    if (file.isEmpty())
+        return QString();
+    return file + ".journal";
+}
+
+int ChangeJournal::getFlushInterval() const
+{
+    return timer.interval();
+}
+
+void ChangeJournal::setFlushInterval(int newFlushInterval)
+{
+    timer.setInterval(newFlushInterval);
+}
+
+qint64 ChangeJournal::getCompactSize() const
+{
+    return compactSize;
+}
+
+void ChangeJournal::setCompactSize(qint64 newCompactSize)
+{
+    compactSize = newCompactSize;
+}
+
+int ChangeJournal::replay()
+{
+    QFile f(getJournalFile());
+    if (!f.exists())
+        return -1;
+    if (!f.open(QIODevice::ReadWrite))
+        return -2;
+
+    QDataStream in(&f);
+    in.setVersion(QDataStream::Qt_5_0);
+
+    quint32 magic, version;
+    in >> magic >> version;
+    if (in.status()!=QDataStream::Ok || magic!=JOURNAL_MAGIC || version!=JOURNAL_VERSION)
+        return -3;
+
+    JournalReader reader;
+    reader.graph = graph;
+    reader.icons = &icons;
+    reader.journaledIcons = &journaledIcons;
+    for (auto node : GraphWidget::allRecursiveItemsAndGroups(graph))
+        reader.nodes.insert(node->getID(),node);
+
+    // Nothing is arranged or journaled while replaying
+    graph->setLoading(true);
+
+    int blocks = 0;
+    qint64 validSize = f.pos();
+    while (!in.atEnd())
+    {
+        quint32 size, sum;
+        in >> size >> sum;
+        if (in.status()!=QDataStream::Ok || size>f.size()-f.pos())
+            break;
+
+        QByteArray payload = f.read(size);
+        if ((quint32)payload.size()!=size || checksum(payload)!=sum || !reader.apply(payload))
+            break;
+
+        validSize = f.pos();
+        blocks++;
+    }
+
+    graph->setLoading(false);
+    graph->update();
+
+    // New blocks are appended after the last valid one
+    if (validSize<f.size())
+        f.resize(validSize);
+    return blocks;
+}
+
+bool ChangeJournal::resetJournal()
+{
+    QFile f(getJournalFile());
+    if (!f.open(QIODevice::WriteOnly | QIODevice::Truncate))
+        return false;
+
+    QDataStream out(&f);
+    out.setVersion(QDataStream::Qt_5_0);
+    out << (quint32)JOURNAL_MAGIC << (quint32)JOURNAL_VERSION;
+
+    journaledIcons.clear();
+    return out.status()==QDataStream::Ok && f.flush();
+}
+
+void ChangeJournal::clearPending()
+{
+    dirtyNodes.clear();
+    dirtyLinks.clear();
+    removedNodes.clear();
+    full = false;
+}
+
+void ChangeJournal::schedule()
+{
+    if (!timer.isActive())
+        timer.start();
+}
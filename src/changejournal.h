@@ -0,0 +1,174 @@
+#ifndef CHANGEJOURNAL_H
+#define CHANGEJOURNAL_H
+
+#include <QHash>
+#include <QSet>
+#include <QString>
+#include <QStringList>
+#include <QTimer>
+
+#include "icontable.h"
+
+namespace QNodeGraph
+{
+
+class GraphWidget;
+class AbstractNodeWidget;
+
+/**
+ * @brief The ChangeJournal class Incremental autosave of a graph: a snapshot file plus an append-only journal
+ *
+ * While open, the nodes and links changed since the last flush are only marked as dirty (the marks of the
+ * same node or link are merged). The flush timer appends their current state to the journal (<file>.journal)
+ * as one checksummed block, so the autosave cost is proportional to what changed and not to the graph size.
+ * When the journal grows over the compact size, the whole graph is written into the snapshot (see GraphSnapshot)
+ * and the journal starts again. Opening the file loads the snapshot and replays the journal on top of it
+ * (an incomplete block at the end, eg. after a crash, is discarded).
+ */
+class ChangeJournal
+{
+public:
+    enum Change {
+        CHANGE_ADDED=1,
+        CHANGE_MOVED=2,
+        CHANGE_RESTYLED=4
+    };
+
+    ChangeJournal(GraphWidget * graph);
+
+    /**
+     * @brief open Load the graph from a snapshot file and its journal, and start journaling the changes
+     * @param newFile snapshot file
+     * @return 0 if loaded, 1 if the file does not exist yet (the current graph is saved into it), negative on errors
+     */
+    int open(const QString & newFile);
+    /**
+     * @brief close Flush the pending changes and stop journaling
+     */
+    void close();
+    /**
+     * @brief flush Append the pending changes to the journal (compacted when the journal is too big)
+     * @return true if succeed (the changes are kept pending on errors)
+     */
+    bool flush();
+    /**
+     * @brief compact Write the whole graph into the snapshot file and start an empty journal
+     * @return true if succeed
+     */
+    bool compact();
+
+    /**
+     * @brief markNode Mark a node as changed
+     * @param node item or group
+     * @param change change
+     */
+    void markNode(AbstractNodeWidget * node, Change change);
+    /**
+     * @brief markRenamed Mark a node as renamed (journaled as a rename record, the node and his contents are kept on replay)
+     * @param node item or group
+     * @param oldId ID before the change
+     */
+    void markRenamed(AbstractNodeWidget * node, const QString & oldId);
+    /**
+     * @brief markRemoved Mark a node as removed (called when destroyed)
+     * @param node item or group
+     */
+    void markRemoved(AbstractNodeWidget * node);
+    /**
+     * @brief markLink Mark the link between two items as changed (created, modified or removed)
+     * @param item1 item
+     * @param item2 linked item
+     */
+    void markLink(AbstractNodeWidget * item1, AbstractNodeWidget * item2);
+    /**
+     * @brief markAll Mark the whole graph as changed (eg. replaced by a document), the next flush compacts
+     *                (deferred while the graph is loading, mark it again when the load ends)
+     */
+    void markAll();
+
+    /**
+     * @brief getEnabled Get if the changes are being journaled (a file is open)
+     * @return true if enabled
+     */
+    bool getEnabled() const;
+    /**
+     * @brief getDirty Get if there are changes not flushed yet
+     * @return true if dirty
+     */
+    bool getDirty() const;
+
+    /**
+     * @brief getFile Get the snapshot file
+     * @return file path (empty if not open)
+     */
+    QString getFile() const;
+    /**
+     * @brief getJournalFile Get the journal file
+     * @return file path (empty if not open)
+     */
+    QString getJournalFile() const;
+
+    /**
+     * @brief getFlushInterval Get the time between the first pending change and the flush
+     * @return milliseconds
+     */
+    int getFlushInterval() const;
+    /**
+     * @brief setFlushInterval Set the time between the first pending change and the flush
+     * @param newFlushInterval milliseconds
+     */
+    void setFlushInterval(int newFlushInterval);
+
+    /**
+     * @brief getCompactSize Get the journal size that triggers the compaction
+     * @return bytes
+     */
+    qint64 getCompactSize() const;
+    /**
+     * @brief setCompactSize Set the journal size that triggers the compaction
+     * @param newCompactSize bytes
+     */
+    void setCompactSize(qint64 newCompactSize);
+
+private:
+    /**
+     * @brief replay Apply the journal blocks to the graph (the journal is truncated after the last valid block)
+     * @return blocks applied, negative on errors
+     */
+    int replay();
+    /**
+     * @brief resetJournal Start an empty journal file
+     * @return true if succeed
+     */
+    bool resetJournal();
+    /**
+     * @brief clearPending Forget the pending changes
+     */
+    void clearPending();
+    /**
+     * @brief schedule Start the flush timer (if not started yet)
+     */
+    void schedule();
+
+    GraphWidget * graph;
+    QTimer timer;
+
+    // Pending changes (merged until the next flush)
+    QHash<AbstractNodeWidget *, int> dirtyNodes;
+    QHash<AbstractNodeWidget *, QSet<AbstractNodeWidget *> > dirtyLinks;
+    // Removed (empty new ID) and renamed nodes by ID, in order
+    QList<QPair<QString, QString> > removedNodes;
+    bool full;
+
+    // Icons already stored in the current journal
+    IconTable icons;
+    QSet<QString> journaledIcons;
+
+    QString file;
+    bool enabled;
+    qint64 compactSize;
+};
+
+}
+
+#endif // CHANGEJOURNAL_H
@@ -0,0 +1,471 @@
+#include "edgerouter.h"
+#include "itemwidget.h"
+#include "graphwidget.h"
+#include "link.h"
+#include "parallel.h"
+
+#include <algorithm>
+#include <climits>
+#include <cstdlib>
+#include <functional>
+#include <queue>
+#include <tuple>
+#include <vector>
+
+using namespace QNodeGraph;
+
+// Obstacle index cell size in pixels
+#define ROUTER_CELL_SIZE 128
+// Cost of a bend (in pixels of route length)
+#define ROUTER_BEND_PENALTY 24
+// Area searched around the link endpoints (grows when there is no route inside)
+#define ROUTER_SEARCH_MARGIN 96
+#define ROUTER_SEARCH_TRIES 3
+// Links near more obstacles than this are drawn straight (keeps the grid small)
+#define ROUTER_MAX_OBSTACLES 150
+// Above this many changed areas every route is computed again instead of checking them one by one
+#define ROUTER_MAX_DIRTY 64
+
+EdgeRouter::EdgeRouter(GraphWidget *graph)
+{
+    this->graph = graph;
+    rebuild = true;
+    margin = 8;
+    enabled = false;
+}
+
+void EdgeRouter::markNode(AbstractNodeWidget *node)
+{
+    if (!enabled || rebuild)
+        return;
+
+    if (node->objectName().startsWith("ITEM-"))
+        dirtyItems.insert((ItemWidget *)node);
+    else
+    {
+        // The items inside the group moved with it
+        for (auto item : GraphWidget::allRecursiveItems(node))
+            dirtyItems.insert(item);
+    }
+}
+
+void EdgeRouter::markRemoved(ItemWidget *item)
+{
+    dirtyItems.remove(item);
+
+    auto it = obstacles.find(item);
+    if (it==obstacles.end())
+        return;
+    dirtyAreas.append(*it);
+    indexRemove(item,*it);
+    obstacles.erase(it);
+}
+
+void EdgeRouter::markLink(Link *link)
+{
+    if (enabled && !rebuild)
+        dirtyLinks.insert(link);
+}
+
+void EdgeRouter::removeLink(Link *link)
+{
+    dirtyLinks.remove(link);
+    routes.remove(link);
+}
+
+void EdgeRouter::update()
+{
+    if (!enabled)
+        return;
+
+    // Links to be routed again
+    QSet<Link *> pending;
+
+    if (rebuild)
+    {
+        obstacles.clear();
+        cells.clear();
+        routes.clear();
+        for (auto item : GraphWidget::allRecursiveItems(graph))
+        {
+            syncItem(item,nullptr);
+            for (auto _link : item->getLinks())
+            {
+                Link * link = (Link *)_link;
+                if (link->getItem1()==item)
+                    pending.insert(link);
+            }
+        }
+    }
+    else
+    {
+        if (dirtyItems.isEmpty() && dirtyLinks.isEmpty() && dirtyAreas.isEmpty())
+            return;
+
+        // Old and new geometries of the items that changed (and of the removed ones)
+        QVector<QRect> dirty = dirtyAreas;
+        pending = dirtyLinks;
+        for (auto item : qAsConst(dirtyItems))
+        {
+            if (!syncItem(item,&dirty))
+                continue;
+            for (auto _link : item->getLinks())
+                pending.insert((Link *)_link);
+        }
+
+        // Routes passing near a change
+        bool everything = dirty.count()>ROUTER_MAX_DIRTY;
+        for (QRect & r : dirty)
+            r.adjust(-margin-1,-margin-1,margin+1,margin+1);
+        for (auto it=routes.constBegin(); it!=routes.constEnd(); ++it)
+        {
+            if (pending.contains(it.key()))
+                continue;
+
+            bool affected = everything;
+            for (int d=0; !affected && d<dirty.count(); d++)
+                affected = routeIntersects(*it,dirty[d]);
+            if (affected)
+                pending.insert(it.key());
+        }
+    }
+
+    rebuild = false;
+    dirtyItems.clear();
+    dirtyLinks.clear();
+    dirtyAreas.clear();
+
+    QVector<Request> requests;
+    requests.reserve(pending.count());
+    for (auto link : qAsConst(pending))
+        requests.append(makeRequest(link));
+
+    // The searches only read the obstacles, so they run in parallel
+    QVector<QPolygon> results(requests.count());
+    const Request * requestsData = requests.constData();
+    QPolygon * resultsData = results.data();
+    Parallel::forEach(requests.count(), [this,requestsData,resultsData](int i) {
+        resultsData[i] = route(requestsData[i]);
+    });
+
+    for (int i=0; i<requests.count(); i++)
+    {
+        Route r;
+        r.points = results[i];
+        r.bounds = r.points.boundingRect();
+        routes.insert(requests[i].link,r);
+    }
+}
+
+const QPolygon *EdgeRouter::getRoute(Link *link) const
+{
+    if (!enabled)
+        return nullptr;
+
+    auto it = routes.constFind(link);
+    if (it==routes.constEnd() || it->points.count()<2)
+        return nullptr;
+    return &it->points;
+}
+
+void EdgeRouter::clear()
+{
+    obstacles.clear();
+    cells.clear();
+    routes.clear();
+    dirtyItems.clear();
+    dirtyLinks.clear();
+    dirtyAreas.clear();
+    rebuild = true;
+}
+
+bool EdgeRouter::getEnabled() const
+{
+    return enabled;
+}
+
+void EdgeRouter::setEnabled(bool newEnabled)
+{
+    enabled = newEnabled;
+    if (!enabled)
+        clear();
+}
+
+int EdgeRouter::getMargin() const
+{
+    return margin;
+}
+
+void EdgeRouter::setMargin(int newMargin)
+{
+    // The obstacles are indexed with the margin
+    clear();
+    margin = std::max(0,newMargin);
+}
+
+QPolygon EdgeRouter::route(const Request &request) const
+{
+    if (request.from==request.to)
+        return QPolygon();
+
+    QRect area = QRect(request.from,request.to).normalized().adjusted(-ROUTER_SEARCH_MARGIN,-ROUTER_SEARCH_MARGIN,
+                                                                      ROUTER_SEARCH_MARGIN,ROUTER_SEARCH_MARGIN);
+    for (int t=0; t<ROUTER_SEARCH_TRIES; t++)
+    {
+        bool crowded = false;
+        QPolygon points = search(request,area,&crowded);
+        // A larger area would have even more obstacles: drawn straight
+        if (!points.isEmpty() || crowded)
+            return points;
+
+        int dx = area.width()/2, dy = area.height()/2;
+        area.adjust(-dx,-dy,dx,dy);
+    }
+    return QPolygon();
+}
+
+QPolygon EdgeRouter::search(const Request &request, const QRect &area, bool *crowded) const
+{
+    // Obstacles near the area (an item is registered in every cell it touches)
+    QVector<const ItemWidget *> nearItems;
+    for (int cy=cellOf(area.top()); cy<=cellOf(area.bottom()); cy++)
+    {
+        for (int cx=cellOf(area.left()); cx<=cellOf(area.right()); cx++)
+        {
+            auto cell = cells.constFind(cellKey(cx,cy));
+            if (cell!=cells.constEnd())
+                nearItems += *cell;
+        }
+    }
+    std::sort(nearItems.begin(),nearItems.end());
+    nearItems.erase(std::unique(nearItems.begin(),nearItems.end()),nearItems.end());
+
+    QVector<QRect> blocks;
+    for (auto item : nearItems)
+    {
+        if (item==request.item1 || item==request.item2)
+            continue;
+
+        QRect r = obstacles.constFind(item)->adjusted(-margin,-margin,margin,margin);
+        // Endpoints covered by other items (overlapped nodes) could not be left
+        if (!r.intersects(area) || r.contains(request.from) || r.contains(request.to))
+            continue;
+        blocks.append(r);
+    }
+    if (blocks.count()>ROUTER_MAX_OBSTACLES)
+    {
+        *crowded = true;
+        return QPolygon();
+    }
+
+    // Sparse grid inside the area: the lines of the obstacle borders and the endpoints
+    QVector<int> xs, ys;
+    xs << request.from.x() << request.to.x() << area.left() << area.right();
+    ys << request.from.y() << request.to.y() << area.top() << area.bottom();
+    for (const QRect & r : blocks)
+    {
+        if (r.left()>=area.left()) xs << r.left();
+        if (r.right()<=area.right()) xs << r.right();
+        if (r.top()>=area.top()) ys << r.top();
+        if (r.bottom()<=area.bottom()) ys << r.bottom();
+    }
+    std::sort(xs.begin(),xs.end());
+    xs.erase(std::unique(xs.begin(),xs.end()),xs.end());
+    std::sort(ys.begin(),ys.end());
+    ys.erase(std::unique(ys.begin(),ys.end()),ys.end());
+
+    auto indexOf = [](const QVector<int> & values, int v) -> int {
+        return std::lower_bound(values.begin(),values.end(),v)-values.begin();
+    };
+
+    int gx = xs.count(), gy = ys.count();
+
+    // Grid segments crossing the inside of an obstacle (the borders themselves are free)
+    // horizontal: (i,j)-(i+1,j), vertical: (i,j)-(i,j+1)
+    // Borders outside the area are at index -1 or gx/gy, so the area borders crossing them are blocked
+    QVector<char> hBlocked(gx*gy,0), vBlocked(gx*gy,0);
+    for (const QRect & r : blocks)
+    {
+        int i0 = r.left()<area.left()? -1 : indexOf(xs,r.left());
+        int i1 = r.right()>area.right()? gx : indexOf(xs,r.right());
+        int j0 = r.top()<area.top()? -1 : indexOf(ys,r.top());
+        int j1 = r.bottom()>area.bottom()? gy : indexOf(ys,r.bottom());
+        for (int j=j0+1; j<std::min(j1,gy); j++)
+        {
+            for (int i=std::max(i0,0); i<std::min(i1,gx-1); i++)
+                hBlocked[j*gx+i] = 1;
+        }
+        for (int i=i0+1; i<std::min(i1,gx); i++)
+        {
+            for (int j=std::max(j0,0); j<std::min(j1,gy-1); j++)
+                vBlocked[j*gx+i] = 1;
+        }
+    }
+
+    // A* over (grid point, direction of arrival) so the bends can be penalized
+    int start = indexOf(ys,request.from.y())*gx + indexOf(xs,request.from.x());
+    int goal = indexOf(ys,request.to.y())*gx + indexOf(xs,request.to.x());
+    const int * x = xs.constData();
+    const int * y = ys.constData();
+    int tx = request.to.x(), ty = request.to.y();
+    // Remaining length plus the bends that are needed for sure
+    auto heuristic = [x,y,gx,tx,ty](int state) -> int {
+        int node = state/2;
+        int dx = x[node%gx]-tx, dy = y[node/gx]-ty;
+        int bends = (dx!=0 && dy!=0) || (dx==0 && dy!=0 && state%2==0) || (dy==0 && dx!=0 && state%2==1);
+        return abs(dx) + abs(dy) + bends*ROUTER_BEND_PENALTY;
+    };
+
+    QVector<int> cost(gx*gy*2,INT_MAX), parent(gx*gy*2,-1);
+    // (estimated total, estimated remaining, state): on ties the nearest to the goal goes first,
+    // otherwise every path of the same length (there are many on a grid) would be explored
+    typedef std::tuple<int,int,int> Entry;
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> open;
+    cost[start*2] = cost[start*2+1] = 0;
+    open.push(Entry(heuristic(start*2),heuristic(start*2),start*2));
+    open.push(Entry(heuristic(start*2+1),heuristic(start*2+1),start*2+1));
+
+    int found = -1;
+    while (!open.empty())
+    {
+        Entry e = open.top();
+        open.pop();
+
+        int state = std::get<2>(e), node = state/2, dir = state%2;
+        int g = cost[state];
+        if (std::get<0>(e)>g+std::get<1>(e))
+            continue;
+        if (node==goal)
+        {
+            found = state;
+            break;
+        }
+
+        int i = node%gx, j = node/gx;
+        auto relax = [&](int next, int nextDir, int length) {
+            int ng = g + length + (nextDir!=dir? ROUTER_BEND_PENALTY : 0);
+            int ns = next*2+nextDir;
+            if (ng<cost[ns])
+            {
+                cost[ns] = ng;
+                parent[ns] = state;
+                int h = heuristic(ns);
+                open.push(Entry(ng+h,h,ns));
+            }
+        };
+        if (i>0 && !hBlocked[j*gx+i-1])
+            relax(node-1,0,x[i]-x[i-1]);
+        if (i<gx-1 && !hBlocked[j*gx+i])
+            relax(node+1,0,x[i+1]-x[i]);
+        if (j>0 && !vBlocked[(j-1)*gx+i])
+            relax(node-gx,1,y[j]-y[j-1]);
+        if (j<gy-1 && !vBlocked[j*gx+i])
+            relax(node+gx,1,y[j+1]-y[j]);
+    }
+
+    if (found<0)
+        return QPolygon();
+
+    // Walk back keeping only the bends
+    QPolygon points;
+    for (int state=found; state>=0; state=parent[state])
+    {
+        int node = state/2;
+        QPoint p(x[node%gx],y[node/gx]);
+        int n = points.count();
+        if (n>=2 && ((points[n-2].x()==p.x() && points[n-1].x()==p.x()) ||
+                     (points[n-2].y()==p.y() && points[n-1].y()==p.y())))
+            points[n-1] = p;
+        else
+            points.append(p);
+    }
+    std::reverse(points.begin(),points.end());
+    return points;
+}
+
+EdgeRouter::Request EdgeRouter::makeRequest(Link *link)
+{
+    ItemWidget * item1 = (ItemWidget *)link->getItem1();
+    ItemWidget * item2 = (ItemWidget *)link->getItem2();
+    bool undirected = link->getType()==Link::TYPE_UNDIRECTED;
+
+    Request request;
+    request.link = link;
+    request.item1 = item1;
+    request.item2 = item2;
+    request.from = item1->getAbsolutePos() + (undirected? item1->getIconCenterPoint() : item1->getCenterPoint());
+    request.to = item2->getAbsolutePos() + (undirected? item2->getIconCenterPoint() : item2->getCenterPoint());
+    return request;
+}
+
+bool EdgeRouter::syncItem(const ItemWidget *item, QVector<QRect> *dirty)
+{
+    QRect r(item->getAbsolutePos(), item->size());
+
+    auto it = obstacles.find(item);
+    if (it!=obstacles.end())
+    {
+        if (*it==r)
+            return false;
+        if (dirty)
+            dirty->append(*it);
+        indexRemove(item,*it);
+        *it = r;
+    }
+    else
+        obstacles.insert(item,r);
+
+    if (dirty)
+        dirty->append(r);
+    indexInsert(item,r);
+    return true;
+}
+
+bool EdgeRouter::routeIntersects(const Route &route, const QRect &r)
+{
+    // Links drawn straight (no route in their area) are only routed again when their items move
+    if (route.points.isEmpty() || !route.bounds.intersects(r))
+        return false;
+    for (int i=1; i<route.points.count(); i++)
+    {
+        if (QRect(route.points[i-1],route.points[i]).normalized().intersects(r))
+            return true;
+    }
+    return false;
+}
+
+void EdgeRouter::indexInsert(const ItemWidget *item, const QRect &r)
+{
+    for (int cy=cellOf(r.top()-margin); cy<=cellOf(r.bottom()+margin); cy++)
+    {
+        for (int cx=cellOf(r.left()-margin); cx<=cellOf(r.right()+margin); cx++)
+            cells[cellKey(cx,cy)].append(item);
+    }
+}
+
+void EdgeRouter::indexRemove(const ItemWidget *item, const QRect &r)
+{
+    for (int cy=cellOf(r.top()-margin); cy<=cellOf(r.bottom()+margin); cy++)
+    {
+        for (int cx=cellOf(r.left()-margin); cx<=cellOf(r.right()+margin); cx++)
+        {
+            auto cell = cells.find(cellKey(cx,cy));
+            if (cell==cells.end())
+                continue;
+            cell->removeOne(item);
+            if (cell->isEmpty())
+                cells.erase(cell);
+        }
+    }
+}
+
+qint64 EdgeRouter::cellKey(int cx, int cy)
+{
+    return (((qint64)cx)<<32) | ((quint32)cy);
+}
+
+int EdgeRouter::cellOf(int coordinate) const
+{
+    // floor division (coordinates can be negative)
+    return coordinate>=0 ? coordinate/ROUTER_CELL_SIZE : -((-coordinate+ROUTER_CELL_SIZE-1)/ROUTER_CELL_SIZE);
+}
@@ -0,0 +1,162 @@
+#ifndef EDGEROUTER_H
+#define EDGEROUTER_H
+
+#include <QHash>
+#include <QSet>
+#include <QList>
+#include <QVector>
+#include <QRect>
+#include <QPoint>
+#include <QPolygon>
+
+namespace QNodeGraph
+{
+
+class GraphWidget;
+class AbstractNodeWidget;
+class ItemWidget;
+class Link;
+
+/**
+ * @brief The EdgeRouter class Orthogonal link routes around the items, cached per link
+ *
+ * Every route is an A* search over a sparse grid made from the borders (plus a margin) of the items
+ * near the link, with a penalty for each bend. The routes are kept between paints: the nodes and links
+ * mark their changes, and only the routes of the moved items, or those passing near them, are computed
+ * again (the paints without changes only read the cached routes).
+ */
+class EdgeRouter
+{
+public:
+    EdgeRouter(GraphWidget * graph);
+
+    /**
+     * @brief markNode Mark a node as moved, resized or created (for groups, every item inside them)
+     * @param node item or group
+     */
+    void markNode(AbstractNodeWidget * node);
+    /**
+     * @brief markRemoved Forget an item being destroyed (the routes passing near it are computed again)
+     * @param item item
+     */
+    void markRemoved(ItemWidget * item);
+    /**
+     * @brief markLink Mark a link as created or modified
+     * @param link link
+     */
+    void markLink(Link * link);
+    /**
+     * @brief removeLink Forget a link removed from his items
+     * @param link link
+     */
+    void removeLink(Link * link);
+
+    /**
+     * @brief update Compute again the routes affected by the marked changes (nothing to do if there are not changes)
+     */
+    void update();
+    /**
+     * @brief getRoute Get the route of a link (after update)
+     * @param link link
+     * @return polyline from the first item to the second one, or nullptr if the link has to be drawn straight
+     */
+    const QPolygon * getRoute(Link * link) const;
+    /**
+     * @brief clear Remove every route and item geometry (everything is computed again on the next update)
+     */
+    void clear();
+
+    /**
+     * @brief getEnabled Get if the links are routed
+     * @return true if enabled
+     */
+    bool getEnabled() const;
+    /**
+     * @brief setEnabled Enable or disable the routing (disabling it removes the cached routes)
+     * @param newEnabled true to enable
+     */
+    void setEnabled(bool newEnabled);
+
+    /**
+     * @brief getMargin Get the distance kept between the routes and the items
+     * @return margin in pixels
+     */
+    int getMargin() const;
+    /**
+     * @brief setMargin Set the distance kept between the routes and the items (every route is computed again)
+     * @param newMargin margin in pixels
+     */
+    void setMargin(int newMargin);
+
+private:
+    struct Route
+    {
+        QPolygon points;
+        QRect bounds;
+    };
+    struct Request
+    {
+        Link * link;
+        QPoint from, to;
+        const ItemWidget * item1, * item2;
+    };
+
+    /**
+     * @brief route Find an orthogonal route between two points
+     * @param request link endpoints (the routes can cross the linked items)
+     * @return polyline (empty if there is no route)
+     */
+    QPolygon route(const Request & request) const;
+    /**
+     * @brief search A* search over the grid made from the obstacles found in an area
+     * @param request link endpoints
+     * @param area search area
+     * @param crowded output, true when the area has too many obstacles (larger areas will not be searched)
+     * @return polyline (empty if there is no route inside the area)
+     */
+    QPolygon search(const Request & request, const QRect & area, bool * crowded) const;
+    /**
+     * @brief makeRequest Get the endpoints of a link
+     * @param link link
+     * @return request
+     */
+    static Request makeRequest(Link * link);
+    /**
+     * @brief syncItem Index the current geometry of an item
+     * @param item item
+     * @param dirty output, old and new geometry if changed
+     * @return true if the geometry changed (or the item is new)
+     */
+    bool syncItem(const ItemWidget * item, QVector<QRect> * dirty);
+
+    /**
+     * @brief routeIntersects Check if any segment of a route intersects a rectangle
+     * @param route route
+     * @param r rectangle
+     * @return true if intersects
+     */
+    static bool routeIntersects(const Route & route, const QRect & r);
+
+    void indexInsert(const ItemWidget * item, const QRect & r);
+    void indexRemove(const ItemWidget * item, const QRect & r);
+    static qint64 cellKey(int cx, int cy);
+    int cellOf(int coordinate) const;
+
+    GraphWidget * graph;
+    QHash<const ItemWidget *, QRect> obstacles;
+    QHash<qint64, QVector<const ItemWidget *>> cells;
+    QHash<Link *, Route> routes;
+
+    // Changes since the last update (everything when rebuild is set)
+    QSet<ItemWidget *> dirtyItems;
+    QSet<Link *> dirtyLinks;
+    QVector<QRect> dirtyAreas;
+    bool rebuild;
+
+    int margin;
+    bool enabled;
+};
+
+}
+
+#endif // EDGEROUTER_H
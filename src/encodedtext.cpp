@@ -0,0 +1,54 @@
+#include "encodedtext.h"
+
+using namespace QNodeGraph;
+
+EncodedText::EncodedText()
+{
+    decoded = true;
+}
+
+EncodedText EncodedText::fromBase64(const QByteArray &encoded)
+{
+    EncodedText r;
+    r.encoded = encoded;
+    r.decoded = encoded.isEmpty();
+    return r;
+}
+
+const QString &EncodedText::getText() const
+{
+    if (!decoded)
+    {
+        QByteArray utf8 = QByteArray::fromBase64(encoded);
+        text = QString::fromUtf8(utf8.constData(),utf8.size());
+        decoded = true;
+    }
+    return text;
+}
+
+void EncodedText::setText(const QString &text)
+{
+    this->text = text;
+    encoded.clear();
+    decoded = true;
+}
+
+QByteArray EncodedText::toBase64() const
+{
+    // Not modified since it was read
+    if (!encoded.isEmpty())
+        return encoded;
+    return text.toUtf8().toBase64();
+}
+
+bool EncodedText::isEmpty() const
+{
+    return decoded? text.isEmpty() : encoded.isEmpty();
+}
+
+bool EncodedText::equals(const EncodedText &other) const
+{
+    if (!encoded.isEmpty() && !other.encoded.isEmpty())
+        return encoded==other.encoded;
+    return getText()==other.getText();
+}
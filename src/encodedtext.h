@@ -0,0 +1,64 @@
+#ifndef ENCODEDTEXT_H
+#define ENCODEDTEXT_H
+
+#include <QString>
+#include <QByteArray>
+
+namespace QNodeGraph
+{
+
+/**
+ * @brief The EncodedText class Text kept as read from a document (base64 encoded UTF-8) until it's used
+ *
+ * Large payloads (eg. the node embedded data) are decoded on the first getText(), and written back
+ * without decoding/encoding them again while they are not modified.
+ * The first getText() modifies the cache, so it's not thread safe.
+ */
+class EncodedText
+{
+public:
+    EncodedText();
+
+    /**
+     * @brief fromBase64 Create from base64 encoded UTF-8 text (not decoded until needed)
+     * @param encoded base64 text
+     * @return encoded text
+     */
+    static EncodedText fromBase64(const QByteArray & encoded);
+
+    /**
+     * @brief getText Get the text (decoded on the first call)
+     * @return text
+     */
+    const QString & getText() const;
+    /**
+     * @brief setText Set the text (the encoded text is discarded)
+     * @param text text
+     */
+    void setText(const QString & text);
+    /**
+     * @brief toBase64 Get the text as base64 encoded UTF-8 (the original encoding if not modified)
+     * @return base64 text
+     */
+    QByteArray toBase64() const;
+    /**
+     * @brief isEmpty Check if the text is empty (without decoding it)
+     * @return true if empty
+     */
+    bool isEmpty() const;
+    /**
+     * @brief equals Compare with other text (without decoding them if both are still encoded)
+     * @param other other text
+     * @return true if equal
+     */
+    bool equals(const EncodedText & other) const;
+
+private:
+    mutable QString text;
+    QByteArray encoded;
+    mutable bool decoded;
+};
+
+}
+
+#endif // ENCODEDTEXT_H
@@ -0,0 +1,368 @@
+#include "grapharchive.h"
+#include "graphwidget.h"
+#include "groupwidget.h"
+#include "itemwidget.h"
+#include "link.h"
+#include "linkdescriptor.h"
+#include "graphloader.h"
+#include "icontable.h"
+#include "parallel.h"
+#include "xmlfunctions.h"
+
+#include <QDataStream>
+#include <QFile>
+#include <QSaveFile>
+#include <QVector>
+#include <QXmlStreamReader>
+#include <QXmlStreamWriter>
+
+using namespace QNodeGraph;
+
+// File header
+#define ARCHIVE_MAGIC 0x41474E51
+#define ARCHIVE_VERSION 1
+// Header (magic, version, chunk count) and index entry (type, offset, size) sizes
+#define ARCHIVE_HEADER_SIZE 12
+#define ARCHIVE_ENTRY_SIZE 20
+// Elements per chunk
+#define ARCHIVE_CHUNK_NODES 2048
+#define ARCHIVE_CHUNK_LINKS 8192
+
+namespace
+{
+
+enum ChunkType {
+    CHUNK_GRAPH=1,
+    CHUNK_ICONS=2,
+    CHUNK_GROUPS=3,
+    CHUNK_ITEMS=4,
+    CHUNK_LINKS=5
+};
+
+struct Chunk
+{
+    quint32 type;
+    QByteArray data;
+};
+
+// Chunk parsed into descriptors (without widgets, so it can be parsed out of the GUI thread)
+class ParsedChunk
+{
+public:
+    ParsedChunk() : ok(true) {}
+
+    void parse(quint32 type, const QByteArray & data)
+    {
+        QXmlStreamReader xml(data);
+        if (!xml.readNextStartElement())
+        {
+            ok = false;
+            return;
+        }
+
+        if (type==CHUNK_ITEMS)
+            groupId = XMLFunctions::fromBase64(xml.attributes().value("group").toString());
+
+        switch (type)
+        {
+        case CHUNK_ICONS:
+            GraphLoader::readIcons(xml,&icons);
+            break;
+        case CHUNK_GROUPS:
+        case CHUNK_ITEMS:
+            while (xml.readNextStartElement())
+            {
+                if (xml.name() == QLatin1String("GroupWidget") || xml.name() == QLatin1String("ItemWidget"))
+                    GraphLoader::readNode(xml,-1,&nodes,&links);
+                else
+                    xml.skipCurrentElement();
+            }
+            break;
+        case CHUNK_LINKS:
+            while (xml.readNextStartElement())
+            {
+                if (xml.name() == QLatin1String("link"))
+                {
+                    LinkDescriptor link;
+                    LinkDescriptor::read(xml,&link);
+                    links.append(link);
+                }
+                else
+                    xml.skipCurrentElement();
+            }
+            break;
+        default:
+            // Unknown chunks (from newer versions) are skipped
+            return;
+        }
+
+        ok = !xml.hasError();
+    }
+
+    bool ok;
+    // Group of the items (empty for the graph)
+    QString groupId;
+    QVector<NodeDescriptor> nodes;
+    QList<LinkDescriptor> links;
+    IconTable icons;
+};
+
+// Every chunk is an XML fragment with a single root element
+class ChunkWriter
+{
+public:
+    ChunkWriter(QVector<Chunk> * chunks, quint32 type, const QString & element) : xml(&data)
+    {
+        this->chunks = chunks;
+        this->type = type;
+        xml.writeStartElement(element);
+    }
+
+    void finish()
+    {
+        xml.writeEndElement();
+        chunks->append({type,data});
+    }
+
+    // Declared before the writer (constructed first)
+    QByteArray data;
+    QXmlStreamWriter xml;
+    QVector<Chunk> * chunks;
+    quint32 type;
+};
+
+}
+
+GraphArchive::GraphArchive()
+{
+}
+
+bool GraphArchive::write(GraphWidget *graph, QIODevice *device, int compressionLevel)
+{
+    QVector<Chunk> chunks;
+
+    // Graphic properties (without nodes)
+    {
+        QByteArray data;
+        QXmlStreamWriter xml(&data);
+        graph->writeXML(xml,false);
+        chunks.append({CHUNK_GRAPH,data});
+    }
+
+    // Every distinct icon is encoded once, the items reference it by key
+    IconTable icons;
+    QList<ItemWidget *> allItems = GraphWidget::allRecursiveItems(graph);
+    for (auto item : allItems)
+        icons.add(item->getIcon(),item->getIconSize());
+
+    ChunkWriter iconsChunk(&chunks,CHUNK_ICONS,"icons");
+    for (const auto & key : icons.getKeys())
+    {
+        iconsChunk.xml.writeStartElement("icon");
+        iconsChunk.xml.writeAttribute("key",key);
+        iconsChunk.xml.writeCharacters(QString(icons.getData(key).toBase64()));
+        iconsChunk.xml.writeEndElement();
+    }
+    iconsChunk.finish();
+
+    // Groups (without their items), before any item
+    QList<GroupWidget *> groups = GraphWidget::allChildrenGroups(graph);
+    for (int first=0; first<groups.count(); first+=ARCHIVE_CHUNK_NODES)
+    {
+        ChunkWriter groupsChunk(&chunks,CHUNK_GROUPS,"Groups");
+        for (int i=first; i<groups.count() && i<first+ARCHIVE_CHUNK_NODES; i++)
+            groups[i]->writeXML(groupsChunk.xml,"GroupWidget",&icons,false);
+        groupsChunk.finish();
+    }
+
+    // Item ranges of the graph, and of every group (the chunk keeps the group ID)
+    QList<QWidget *> containers;
+    containers.append(graph);
+    for (auto group : groups)
+        containers.append(group);
+
+    for (auto container : containers)
+    {
+        QList<ItemWidget *> items = GraphWidget::allChildrenItems(container);
+        for (int first=0; first<items.count(); first+=ARCHIVE_CHUNK_NODES)
+        {
+            ChunkWriter itemsChunk(&chunks,CHUNK_ITEMS,"Items");
+            if (container!=graph)
+                itemsChunk.xml.writeAttribute("group",QString(((GroupWidget *)container)->getID().toUtf8().toBase64()));
+            for (int i=first; i<items.count() && i<first+ARCHIVE_CHUNK_NODES; i++)
+                items[i]->writeXML(itemsChunk.xml,"ItemWidget",&icons,false);
+            itemsChunk.finish();
+        }
+    }
+
+    // Link ranges (every link is shared by both items, it's stored once from the first item)
+    QList<LinkDescriptor> links;
+    for (auto item : allItems)
+    {
+        for (auto _link : item->getLinks())
+        {
+            Link * link = (Link *)_link;
+            if (link->getItem1()==item)
+                links.append(LinkDescriptor::fromLink(link));
+        }
+    }
+    for (int first=0; first<links.count(); first+=ARCHIVE_CHUNK_LINKS)
+    {
+        ChunkWriter linksChunk(&chunks,CHUNK_LINKS,"links");
+        for (int i=first; i<links.count() && i<first+ARCHIVE_CHUNK_LINKS; i++)
+            links[i].write(linksChunk.xml);
+        linksChunk.finish();
+    }
+
+    // Every chunk is compressed on its own thread
+    QVector<QByteArray> compressed(chunks.count());
+    QByteArray * compressedData = compressed.data();
+    const Chunk * chunksData = chunks.constData();
+    Parallel::forEach(chunks.count(), [=](int i) {
+        compressedData[i] = qCompress(chunksData[i].data,compressionLevel);
+    });
+
+    // Header and index, then the chunks in the same order
+    QByteArray index;
+    QDataStream out(&index, QIODevice::WriteOnly);
+    out.setVersion(QDataStream::Qt_5_0);
+    out << (quint32)ARCHIVE_MAGIC << (quint32)ARCHIVE_VERSION << (quint32)chunks.count();
+
+    quint64 offset = ARCHIVE_HEADER_SIZE + (quint64)chunks.count()*ARCHIVE_ENTRY_SIZE;
+    for (int i=0; i<chunks.count(); i++)
+    {
+        out << chunks[i].type << offset << (quint64)compressed[i].size();
+        offset += compressed[i].size();
+    }
+
+    if (device->write(index)!=index.size())
+        return false;
+    for (const auto & chunk : qAsConst(compressed))
+    {
+        if (device->write(chunk)!=chunk.size())
+            return false;
+    }
+    return true;
+}
+
+bool GraphArchive::save(GraphWidget *graph, const QString &file, int compressionLevel)
+{
+    QSaveFile f(file);
+    if (!f.open(QIODevice::WriteOnly))
+        return false;
+
+    if (!write(graph,&f,compressionLevel))
+    {
+        f.cancelWriting();
+        return false;
+    }
+    return f.commit();
+}
+
+bool GraphArchive::read(GraphWidget *graph, const uchar *data, qint64 size)
+{
+    if (size<ARCHIVE_HEADER_SIZE)
+        return false;
+
+    QDataStream in(QByteArray::fromRawData((const char *)data,size));
+    in.setVersion(QDataStream::Qt_5_0);
+
+    quint32 magic, version, count;
+    in >> magic >> version >> count;
+    if (magic!=ARCHIVE_MAGIC || version!=ARCHIVE_VERSION || count==0 || count>(quint64)(size-ARCHIVE_HEADER_SIZE)/ARCHIVE_ENTRY_SIZE)
+        return false;
+
+    QVector<quint32> types(count);
+    QVector<quint64> offsets(count), sizes(count);
+    for (quint32 i=0; i<count; i++)
+    {
+        in >> types[i] >> offsets[i] >> sizes[i];
+        if (offsets[i]>(quint64)size || sizes[i]>(quint64)size-offsets[i] || sizes[i]>0x7FFFFFFF)
+            return false;
+    }
+    // The graphic properties come first (they reset the graph)
+    if (in.status()!=QDataStream::Ok || types[0]!=CHUNK_GRAPH)
+        return false;
+
+    // Every chunk is decompressed on its own thread
+    QVector<QByteArray> chunks(count);
+    QByteArray * chunksData = chunks.data();
+    const quint64 * offsetsData = offsets.constData(), * sizesData = sizes.constData();
+    Parallel::forEach((int)count, [=](int i) {
+        chunksData[i] = qUncompress(data+offsetsData[i],(int)sizesData[i]);
+    });
+
+    for (const auto & chunk : qAsConst(chunks))
+    {
+        if (chunk.isEmpty())
+            return false;
+    }
+
+    // Every chunk is parsed into descriptors on its own thread
+    QVector<ParsedChunk> parsed(count);
+    ParsedChunk * parsedData = parsed.data();
+    const quint32 * typesData = types.constData();
+    const QByteArray * chunksConstData = chunks.constData();
+    Parallel::forEach((int)count-1, [=](int i) {
+        parsedData[i+1].parse(typesData[i+1],chunksConstData[i+1]);
+    });
+
+    QXmlStreamReader graphReader(chunks[0]);
+    if (!graph->readXML(graphReader))
+        return false;
+    chunks.clear();
+
+    // Then the nodes are created in the chunk order (groups before items)
+    GraphLoader loader(graph);
+    bool ok = true;
+
+    for (quint32 i=1; i<count; i++)
+    {
+        ParsedChunk & chunk = parsed[i];
+        if (!chunk.ok)
+        {
+            ok = false;
+            continue;
+        }
+
+        int parent = -1;
+        if (!chunk.groupId.isEmpty())
+        {
+            parent = loader.findGroup(chunk.groupId);
+            if (parent<0)
+            {
+                ok = false;
+                continue;
+            }
+        }
+
+        for (const auto & key : chunk.icons.getKeys())
+            loader.getIcons()->insert(key,chunk.icons.getData(key));
+        loader.append(chunk.nodes,chunk.links,parent);
+        chunk = ParsedChunk();
+    }
+
+    loader.getIcons()->decode();
+    loader.materialize(loader.getNodeCount());
+    loader.finish();
+    return ok;
+}
+
+bool GraphArchive::load(GraphWidget *graph, const QString &file)
+{
+    QFile f(file);
+    if (!f.open(QIODevice::ReadOnly))
+        return false;
+
+    uchar * data = f.map(0,f.size());
+    if (!data)
+    {
+        // Not a mappable file (eg. a resource), read it into memory
+        QByteArray contents = f.readAll();
+        return read(graph,(const uchar *)contents.constData(),contents.size());
+    }
+
+    bool ok = read(graph,data,f.size());
+    f.unmap(data);
+    return ok;
+}
@@ -0,0 +1,62 @@
+#ifndef GRAPHARCHIVE_H
+#define GRAPHARCHIVE_H
+
+#include <QString>
+#include <QIODevice>
+
+namespace QNodeGraph
+{
+
+class GraphWidget;
+
+/**
+ * @brief The GraphArchive class Compressed graph container made of independent chunks
+ *
+ * The graph XML is split into chunks that can be parsed alone: the graphic properties, the icon table,
+ * the groups, ranges of items (of the graph or of one group) and ranges of links. Every chunk is compressed
+ * (zlib, see qCompress) and the file starts with an index of the chunks, so they are compressed,
+ * decompressed and parsed in parallel on the thread pool. The nodes are created in the chunk order.
+ */
+class GraphArchive
+{
+public:
+    GraphArchive();
+
+    /**
+     * @brief write Write the graph into a device as a compressed archive
+     * @param graph graph
+     * @param device output device
+     * @param compressionLevel zlib compression level (0-9, -1 for the zlib default)
+     * @return true if succeed
+     */
+    static bool write(GraphWidget * graph, QIODevice * device, int compressionLevel = -1);
+    /**
+     * @brief save Write the graph into an archive file (the file is replaced only when everything was written)
+     * @param graph graph
+     * @param file archive file
+     * @param compressionLevel zlib compression level (0-9, -1 for the zlib default)
+     * @return true if succeed
+     */
+    static bool save(GraphWidget * graph, const QString & file, int compressionLevel = -1);
+
+    /**
+     * @brief read Replace the graph contents with an archive kept in memory
+     * @param graph graph
+     * @param data archive data
+     * @param size archive size in bytes
+     * @return true if succeed, false if the archive is not valid (the graph is not modified if the index or
+     *         a chunk can't be decompressed)
+     */
+    static bool read(GraphWidget * graph, const uchar * data, qint64 size);
+    /**
+     * @brief load Replace the graph contents with an archive file (memory mapped)
+     * @param graph graph
+     * @param file archive file
+     * @return true if succeed
+     */
+    static bool load(GraphWidget * graph, const QString & file);
+};
+
+}
+
+#endif // GRAPHARCHIVE_H
@@ -0,0 +1,903 @@
+#include "graphimporter.h"
+#include "graphwidget.h"
+#include "itemwidget.h"
+#include "link.h"
+#include "arrange.h"
+#include "spatialindex.h"
+
+#include <QStringList>
+#include <QXmlStreamReader>
+
+#include <ctype.h>
+
+using namespace QNodeGraph;
+
+// Items created at once, and links kept before creating them
+#define IMPORT_BATCH_NODES 1024
+#define IMPORT_BATCH_LINKS 4096
+
+namespace
+{
+
+// GraphML: keys (by ID) and their defaults, then the graphs read recursively (nested graphs are imported flat)
+class GraphMLReader
+{
+public:
+    GraphMLReader(QXmlStreamReader * xml, GraphImporter * importer)
+    {
+        this->xml = xml;
+        this->importer = importer;
+    }
+
+    bool read()
+    {
+        if (!xml->readNextStartElement() || xml->name() != QLatin1String("graphml"))
+            return false;
+
+        while (xml->readNextStartElement())
+        {
+            if (xml->name() == QLatin1String("key"))
+                readKey();
+            else if (xml->name() == QLatin1String("graph"))
+                readGraph();
+            else
+                xml->skipCurrentElement();
+        }
+        return !xml->hasError();
+    }
+
+private:
+    void readKey()
+    {
+        QString id = xml->attributes().value("id").toString();
+        QString domain = xml->attributes().value("for").toString();
+        QString name = xml->attributes().value("attr.name").toString();
+        names.insert(id, name.isEmpty()? id : name);
+
+        while (xml->readNextStartElement())
+        {
+            if (xml->name() == QLatin1String("default"))
+            {
+                QString value = xml->readElementText();
+                if (domain!=QLatin1String("edge"))
+                    nodeDefaults.insert(names.value(id),value);
+                if (domain!=QLatin1String("node"))
+                    edgeDefaults.insert(names.value(id),value);
+            }
+            else
+                xml->skipCurrentElement();
+        }
+    }
+
+    void readGraph()
+    {
+        bool directed = xml->attributes().value("edgedefault") == QLatin1String("directed");
+
+        while (xml->readNextStartElement())
+        {
+            if (xml->name() == QLatin1String("node"))
+                readNode();
+            else if (xml->name() == QLatin1String("edge"))
+                readEdge(directed);
+            else
+                xml->skipCurrentElement();
+        }
+    }
+
+    void readNode()
+    {
+        QString id = xml->attributes().value("id").toString();
+        GraphImporter::Attributes attributes = nodeDefaults;
+
+        while (xml->readNextStartElement())
+        {
+            if (xml->name() == QLatin1String("data"))
+                readData(&attributes);
+            else if (xml->name() == QLatin1String("graph"))
+                readGraph();
+            else
+                xml->skipCurrentElement();
+        }
+        importer->addNode(id,attributes);
+    }
+
+    void readEdge(bool directed)
+    {
+        QString source = xml->attributes().value("source").toString();
+        QString target = xml->attributes().value("target").toString();
+        if (xml->attributes().hasAttribute("directed"))
+            directed = xml->attributes().value("directed") == QLatin1String("true");
+        GraphImporter::Attributes attributes = edgeDefaults;
+
+        while (xml->readNextStartElement())
+        {
+            if (xml->name() == QLatin1String("data"))
+                readData(&attributes);
+            else
+                xml->skipCurrentElement();
+        }
+        importer->addLink(source,target,directed,attributes);
+    }
+
+    void readData(GraphImporter::Attributes * attributes)
+    {
+        QString key = xml->attributes().value("key").toString();
+        // Structured data (eg. yEd labels) is taken as its text
+        attributes->insert(names.value(key,key), xml->readElementText(QXmlStreamReader::IncludeChildElements).trimmed());
+    }
+
+    QXmlStreamReader * xml;
+    GraphImporter * importer;
+    QHash<QString, QString> names;
+    GraphImporter::Attributes nodeDefaults, edgeDefaults;
+};
+
+// DOT tokens (IDs are unquoted, concatenated and unescaped)
+class DotTokenizer
+{
+public:
+    enum Token {
+        TOKEN_END,
+        TOKEN_ID,
+        TOKEN_LBRACE,
+        TOKEN_RBRACE,
+        TOKEN_LBRACKET,
+        TOKEN_RBRACKET,
+        TOKEN_EQUAL,
+        TOKEN_SEPARATOR,
+        TOKEN_COLON,
+        TOKEN_EDGE,
+        TOKEN_ERROR
+    };
+
+    DotTokenizer(QIODevice * device)
+    {
+        this->device = device;
+        peeked = false;
+    }
+
+    Token next(QString * text = nullptr)
+    {
+        if (!peeked)
+            peekedToken = read(&peekedText);
+        peeked = false;
+        if (text)
+            *text = peekedText;
+        return peekedToken;
+    }
+
+    Token peek(QString * text = nullptr)
+    {
+        if (!peeked)
+        {
+            peekedToken = read(&peekedText);
+            peeked = true;
+        }
+        if (text)
+            *text = peekedText;
+        return peekedToken;
+    }
+
+private:
+    bool skipSpaces()
+    {
+        char c;
+        while (device->getChar(&c))
+        {
+            if (c=='/' || c=='#')
+            {
+                char c2 = 0;
+                if (c=='#' || (device->getChar(&c2) && c2=='/'))
+                {
+                    // Line comment (or preprocessor output line)
+                    while (device->getChar(&c) && c!='\n') {}
+                    continue;
+                }
+                if (c2=='*')
+                {
+                    char last = 0;
+                    while (device->getChar(&c) && !(last=='*' && c=='/'))
+                        last = c;
+                    continue;
+                }
+                if (c2)
+                    device->ungetChar(c2);
+                device->ungetChar(c);
+                return true;
+            }
+            if (!isspace((unsigned char)c))
+            {
+                device->ungetChar(c);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool readQuoted(QByteArray * text)
+    {
+        char c;
+        while (device->getChar(&c))
+        {
+            if (c=='"')
+                return true;
+            if (c=='\\')
+            {
+                char c2;
+                if (!device->getChar(&c2))
+                    return false;
+                // Escaped quote, and line continuation (other escapes are kept, eg. \n in labels)
+                if (c2=='"')
+                    text->append('"');
+                else if (c2!='\n')
+                {
+                    text->append(c);
+                    text->append(c2);
+                }
+                continue;
+            }
+            text->append(c);
+        }
+        return false;
+    }
+
+    Token read(QString * text)
+    {
+        text->clear();
+        if (!skipSpaces())
+            return TOKEN_END;
+
+        char c;
+        device->getChar(&c);
+        switch (c)
+        {
+        case '{': return TOKEN_LBRACE;
+        case '}': return TOKEN_RBRACE;
+        case '[': return TOKEN_LBRACKET;
+        case ']': return TOKEN_RBRACKET;
+        case '=': return TOKEN_EQUAL;
+        case ';':
+        case ',': return TOKEN_SEPARATOR;
+        case ':': return TOKEN_COLON;
+        default: break;
+        }
+
+        QByteArray id;
+        if (c=='"')
+        {
+            if (!readQuoted(&id))
+                return TOKEN_ERROR;
+
+            // "a" + "b"
+            char c2;
+            while (skipSpaces() && device->getChar(&c2))
+            {
+                if (c2!='+')
+                {
+                    device->ungetChar(c2);
+                    break;
+                }
+                if (!skipSpaces() || !device->getChar(&c2) || c2!='"' || !readQuoted(&id))
+                    return TOKEN_ERROR;
+            }
+        }
+        else if (c=='<')
+        {
+            // HTML string (kept as is, without the outer brackets)
+            int depth = 1;
+            while (device->getChar(&c))
+            {
+                if (c=='<')
+                    depth++;
+                else if (c=='>' && --depth==0)
+                    break;
+                id.append(c);
+            }
+            if (depth)
+                return TOKEN_ERROR;
+        }
+        else if (c=='-')
+        {
+            char c2;
+            if (!device->getChar(&c2))
+                return TOKEN_ERROR;
+            if (c2=='-' || c2=='>')
+                return TOKEN_EDGE;
+
+            // Negative number
+            device->ungetChar(c2);
+            id.append(c);
+            readPlain(&id);
+        }
+        else if (isalnum((unsigned char)c) || c=='_' || c=='.' || (c & 0x80))
+        {
+            id.append(c);
+            readPlain(&id);
+        }
+        else
+            return TOKEN_ERROR;
+
+        *text = QString::fromUtf8(id.constData(),id.size());
+        return TOKEN_ID;
+    }
+
+    void readPlain(QByteArray * id)
+    {
+        char c;
+        while (device->getChar(&c))
+        {
+            if (!isalnum((unsigned char)c) && c!='_' && c!='.' && !(c & 0x80))
+            {
+                device->ungetChar(c);
+                return;
+            }
+            id->append(c);
+        }
+    }
+
+    QIODevice * device;
+    bool peeked;
+    Token peekedToken;
+    QString peekedText;
+};
+
+// DOT: graph, statements and subgraphs (the node/edge defaults are scoped by subgraph)
+class DotReader
+{
+public:
+    DotReader(QIODevice * device, GraphImporter * importer) : tokens(device)
+    {
+        this->importer = importer;
+        directed = false;
+    }
+
+    bool read()
+    {
+        QString text;
+        if (tokens.next(&text)!=DotTokenizer::TOKEN_ID)
+            return false;
+        if (text.toLower()==QLatin1String("strict") && tokens.next(&text)!=DotTokenizer::TOKEN_ID)
+            return false;
+
+        text = text.toLower();
+        if (text!=QLatin1String("graph") && text!=QLatin1String("digraph"))
+            return false;
+        directed = text==QLatin1String("digraph");
+
+        if (tokens.peek()==DotTokenizer::TOKEN_ID)
+            tokens.next();
+        if (tokens.next()!=DotTokenizer::TOKEN_LBRACE)
+            return false;
+
+        Scope scope;
+        return readStatements(&scope,nullptr);
+    }
+
+private:
+    struct Scope
+    {
+        GraphImporter::Attributes node, edge;
+    };
+
+    bool readStatements(Scope * scope, QStringList * members)
+    {
+        for (;;)
+        {
+            switch (tokens.peek())
+            {
+            case DotTokenizer::TOKEN_RBRACE:
+                tokens.next();
+                return true;
+            case DotTokenizer::TOKEN_SEPARATOR:
+                tokens.next();
+                break;
+            case DotTokenizer::TOKEN_END:
+            case DotTokenizer::TOKEN_ERROR:
+                return false;
+            default:
+                if (!readStatement(scope,members))
+                    return false;
+            }
+        }
+    }
+
+    bool readAttributes(GraphImporter::Attributes * attributes)
+    {
+        // [a=b, c=d] [e=f]
+        while (tokens.peek()==DotTokenizer::TOKEN_LBRACKET)
+        {
+            tokens.next();
+            for (;;)
+            {
+                QString name, value;
+                DotTokenizer::Token token = tokens.next(&name);
+                if (token==DotTokenizer::TOKEN_RBRACKET)
+                    break;
+                if (token==DotTokenizer::TOKEN_SEPARATOR)
+                    continue;
+                if (token!=DotTokenizer::TOKEN_ID)
+                    return false;
+
+                value = "true";
+                if (tokens.peek()==DotTokenizer::TOKEN_EQUAL)
+                {
+                    tokens.next();
+                    if (tokens.next(&value)!=DotTokenizer::TOKEN_ID)
+                        return false;
+                }
+                attributes->insert(name,value);
+            }
+        }
+        return true;
+    }
+
+    // Node ID (with the port ignored) or subgraph: the nodes of the edge end
+    bool readEndpoint(Scope * scope, QStringList * nodes, bool * isNode)
+    {
+        QString text;
+        DotTokenizer::Token token = tokens.peek(&text);
+        *isNode = false;
+
+        if (token==DotTokenizer::TOKEN_LBRACE || (token==DotTokenizer::TOKEN_ID && text.toLower()==QLatin1String("subgraph")))
+        {
+            if (token==DotTokenizer::TOKEN_ID)
+            {
+                tokens.next();
+                if (tokens.peek()==DotTokenizer::TOKEN_ID)
+                    tokens.next();
+            }
+            if (tokens.next()!=DotTokenizer::TOKEN_LBRACE)
+                return false;
+
+            Scope subgraphScope = *scope;
+            return readStatements(&subgraphScope,nodes);
+        }
+
+        if (tokens.next(&text)!=DotTokenizer::TOKEN_ID)
+            return false;
+        while (tokens.peek()==DotTokenizer::TOKEN_COLON)
+        {
+            tokens.next();
+            if (tokens.next()!=DotTokenizer::TOKEN_ID)
+                return false;
+        }
+
+        nodes->append(text);
+        *isNode = true;
+        return true;
+    }
+
+    bool readStatement(Scope * scope, QStringList * members)
+    {
+        QString text;
+        DotTokenizer::Token token = tokens.peek(&text);
+        QString keyword = text.toLower();
+
+        if (token==DotTokenizer::TOKEN_ID && (keyword==QLatin1String("graph") || keyword==QLatin1String("node") || keyword==QLatin1String("edge")))
+        {
+            // Defaults for the next nodes/edges of this scope (the graph attributes are not used)
+            tokens.next();
+            GraphImporter::Attributes ignored;
+            return readAttributes(keyword==QLatin1String("node")? &scope->node : keyword==QLatin1String("edge")? &scope->edge : &ignored);
+        }
+
+        QList<QStringList> chain;
+        chain.append(QStringList());
+        bool isNode;
+        if (!readEndpoint(scope,&chain.last(),&isNode))
+            return false;
+
+        if (isNode && tokens.peek()==DotTokenizer::TOKEN_EQUAL)
+        {
+            // Graph attribute (not used)
+            tokens.next();
+            return tokens.next()==DotTokenizer::TOKEN_ID;
+        }
+
+        while (tokens.peek()==DotTokenizer::TOKEN_EDGE)
+        {
+            tokens.next();
+            chain.append(QStringList());
+            bool endpointIsNode;
+            if (!readEndpoint(scope,&chain.last(),&endpointIsNode))
+                return false;
+        }
+
+        // The nodes used in a subgraph are its members (the ends of its edges)
+        if (members)
+        {
+            for (const auto & nodes : chain)
+                members->append(nodes);
+        }
+
+        GraphImporter::Attributes attributes;
+        if (!readAttributes(&attributes))
+            return false;
+
+        if (chain.count()==1)
+        {
+            // Node statement (a subgraph alone was read already)
+            if (isNode)
+            {
+                GraphImporter::Attributes nodeAttributes = scope->node;
+                for (auto it = attributes.constBegin(); it!=attributes.constEnd(); ++it)
+                    nodeAttributes.insert(it.key(),it.value());
+                importer->addNode(chain.first().first(),nodeAttributes);
+            }
+            return true;
+        }
+
+        // Edge statement: a -> b -> {c d}, the nodes used are created with the defaults
+        GraphImporter::Attributes edgeAttributes = scope->edge;
+        for (auto it = attributes.constBegin(); it!=attributes.constEnd(); ++it)
+            edgeAttributes.insert(it.key(),it.value());
+
+        for (const auto & nodes : chain)
+        {
+            for (const auto & id : nodes)
+            {
+                if (!importer->hasNode(id))
+                    importer->addNode(id,scope->node);
+            }
+        }
+        for (int i=1; i<chain.count(); i++)
+        {
+            for (const auto & id1 : chain[i-1])
+            {
+                for (const auto & id2 : chain[i])
+                    importer->addLink(id1,id2,directed,edgeAttributes);
+            }
+        }
+        return true;
+    }
+
+    DotTokenizer tokens;
+    GraphImporter * importer;
+    bool directed;
+};
+
+}
+
+GraphImporter::GraphImporter(GraphWidget *graph)
+{
+    this->graph = graph;
+    placement = nullptr;
+    loading = false;
+    nodeCount = 0;
+    linkCount = 0;
+    skippedLinkCount = 0;
+}
+
+GraphImporter::~GraphImporter()
+{
+    delete placement;
+}
+
+bool GraphImporter::importGraphML(QIODevice *device)
+{
+    QXmlStreamReader xml(device);
+    GraphMLReader reader(&xml,this);
+
+    begin();
+    bool ok = reader.read();
+    end();
+    return ok;
+}
+
+bool GraphImporter::importDOT(QIODevice *device)
+{
+    DotReader reader(device,this);
+
+    begin();
+    bool ok = reader.read();
+    end();
+    return ok;
+}
+
+void GraphImporter::begin()
+{
+    loading = graph->getLoading();
+    graph->setLoading(true);
+
+    items.clear();
+    for (auto item : GraphWidget::allRecursiveItems(graph))
+        items.insert(item->getID(),item);
+
+    nodeCount = 0;
+    linkCount = 0;
+    skippedLinkCount = 0;
+}
+
+void GraphImporter::addNode(const QString &id, const Attributes &attributes)
+{
+    // Added again: only the attributes found are applied
+    ItemWidget * item = items.value(id);
+    int pending = pendingIndex.value(id,-1);
+    if (item || pending>=0)
+    {
+        NodeDescriptor node;
+        NodeDescriptor * target = pending>=0? &pendingNodes[pending] : &node;
+        defaultNodeStyle(attributes,target);
+        if (nodeStyle)
+            nodeStyle(attributes,target);
+        if (item)
+            item->setNodeDescriptor(node,nullptr);
+        return;
+    }
+
+    // The ID is the default text
+    NodeDescriptor node;
+    node.id = id;
+    node.text = id;
+    node.properties = NodeDescriptor::PROP_ID | NodeDescriptor::PROP_TEXT;
+    defaultNodeStyle(attributes,&node);
+    if (nodeStyle)
+        nodeStyle(attributes,&node);
+
+    pendingIndex.insert(id,pendingNodes.count());
+    pendingNodes.append(node);
+    if (pendingNodes.count()>=IMPORT_BATCH_NODES)
+        flushNodes();
+}
+
+void GraphImporter::addLink(const QString &id1, const QString &id2, bool directed, const Attributes &attributes)
+{
+    LinkDescriptor link;
+    link.id1 = id1;
+    link.id2 = id2;
+    link.color = graph->getDefaultNodeBorderColor();
+    if (directed)
+    {
+        link.type = Link::TYPE_DIRECTED;
+        link.direction = Link::DIR_FWD;
+    }
+    defaultLinkStyle(attributes,&link);
+    if (linkStyle)
+        linkStyle(attributes,&link);
+
+    pendingLinks.append(link);
+    if (pendingLinks.count()>=IMPORT_BATCH_LINKS)
+        flushLinks();
+}
+
+bool GraphImporter::hasNode(const QString &id) const
+{
+    return items.contains(id) || pendingIndex.contains(id);
+}
+
+void GraphImporter::end()
+{
+    flushLinks();
+
+    // Links to items added after them
+    QList<LinkDescriptor> links;
+    links.swap(unresolvedLinks);
+    pendingLinks = links;
+    flushLinks();
+    skippedLinkCount += unresolvedLinks.count();
+    unresolvedLinks.clear();
+    items.clear();
+    delete placement;
+    placement = nullptr;
+
+    // The journal is compacted once, instead of recording every node (the imports can span several event loop iterations)
+    graph->setLoading(loading);
+    graph->getChangeJournal()->markAll();
+    if (!loading)
+    {
+        Arrange::triggerAutoArrange(graph);
+        graph->repaint();
+        graph->update();
+    }
+}
+
+void GraphImporter::setNodeStyle(const std::function<void (const Attributes &, NodeDescriptor *)> &nodeStyle)
+{
+    this->nodeStyle = nodeStyle;
+}
+
+void GraphImporter::setLinkStyle(const std::function<void (const Attributes &, LinkDescriptor *)> &linkStyle)
+{
+    this->linkStyle = linkStyle;
+}
+
+void GraphImporter::defaultNodeStyle(const Attributes &attributes, NodeDescriptor *node)
+{
+    QString label = attributes.value("label", attributes.value("name"));
+    // (\N is the DOT node name)
+    if (!label.isEmpty() && label!=QLatin1String("\\N"))
+    {
+        node->text = label;
+        node->properties |= NodeDescriptor::PROP_TEXT;
+    }
+    if (attributes.contains("xlabel"))
+    {
+        node->subText = attributes.value("xlabel");
+        node->properties |= NodeDescriptor::PROP_SUBTEXT;
+    }
+
+    QString description = attributes.value("tooltip", attributes.value("description"));
+    if (!description.isEmpty())
+    {
+        node->description.setText(description);
+        node->properties |= NodeDescriptor::PROP_DESCRIPTION;
+    }
+
+    QColor color = colorFromString(attributes.value("color"));
+    if (color.isValid())
+    {
+        node->borderColor = color;
+        node->properties |= NodeDescriptor::PROP_BORDERCOLOR;
+    }
+    color = colorFromString(attributes.value("fillcolor"));
+    if (color.isValid())
+    {
+        node->fillColor = color;
+        node->properties |= NodeDescriptor::PROP_FILLCOLOR;
+    }
+    color = colorFromString(attributes.value("fontcolor"));
+    if (color.isValid())
+    {
+        node->textColor = color;
+        node->properties |= NodeDescriptor::PROP_TEXTCOLOR;
+    }
+
+    // "x,y" (DOT, the ! suffix is ignored) or separated x and y
+    bool okX = false, okY = false;
+    double x = 0, y = 0;
+    QStringList pos = attributes.value("pos").remove('!').split(',');
+    if (pos.count()>=2)
+    {
+        x = pos[0].toDouble(&okX);
+        y = pos[1].toDouble(&okY);
+    }
+    else if (attributes.contains("x") && attributes.contains("y"))
+    {
+        x = attributes.value("x").toDouble(&okX);
+        y = attributes.value("y").toDouble(&okY);
+    }
+    if (okX && okY)
+    {
+        node->pos = QPoint(qRound(x),qRound(y));
+        node->properties |= NodeDescriptor::PROP_POS;
+    }
+}
+
+void GraphImporter::defaultLinkStyle(const Attributes &attributes, LinkDescriptor *link)
+{
+    if (attributes.contains("label"))
+        link->description = attributes.value("label");
+
+    QColor color = colorFromString(attributes.value("color"));
+    if (color.isValid())
+        link->color = color;
+
+    QString dir = attributes.value("dir");
+    if (dir==QLatin1String("forward"))
+    {
+        link->type = Link::TYPE_DIRECTED;
+        link->direction = Link::DIR_FWD;
+    }
+    else if (dir==QLatin1String("back"))
+    {
+        link->type = Link::TYPE_DIRECTED;
+        link->direction = Link::DIR_REV;
+    }
+    else if (dir==QLatin1String("both"))
+    {
+        link->type = Link::TYPE_DIRECTED;
+        link->direction = Link::DIR_BOTH;
+    }
+    else if (dir==QLatin1String("none"))
+    {
+        link->type = Link::TYPE_UNDIRECTED;
+        link->direction = Link::DIR_BOTH;
+    }
+}
+
+QColor GraphImporter::colorFromString(const QString &text)
+{
+    // Only the first color of a list ("red:blue", "red;0.3:blue")
+    QString color = text.section(':',0,0).section(';',0,0).trimmed();
+    if (color.isEmpty())
+        return QColor();
+
+    if (color.startsWith('#') && color.length()==9)
+    {
+        QColor r(color.left(7));
+        r.setAlpha(color.mid(7).toInt(nullptr,16));
+        return r;
+    }
+
+    // "H S V" or "H,S,V" (0..1)
+    QStringList hsv = QString(color).replace(',',' ').simplified().split(' ');
+    if (hsv.count()==3)
+    {
+        bool okH, okS, okV;
+        double h = hsv[0].toDouble(&okH), s = hsv[1].toDouble(&okS), v = hsv[2].toDouble(&okV);
+        if (okH && okS && okV)
+            return QColor::fromHsvF(qBound(0.0,h,1.0),qBound(0.0,s,1.0),qBound(0.0,v,1.0));
+    }
+
+    return QColor(color);
+}
+
+int GraphImporter::getNodeCount() const
+{
+    return nodeCount;
+}
+
+int GraphImporter::getLinkCount() const
+{
+    return linkCount;
+}
+
+int GraphImporter::getSkippedLinkCount() const
+{
+    return skippedLinkCount;
+}
+
+void GraphImporter::flushNodes()
+{
+    for (const auto & node : qAsConst(pendingNodes))
+    {
+        ItemWidget * item = new ItemWidget(node.id,graph);
+        item->setNodeDescriptor(node,nullptr);
+        if (!node.has(NodeDescriptor::PROP_POS))
+            placeNode(item);
+        else if (placement)
+            placement->insert(item->geometry());
+        item->show();
+        items.insert(node.id,item);
+        nodeCount++;
+    }
+    pendingNodes.clear();
+    pendingIndex.clear();
+}
+
+void GraphImporter::placeNode(ItemWidget *item)
+{
+    // The siblings are indexed once for the whole import
+    if (!placement)
+    {
+        QList<AbstractNodeWidget *> nodes = GraphWidget::allChildrenItemsAndGroups(graph);
+        QVector<QSize> sizes;
+        sizes.reserve(nodes.count());
+        for (auto node : nodes)
+            sizes.append(node->size());
+
+        placement = new SpatialIndex(SpatialIndex::cellSizeFor(sizes));
+        for (auto node : nodes)
+        {
+            if (node!=item)
+                placement->insert(node->geometry());
+        }
+    }
+    item->moveToRandom(placement);
+}
+
+void GraphImporter::flushLinks()
+{
+    // The items of the links must exist first
+    flushNodes();
+
+    for (const auto & link : qAsConst(pendingLinks))
+    {
+        ItemWidget * item1 = items.value(link.id1);
+        ItemWidget * item2 = items.value(link.id2);
+        if (!item1 || !item2)
+        {
+            unresolvedLinks.append(link);
+            continue;
+        }
+        if (item1==item2 || item1->isLinkedTo(item2))
+        {
+            skippedLinkCount++;
+            continue;
+        }
+
+        item1->linkItem(item2, link.description, link.color, (Link::Type)link.type, (Link::Direction)link.direction);
+        linkCount++;
+    }
+    pendingLinks.clear();
+}
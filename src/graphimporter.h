@@ -0,0 +1,154 @@
+#ifndef GRAPHIMPORTER_H
+#define GRAPHIMPORTER_H
+
+#include <QHash>
+#include <QString>
+#include <QVector>
+#include <QList>
+#include <QIODevice>
+
+#include <functional>
+
+#include "nodedescriptor.h"
+#include "linkdescriptor.h"
+
+namespace QNodeGraph
+{
+
+class GraphWidget;
+class ItemWidget;
+class SpatialIndex;
+
+/**
+ * @brief The GraphImporter class Streaming import of graphs from other tools (GraphML and Graphviz DOT)
+ *
+ * Nodes and links are added in bulk mode: they are created in batches, and nothing is arranged or journaled
+ * until the import ends. The documents are read element by element (only the current batch is kept), the
+ * attributes of every node/edge are mapped to their properties by the style hooks.
+ * The graph structure is imported flat (GraphML nested graphs and DOT subgraphs add their nodes to the graph).
+ */
+class GraphImporter
+{
+public:
+    GraphImporter(GraphWidget * graph);
+    ~GraphImporter();
+
+    // Attributes of a node or edge by name (GraphML data by key name, DOT attributes), with the defaults applied
+    typedef QHash<QString, QString> Attributes;
+
+    /**
+     * @brief importGraphML Import a GraphML document (nodes, edges and their data)
+     * @param device input device
+     * @return true if no error ocurred
+     */
+    bool importGraphML(QIODevice * device);
+    /**
+     * @brief importDOT Import a Graphviz DOT document (nodes, edges, subgraphs and their attributes)
+     * @param device input device
+     * @return true if no error ocurred
+     */
+    bool importDOT(QIODevice * device);
+
+    /**
+     * @brief begin Start a bulk insert (called by the importers, or to feed the graph from other sources)
+     *              The items already in the graph can be linked or updated by ID.
+     */
+    void begin();
+    /**
+     * @brief addNode Add an item, or update it if the ID was already added
+     * @param id item ID
+     * @param attributes attributes (see setNodeStyle)
+     */
+    void addNode(const QString & id, const Attributes & attributes);
+    /**
+     * @brief addLink Add a link between two items (created when both items exist, they can be added later)
+     * @param id1 first item ID
+     * @param id2 second item ID
+     * @param directed directed link (from the first item to the second one)
+     * @param attributes attributes (see setLinkStyle)
+     */
+    void addLink(const QString & id1, const QString & id2, bool directed, const Attributes & attributes);
+    /**
+     * @brief hasNode Check if an item was added (or was in the graph)
+     * @param id item ID
+     * @return true if found
+     */
+    bool hasNode(const QString & id) const;
+    /**
+     * @brief end Create what is pending and end the bulk insert (the links to missing items are skipped)
+     */
+    void end();
+
+    /**
+     * @brief setNodeStyle Set the hook mapping the attributes of every node to the item properties
+     *                     (called after defaultNodeStyle, set only the properties to be applied, see NodeDescriptor::has)
+     * @param nodeStyle hook
+     */
+    void setNodeStyle(const std::function<void (const Attributes &, NodeDescriptor *)> & nodeStyle);
+    /**
+     * @brief setLinkStyle Set the hook mapping the attributes of every edge to the link properties
+     *                     (called after defaultLinkStyle)
+     * @param linkStyle hook
+     */
+    void setLinkStyle(const std::function<void (const Attributes &, LinkDescriptor *)> & linkStyle);
+    /**
+     * @brief defaultNodeStyle Map the usual attributes (label, xlabel, tooltip/description, color, fillcolor,
+     *                         fontcolor, pos or x/y)
+     * @param attributes attributes
+     * @param node output node
+     */
+    static void defaultNodeStyle(const Attributes & attributes, NodeDescriptor * node);
+    /**
+     * @brief defaultLinkStyle Map the usual attributes (label, color, dir)
+     * @param attributes attributes
+     * @param link output link
+     */
+    static void defaultLinkStyle(const Attributes & attributes, LinkDescriptor * link);
+    /**
+     * @brief colorFromString Parse a color attribute (names, #RRGGBB[AA], "H S V" and DOT color lists)
+     * @param text color attribute
+     * @return color (invalid if not parsed)
+     */
+    static QColor colorFromString(const QString & text);
+
+    /**
+     * @brief getNodeCount Get the items created by the last import
+     * @return item count
+     */
+    int getNodeCount() const;
+    /**
+     * @brief getLinkCount Get the links created by the last import
+     * @return link count
+     */
+    int getLinkCount() const;
+    /**
+     * @brief getSkippedLinkCount Get the links of the last import skipped (missing item, or already linked)
+     * @return link count
+     */
+    int getSkippedLinkCount() const;
+
+private:
+    void flushNodes();
+    void flushLinks();
+    void placeNode(ItemWidget * item);
+
+    GraphWidget * graph;
+    std::function<void (const Attributes &, NodeDescriptor *)> nodeStyle;
+    std::function<void (const Attributes &, LinkDescriptor *)> linkStyle;
+
+    // Created (or already in the graph) by ID
+    QHash<QString, ItemWidget *> items;
+    // Current batch, and links waiting for an item
+    QVector<NodeDescriptor> pendingNodes;
+    QHash<QString, int> pendingIndex;
+    QList<LinkDescriptor> pendingLinks, unresolvedLinks;
+    // Obstacles for the items without position (created on the first one)
+    SpatialIndex * placement;
+
+    bool loading;
+    int nodeCount, linkCount, skippedLinkCount;
+};
+
+}
+
+#endif // GRAPHIMPORTER_H
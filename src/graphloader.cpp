@@ -0,0 +1,387 @@
+#include "graphloader.h"
+#include "graphwidget.h"
+#include "groupwidget.h"
+#include "itemwidget.h"
+#include "arrange.h"
+#include "link.h"
+#include "xmlfunctions.h"
+
+#include <QSet>
+
+using namespace QNodeGraph;
+
+GraphLoader::GraphLoader(GraphWidget *graph)
+{
+    this->graph = graph;
+    next = 0;
+}
+
+bool GraphLoader::readNode(QXmlStreamReader &xml, int parent, QVector<NodeDescriptor> *nodes, QList<LinkDescriptor> *links)
+{
+    // The node is stored before its items (referenced by index)
+    int index = nodes->count();
+    NodeDescriptor node;
+    node.group = xml.name() == QLatin1String("GroupWidget");
+    node.parent = parent;
+    nodes->append(node);
+
+    while (xml.readNextStartElement())
+    {
+        auto name = xml.name();
+
+        if (name == QLatin1String("properties"))
+        {
+            NodeDescriptor::readProperties(xml,&(*nodes)[index]);
+        }
+        else if (name == QLatin1String("data"))
+        {
+            (*nodes)[index].embeddedData = EncodedText::fromBase64(xml.readElementText().toLatin1());
+            (*nodes)[index].properties |= NodeDescriptor::PROP_DATA;
+        }
+        else if (name == QLatin1String("links") && !node.group)
+        {
+            while (xml.readNextStartElement())
+            {
+                if (xml.name() == QLatin1String("link"))
+                {
+                    LinkDescriptor link;
+                    LinkDescriptor::read(xml,&link);
+                    links->append(link);
+                }
+                else
+                    xml.skipCurrentElement();
+            }
+        }
+        else if (name == QLatin1String("Items") && node.group)
+        {
+            while (xml.readNextStartElement())
+            {
+                if (xml.name() == QLatin1String("ItemWidget"))
+                    readNode(xml,index,nodes,links);
+                else
+                    xml.skipCurrentElement();
+            }
+        }
+        else
+            xml.skipCurrentElement();
+    }
+
+    return !xml.hasError();
+}
+
+bool GraphLoader::readIcons(QXmlStreamReader &xml, IconTable *icons)
+{
+    while (xml.readNextStartElement())
+    {
+        if (xml.name() == QLatin1String("icon"))
+        {
+            QString key = xml.attributes().value("key").toString();
+            icons->insert(key, QByteArray::fromBase64(xml.readElementText().toLatin1()));
+        }
+        else
+            xml.skipCurrentElement();
+    }
+    return !xml.hasError();
+}
+
+void GraphLoader::append(const QVector<NodeDescriptor> &nodes, const QList<LinkDescriptor> &links, int parent)
+{
+    int base = this->nodes.count();
+    this->nodes.reserve(base+nodes.count());
+
+    for (const auto & node : nodes)
+    {
+        this->nodes.append(node);
+        NodeDescriptor & appended = this->nodes.last();
+        appended.parent = node.parent<0? parent : base+node.parent;
+
+        if (appended.group)
+            groups.insert(appended.id,this->nodes.count()-1);
+    }
+    this->links.append(links);
+    created.resize(this->nodes.count());
+}
+
+IconTable *GraphLoader::getIcons()
+{
+    return &icons;
+}
+
+int GraphLoader::findGroup(const QString &id) const
+{
+    return groups.value(id,-1);
+}
+
+int GraphLoader::materialize(int count)
+{
+    // Nothing is arranged until finish()
+    bool loading = graph->getLoading();
+    graph->setLoading(true);
+
+    for (int end = qMin(next+count,nodes.count()); next<end; next++)
+        create(next,&icons);
+
+    graph->setLoading(loading);
+    return nodes.count()-next;
+}
+
+int GraphLoader::finish()
+{
+    graph->setLoading(false);
+    // The nodes were not journaled while loading
+    graph->getChangeJournal()->markAll();
+
+    int count = graph->resolveLinks(links);
+
+    for (auto group : GraphWidget::allChildrenGroups(graph))
+        Arrange::triggerAutoArrange(group);
+    Arrange::triggerAutoArrange(graph);
+
+    graph->repaint();
+    graph->update();
+    return count;
+}
+
+int GraphLoader::reconcile(IconTable *liveIcons)
+{
+    // The icons already known keep their QIcon
+    for (const auto & key : icons.getKeys())
+    {
+        if (liveIcons->getData(key).isEmpty())
+            liveIcons->insert(key,icons.getData(key));
+    }
+    liveIcons->decode();
+
+    QHash<QString, GroupWidget *> liveGroups;
+    for (auto group : GraphWidget::allChildrenGroups(graph))
+        liveGroups.insert(group->getID(),group);
+    QHash<QString, ItemWidget *> liveItems;
+    for (auto item : GraphWidget::allRecursiveItems(graph))
+        liveItems.insert(item->getID(),item);
+
+    bool loading = graph->getLoading();
+    graph->setLoading(true);
+
+    QSet<AbstractNodeWidget *> kept;
+    QList<AbstractNodeWidget *> added, modified;
+    QSet<QWidget *> changedContainers;
+
+    for (next=0; next<nodes.count(); next++)
+    {
+        const NodeDescriptor & node = nodes[next];
+
+        // Same ID, and same container for the items
+        AbstractNodeWidget * widget = nullptr;
+        if (node.group)
+            widget = liveGroups.value(node.id);
+        else
+        {
+            ItemWidget * item = liveItems.value(node.id);
+            QWidget * container = node.parent>=0 && node.parent<next? (QWidget *)created[node.parent].data() : (QWidget *)graph;
+            if (item && item->parentWidget()==container)
+                widget = item;
+        }
+
+        if (!widget || kept.contains(widget))
+        {
+            widget = create(next,liveIcons);
+            if (widget)
+            {
+                added.append(widget);
+                changedContainers.insert(widget->parentWidget());
+            }
+            continue;
+        }
+
+        kept.insert(widget);
+        created[next] = widget;
+
+        // The geometry of the current node is kept (moved by the user or arranged)
+        NodeDescriptor update = node;
+        update.properties &= ~(NodeDescriptor::PROP_ID | NodeDescriptor::PROP_POS | NodeDescriptor::PROP_WIDTH | NodeDescriptor::PROP_HEIGHT);
+        if (changed(widget,update,liveIcons))
+        {
+            widget->setNodeDescriptor(update,liveIcons);
+            modified.append(widget);
+        }
+    }
+
+    // Items by ID after the reconcile (the nodes to be removed are not included)
+    QHash<QString, ItemWidget *> items;
+    for (int i=0; i<nodes.count(); i++)
+    {
+        if (!nodes[i].group && created[i])
+            items.insert(nodes[i].id,(ItemWidget *)created[i].data());
+    }
+
+    // Links of the document, every link once (it comes from both items)
+    QHash<QPair<QString,QString>, LinkDescriptor> documentLinks;
+    for (const auto & link : links)
+    {
+        QPair<QString,QString> key = link.id1<link.id2? qMakePair(link.id1,link.id2) : qMakePair(link.id2,link.id1);
+        if (!documentLinks.contains(key))
+            documentLinks.insert(key,link);
+    }
+
+    // Current links: kept if unchanged, modified if only the style changed, otherwise removed
+    QList<QPair<ItemWidget *, ItemWidget *> > changedLinks;
+    for (auto item : items)
+    {
+        for (auto _link : item->getLinks())
+        {
+            Link * link = (Link *)_link;
+            ItemWidget * peer = (ItemWidget *)link->getItem2();
+            if (link->getItem1()!=item || items.value(peer->getID())!=peer)
+                continue;
+
+            QPair<QString,QString> key = item->getID()<peer->getID()? qMakePair(item->getID(),peer->getID()) : qMakePair(peer->getID(),item->getID());
+            auto it = documentLinks.find(key);
+            if (it!=documentLinks.end() && it.value().id1==item->getID())
+            {
+                const LinkDescriptor & d = it.value();
+                if (link->getDescription()!=d.description || link->getColor()!=d.color ||
+                    link->getType()!=(Link::Type)d.type || link->getArcDirection()!=(Link::Direction)d.direction)
+                {
+                    link->setDescription(d.description);
+                    link->setColor(d.color);
+                    link->setType((Link::Type)d.type);
+                    link->setArcDirection((Link::Direction)d.direction);
+                    graph->getEdgeRouter()->markLink(link);
+                    changedLinks.append(qMakePair(item,peer));
+                }
+                documentLinks.erase(it);
+            }
+            else
+            {
+                // The link object is shared by both items
+                peer->removeLink(item,false);
+                item->removeLink(peer,true);
+                changedLinks.append(qMakePair(item,peer));
+            }
+        }
+    }
+
+    // Links not found
+    for (const auto & link : documentLinks)
+    {
+        ItemWidget * item1 = items.value(link.id1);
+        ItemWidget * item2 = items.value(link.id2);
+        if (!item1 || !item2)
+            continue;
+
+        item1->linkItem(item2, link.description, link.color, (Link::Type)link.type, (Link::Direction)link.direction);
+        changedLinks.append(qMakePair(item1,item2));
+    }
+
+    graph->setLoading(loading);
+
+    // The changes are journaled (nothing was journaled meanwhile)
+    ChangeJournal * journal = graph->getChangeJournal();
+    for (auto widget : added)
+        journal->markNode(widget,ChangeJournal::CHANGE_ADDED);
+    for (auto widget : modified)
+        journal->markNode(widget,ChangeJournal::CHANGE_RESTYLED);
+    for (const auto & link : changedLinks)
+        journal->markLink(link.first,link.second);
+
+    // Nodes not in the document (the items of a removed group are removed with it)
+    int removed = 0;
+    for (auto item : liveItems)
+    {
+        if (!kept.contains(item) && (item->parentWidget()==graph || kept.contains((AbstractNodeWidget *)item->parentWidget())))
+        {
+            changedContainers.insert(item->parentWidget());
+            delete item;
+            removed++;
+        }
+    }
+    for (auto group : liveGroups)
+    {
+        if (!kept.contains(group))
+        {
+            changedContainers.insert(graph);
+            delete group;
+            removed++;
+        }
+    }
+
+    // Only the containers with added or removed nodes are arranged
+    for (auto container : changedContainers)
+    {
+        if (container!=graph)
+            Arrange::triggerAutoArrange(container);
+    }
+    if (changedContainers.contains(graph))
+        Arrange::triggerAutoArrange(graph);
+
+    graph->update();
+    return added.count()+modified.count()+removed+changedLinks.count();
+}
+
+int GraphLoader::getNodeCount() const
+{
+    return nodes.count();
+}
+
+int GraphLoader::getCreatedCount() const
+{
+    return next;
+}
+
+AbstractNodeWidget *GraphLoader::create(int index, IconTable *icons)
+{
+    const NodeDescriptor & node = nodes[index];
+    AbstractNodeWidget * widget;
+
+    if (node.group)
+    {
+        // Groups are only placed in the graph
+        widget = new GroupWidget(node.id,QSize(node.width,node.height),graph);
+    }
+    else
+    {
+        // Items are placed in the graph, or in a group created before
+        QWidget * parent = graph;
+        if (node.parent>=0)
+        {
+            if (node.parent>=index || !nodes[node.parent].group || !created[node.parent])
+                return nullptr;
+            parent = created[node.parent];
+        }
+        widget = new ItemWidget(node.id,parent);
+    }
+
+    widget->setNodeDescriptor(node,icons);
+    widget->show();
+    created[index] = widget;
+    return widget;
+}
+
+bool GraphLoader::changed(AbstractNodeWidget *widget, const NodeDescriptor &node, IconTable *icons)
+{
+    NodeDescriptor current;
+    widget->getNodeDescriptor(&current);
+    if (node.differs(current))
+        return true;
+
+    if (node.has(NodeDescriptor::PROP_ICON) && !node.group)
+    {
+        // Inline icons are not compared
+        ItemWidget * item = (ItemWidget *)widget;
+        if (node.iconKey.isEmpty() || node.iconSize!=item->getIconSize() ||
+            icons->getIcon(node.iconKey).cacheKey()!=item->getIcon().cacheKey())
+            return true;
+    }
+    return false;
+}
+
+QList<AbstractNodeWidget *> GraphLoader::getCreatedNodes(int first, int count) const
+{
+    QList<AbstractNodeWidget *> r;
+    for (int i=qMax(first,0); i<first+count && i<created.count(); i++)
+    {
+        if (created[i])
+            r.append(created[i].data());
+    }
+    return r;
+}
@@ -0,0 +1,131 @@
+#ifndef GRAPHLOADER_H
+#define GRAPHLOADER_H
+
+#include <QHash>
+#include <QList>
+#include <QPointer>
+#include <QVector>
+#include <QXmlStreamReader>
+
+#include "nodedescriptor.h"
+#include "linkdescriptor.h"
+#include "icontable.h"
+
+namespace QNodeGraph
+{
+
+class GraphWidget;
+class AbstractNodeWidget;
+
+/**
+ * @brief The GraphLoader class Two stage document loader: parse, then create the widgets
+ *
+ * The parse stage only fills descriptors (texts, colors, base64 contents and inline icons are decoded
+ * there), so it can run on worker threads (one document chunk per thread). The materialize stage creates
+ * the nodes on the GUI thread from the ready descriptors, in batches, and finally the links are created
+ * and the containers are arranged.
+ * Instead of creating every node, the parsed document can be reconciled with the nodes already in the graph
+ * (see reconcile).
+ */
+class GraphLoader
+{
+public:
+    GraphLoader(GraphWidget * graph);
+
+    /**
+     * @brief readNode Parse a GroupWidget or ItemWidget element (thread safe, no widget is created)
+     *                 The group items are appended after the group.
+     * @param xml XML reader positioned at the node start element (it is left after the end element)
+     * @param parent index of the group node containing this node in the output nodes (-1 for the graph)
+     * @param nodes output nodes
+     * @param links output links
+     * @return true if succeed
+     */
+    static bool readNode(QXmlStreamReader & xml, int parent, QVector<NodeDescriptor> * nodes, QList<LinkDescriptor> * links);
+    /**
+     * @brief readIcons Parse an icons element (thread safe)
+     * @param xml XML reader positioned at the icons start element (it is left after the end element)
+     * @param icons output icon table
+     * @return true if succeed
+     */
+    static bool readIcons(QXmlStreamReader & xml, IconTable * icons);
+
+    /**
+     * @brief append Append parsed nodes and links to be created
+     * @param nodes nodes (parent indexes relative to this list)
+     * @param links links
+     * @param parent index of the group containing the nodes without parent in the list (-1 for the graph),
+     *               relative to the nodes already appended
+     */
+    void append(const QVector<NodeDescriptor> & nodes, const QList<LinkDescriptor> & links, int parent = -1);
+    /**
+     * @brief getIcons Get the document icon table
+     * @return icon table
+     */
+    IconTable * getIcons();
+    /**
+     * @brief findGroup Find a group node by ID
+     * @param id group ID
+     * @return index of the node, or -1 if not found
+     */
+    int findGroup(const QString & id) const;
+
+    /**
+     * @brief materialize Create the next batch of nodes (GUI thread)
+     * @param count maximum nodes to create
+     * @return nodes still pending
+     */
+    int materialize(int count);
+    /**
+     * @brief finish Create the links, arrange every container and mark the graph for the journal (after every node was created)
+     * @return links created
+     */
+    int finish();
+    /**
+     * @brief reconcile Make the graph match the parsed document, instead of creating every node (GUI thread)
+     *                  Nodes are matched by ID (and container): only the changed properties are applied, the
+     *                  missing nodes are created and the nodes not in the document are removed. The position
+     *                  and size of the matched nodes are kept. Links are matched by their items.
+     * @param liveIcons icon table kept between reconciles (the unchanged icons are recognized by the QIcon shared
+     *                  from this table)
+     * @return nodes and links added, modified or removed
+     */
+    int reconcile(IconTable * liveIcons);
+
+    /**
+     * @brief getNodeCount Get the parsed nodes
+     * @return node count
+     */
+    int getNodeCount() const;
+    /**
+     * @brief getCreatedCount Get the nodes already created
+     * @return node count
+     */
+    int getCreatedCount() const;
+    /**
+     * @brief getCreatedNodes Get the nodes created from a range of the parsed nodes (the skipped or already
+     *                        deleted nodes are not included)
+     * @param first index of the first node
+     * @param count node count
+     * @return nodes
+     */
+    QList<AbstractNodeWidget *> getCreatedNodes(int first, int count) const;
+
+private:
+    AbstractNodeWidget * create(int index, IconTable * icons);
+    static bool changed(AbstractNodeWidget * widget, const NodeDescriptor & node, IconTable * icons);
+
+    GraphWidget * graph;
+
+    QVector<NodeDescriptor> nodes;
+    // Guarded: the nodes can be deleted by the user between batches
+    QVector<QPointer<AbstractNodeWidget> > created;
+    QList<LinkDescriptor> links;
+    QHash<QString, int> groups;
+    IconTable icons;
+    int next;
+};
+
+}
+
+#endif // GRAPHLOADER_H
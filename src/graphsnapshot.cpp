@@ -0,0 +1,629 @@
+#include "graphsnapshot.h"
+#include "graphwidget.h"
+#include "groupwidget.h"
+#include "itemwidget.h"
+#include "link.h"
+#include "nodedescriptor.h"
+#include "icontable.h"
+
+#include <QFile>
+#include <QSaveFile>
+#include <QHash>
+#include <QVector>
+#include <QPixmap>
+
+#include <string.h>
+
+using namespace QNodeGraph;
+
+// File header
+#define SNAPSHOT_MAGIC 0x534E4751
+#define SNAPSHOT_VERSION 1
+// Empty string/icon/parent reference
+#define SNAPSHOT_NONE 0xFFFFFFFF
+// Every table starts aligned to this size
+#define SNAPSHOT_ALIGN 8
+
+namespace
+{
+
+enum GraphFlags {
+    GRAPH_AUTOARRANGE=1,
+    GRAPH_RESIZABLE=2,
+    GRAPH_DELETEKEY=4,
+    GRAPH_ESCAPEKEY=8
+};
+
+enum NodeFlags {
+    NODE_GROUP=1,
+    NODE_ANCHORED=2,
+    NODE_LAYERZERO=4
+};
+
+struct Header
+{
+    quint32 magic, version;
+    quint32 nodeCount, linkCount, styleCount, tagCount, stringCount, iconCount;
+    // Byte offsets from the start of the file
+    quint64 graphOffset, nodesOffset, linksOffset, stylesOffset, tagsOffset, stringsOffset, iconsOffset;
+    quint64 stringDataOffset, stringDataSize, iconDataOffset, iconDataSize;
+};
+
+struct GraphRecord
+{
+    quint32 title, textFont, subTextFont, defaultIcon;
+    qint32 width, height, defaultIconSize;
+    quint32 backgroundColor, textColor, subTextColor, selectedBorderColor, borderColor, fillColor, fillColor2;
+    qint32 textPosition, shape, fillMode, borderRoundRectPixels;
+    quint32 flags;
+};
+
+struct NodeRecord
+{
+    quint32 id, text, subText, description, data;
+    // Group node (always stored before its items), or SNAPSHOT_NONE for the graph
+    quint32 parent;
+    qint32 x, y, width, height;
+    quint32 style, icon;
+    qint32 iconWidth, iconHeight;
+    // Range of the tags table
+    quint32 tagsFirst, tagsCount;
+    qint32 zoomOutLevel;
+    quint32 flags;
+};
+
+struct LinkRecord
+{
+    quint32 item1, item2, description, color;
+    qint32 type, direction;
+};
+
+// Node appearance, shared by every node with the same values
+struct StyleRecord
+{
+    quint32 textFont, subTextFont;
+    quint32 borderColor, selectedBorderColor, textColor, subTextColor, fillColor, fillColor2, titleBackgroundColor;
+    qint32 fillMode, borderRoundRectPixels, textPosition, shape, textAlignFlags, subTextAlignFlags;
+};
+
+// Position of a string (in QChar units) or an icon (in bytes) inside its data block
+struct Span
+{
+    quint32 offset, size;
+};
+
+quint64 aligned(quint64 offset)
+{
+    return (offset+SNAPSHOT_ALIGN-1) & ~(quint64)(SNAPSHOT_ALIGN-1);
+}
+
+class SnapshotWriter
+{
+public:
+    quint32 addString(const QString & text)
+    {
+        auto it = stringIndex.constFind(text);
+        if (it!=stringIndex.constEnd())
+            return it.value();
+
+        Span span = { (quint32)stringData.size(), (quint32)text.size() };
+        stringData.append(text);
+        strings.append(span);
+        stringIndex.insert(text,strings.count()-1);
+        return strings.count()-1;
+    }
+
+    quint32 addIcon(const QIcon & icon, const QSize & size)
+    {
+        // Every distinct icon content is encoded and stored once
+        QString key = iconTable.add(icon,size);
+        if (key.isEmpty())
+            return SNAPSHOT_NONE;
+
+        auto it = iconIndex.constFind(key);
+        if (it!=iconIndex.constEnd())
+            return it.value();
+
+        QByteArray png = iconTable.getData(key);
+        Span span = { (quint32)iconData.size(), (quint32)png.size() };
+        iconData.append(png);
+        icons.append(span);
+        iconIndex.insert(key,icons.count()-1);
+        return icons.count()-1;
+    }
+
+    quint32 addStyle(const NodeDescriptor & node)
+    {
+        StyleRecord style;
+        style.textFont = addString(node.textFont);
+        style.subTextFont = addString(node.subTextFont);
+        style.borderColor = node.borderColor.rgba();
+        style.selectedBorderColor = node.selectedBorderColor.rgba();
+        style.textColor = node.textColor.rgba();
+        style.subTextColor = node.subTextColor.rgba();
+        style.fillColor = node.fillColor.rgba();
+        style.fillColor2 = node.fillColor2.rgba();
+        style.titleBackgroundColor = node.titleBackgroundColor.rgba();
+        style.fillMode = node.fillMode;
+        style.borderRoundRectPixels = node.borderRoundRectPixels;
+        style.textPosition = node.textPosition;
+        style.shape = node.shape;
+        style.textAlignFlags = node.textAlignFlags;
+        style.subTextAlignFlags = node.subTextAlignFlags;
+
+        // Every field takes 4 bytes (no padding), so the record bytes are the key
+        QByteArray key((const char *)&style, sizeof(style));
+        auto it = styleIndex.constFind(key);
+        if (it!=styleIndex.constEnd())
+            return it.value();
+
+        styles.append(style);
+        styleIndex.insert(key,styles.count()-1);
+        return styles.count()-1;
+    }
+
+    void addNode(AbstractNodeWidget * widget, quint32 parent, bool isGroup)
+    {
+        NodeDescriptor node;
+        widget->getNodeDescriptor(&node);
+
+        NodeRecord record;
+        record.id = addString(node.id);
+        record.text = addString(node.text);
+        record.subText = addString(node.subText);
+        record.description = addString(node.description.getText());
+        record.data = addString(widget->getEmbeddedData());
+        record.parent = parent;
+        record.x = node.pos.x();
+        record.y = node.pos.y();
+        record.width = node.width;
+        record.height = node.height;
+        record.style = addStyle(node);
+        record.icon = SNAPSHOT_NONE;
+        record.iconWidth = node.iconSize.width();
+        record.iconHeight = node.iconSize.height();
+        record.tagsFirst = tags.count();
+        record.tagsCount = node.tags.count();
+        for (const auto & tag : qAsConst(node.tags))
+            tags.append(addString(tag));
+        record.zoomOutLevel = node.zoomOutLevel;
+        record.flags = (isGroup? NODE_GROUP : 0) | (node.anchored? NODE_ANCHORED : 0) | (node.belongsToLayerZero? NODE_LAYERZERO : 0);
+
+        if (!isGroup)
+        {
+            ItemWidget * item = (ItemWidget *)widget;
+            record.icon = addIcon(item->getIcon(),node.iconSize);
+            itemIndex.insert(item,nodes.count());
+            items.append(item);
+        }
+
+        nodes.append(record);
+    }
+
+    QHash<QString, quint32> stringIndex;
+    QVector<Span> strings;
+    QString stringData;
+
+    IconTable iconTable;
+    QHash<QString, quint32> iconIndex;
+    QVector<Span> icons;
+    QByteArray iconData;
+
+    QHash<QByteArray, quint32> styleIndex;
+    QVector<StyleRecord> styles;
+
+    QHash<const ItemWidget *, quint32> itemIndex;
+    QList<ItemWidget *> items;
+    QVector<NodeRecord> nodes;
+    QVector<LinkRecord> links;
+    QVector<quint32> tags;
+};
+
+bool writeTable(QIODevice * device, const void * data, quint64 size)
+{
+    static const char padding[SNAPSHOT_ALIGN] = {0};
+
+    if (size && device->write((const char *)data,size)!=(qint64)size)
+        return false;
+    quint64 paddingSize = aligned(size)-size;
+    return !paddingSize || device->write(padding,paddingSize)==(qint64)paddingSize;
+}
+
+// Get a table from the snapshot, or nullptr if it does not fit into the data
+template<typename T>
+const T * snapshotTable(const uchar * data, qint64 size, quint64 offset, quint64 count)
+{
+    if (offset%SNAPSHOT_ALIGN!=0 || offset>(quint64)size || count>((quint64)size-offset)/sizeof(T))
+        return nullptr;
+    return (const T *)(data+offset);
+}
+
+class SnapshotReader
+{
+public:
+    QString string(quint32 i) const
+    {
+        if (i>=stringCount)
+            return QString();
+        return QString(stringData+strings[i].offset, strings[i].size);
+    }
+
+    QIcon icon(quint32 i)
+    {
+        if (i>=iconCount)
+            return QIcon();
+
+        // Decoded once, and shared by every item
+        if (!decodedIcons[i])
+        {
+            QPixmap pixmap;
+            pixmap.loadFromData(iconData+icons[i].offset, icons[i].size, "PNG");
+            loadedIcons[i] = QIcon(pixmap);
+            decodedIcons[i] = true;
+        }
+        return loadedIcons[i];
+    }
+
+    bool validSpans(const Span * spans, quint32 count, quint64 dataSize) const
+    {
+        for (quint32 i=0; i<count; i++)
+        {
+            if ((quint64)spans[i].offset+spans[i].size>dataSize)
+                return false;
+        }
+        return true;
+    }
+
+    const Span * strings, * icons;
+    quint32 stringCount, iconCount;
+    const QChar * stringData;
+    const uchar * iconData;
+    QVector<QIcon> loadedIcons;
+    QVector<bool> decodedIcons;
+};
+
+}
+
+GraphSnapshot::GraphSnapshot()
+{
+}
+
+bool GraphSnapshot::write(GraphWidget *graph, QIODevice *device)
+{
+    SnapshotWriter writer;
+
+    GraphRecord g;
+    memset(&g,0,sizeof(g));
+    g.title = writer.addString(graph->getTitle());
+    g.textFont = writer.addString(graph->getDefaultNodeTextFont().toString());
+    g.subTextFont = writer.addString(graph->getDefaultNodeSubTextFont().toString());
+    g.defaultIconSize = graph->getDefaultItemIconSize();
+    g.defaultIcon = writer.addIcon(graph->getDefaultItemIcon(), QSize(g.defaultIconSize,g.defaultIconSize));
+    g.width = graph->width();
+    g.height = graph->height();
+    g.backgroundColor = graph->getBackgroundColor().rgba();
+    g.textColor = graph->getDefaultNodeTextColor().rgba();
+    g.subTextColor = graph->getDefaultNodeSubTextColor().rgba();
+    g.selectedBorderColor = graph->getDefaultNodeSelectedBorderColor().rgba();
+    g.borderColor = graph->getDefaultNodeBorderColor().rgba();
+    g.fillColor = graph->getDefaultNodeFillColor().rgba();
+    g.fillColor2 = graph->getDefaultNodeFillColor2().rgba();
+    g.textPosition = graph->getDefaultItemTextPosition();
+    g.shape = graph->getDefaultItemShape();
+    g.fillMode = graph->getDefaultNodeFillMode();
+    g.borderRoundRectPixels = graph->getDefaultNodeBorderRoundRectPixels();
+    g.flags = (graph->getAutoArrange()? GRAPH_AUTOARRANGE : 0) |
+              (graph->getResizable()? GRAPH_RESIZABLE : 0) |
+              (graph->getKeyAction(GraphWidget::KEYACT_DELETE_KEY_DELETES)? GRAPH_DELETEKEY : 0) |
+              (graph->getKeyAction(GraphWidget::KEYACT_ESCAPE_KEY_DESELECT)? GRAPH_ESCAPEKEY : 0);
+
+    // Groups are stored before their items
+    for (auto group : GraphWidget::allChildrenGroups(graph))
+    {
+        quint32 groupIndex = writer.nodes.count();
+        writer.addNode(group,SNAPSHOT_NONE,true);
+        for (auto item : GraphWidget::allChildrenItems(group))
+            writer.addNode(item,groupIndex,false);
+    }
+    for (auto item : GraphWidget::allChildrenItems(graph))
+        writer.addNode(item,SNAPSHOT_NONE,false);
+
+    // Every link is shared by both items, it's stored once (from the first item)
+    for (auto item : qAsConst(writer.items))
+    {
+        for (auto _link : item->getLinks())
+        {
+            Link * link = (Link *)_link;
+            if (link->getItem1()!=item)
+                continue;
+
+            auto peer = writer.itemIndex.constFind((const ItemWidget *)link->getItem2());
+            if (peer==writer.itemIndex.constEnd())
+                continue;
+
+            LinkRecord record;
+            record.item1 = writer.itemIndex.value(item);
+            record.item2 = peer.value();
+            record.description = writer.addString(link->getDescription());
+            record.color = link->getColor().rgba();
+            record.type = link->getType();
+            record.direction = link->getArcDirection();
+            writer.links.append(record);
+        }
+    }
+
+    Header h;
+    memset(&h,0,sizeof(h));
+    h.magic = SNAPSHOT_MAGIC;
+    h.version = SNAPSHOT_VERSION;
+    h.nodeCount = writer.nodes.count();
+    h.linkCount = writer.links.count();
+    h.styleCount = writer.styles.count();
+    h.tagCount = writer.tags.count();
+    h.stringCount = writer.strings.count();
+    h.iconCount = writer.icons.count();
+    h.stringDataSize = writer.stringData.size()*sizeof(QChar);
+    h.iconDataSize = writer.iconData.size();
+
+    // Tables in file order
+    quint64 offset = aligned(sizeof(Header));
+    h.graphOffset = offset;         offset += aligned(sizeof(GraphRecord));
+    h.nodesOffset = offset;         offset += aligned(sizeof(NodeRecord)*(quint64)h.nodeCount);
+    h.linksOffset = offset;         offset += aligned(sizeof(LinkRecord)*(quint64)h.linkCount);
+    h.stylesOffset = offset;        offset += aligned(sizeof(StyleRecord)*(quint64)h.styleCount);
+    h.tagsOffset = offset;          offset += aligned(sizeof(quint32)*(quint64)h.tagCount);
+    h.stringsOffset = offset;       offset += aligned(sizeof(Span)*(quint64)h.stringCount);
+    h.iconsOffset = offset;         offset += aligned(sizeof(Span)*(quint64)h.iconCount);
+    h.stringDataOffset = offset;    offset += aligned(h.stringDataSize);
+    h.iconDataOffset = offset;
+
+    return writeTable(device,&h,sizeof(h)) &&
+           writeTable(device,&g,sizeof(g)) &&
+           writeTable(device,writer.nodes.constData(),sizeof(NodeRecord)*(quint64)h.nodeCount) &&
+           writeTable(device,writer.links.constData(),sizeof(LinkRecord)*(quint64)h.linkCount) &&
+           writeTable(device,writer.styles.constData(),sizeof(StyleRecord)*(quint64)h.styleCount) &&
+           writeTable(device,writer.tags.constData(),sizeof(quint32)*(quint64)h.tagCount) &&
+           writeTable(device,writer.strings.constData(),sizeof(Span)*(quint64)h.stringCount) &&
+           writeTable(device,writer.icons.constData(),sizeof(Span)*(quint64)h.iconCount) &&
+           writeTable(device,writer.stringData.constData(),h.stringDataSize) &&
+           writeTable(device,writer.iconData.constData(),h.iconDataSize);
+}
+
+bool GraphSnapshot::save(GraphWidget *graph, const QString &file)
+{
+    QSaveFile f(file);
+    if (!f.open(QIODevice::WriteOnly))
+        return false;
+
+    if (!write(graph,&f))
+    {
+        f.cancelWriting();
+        return false;
+    }
+    return f.commit();
+}
+
+bool GraphSnapshot::read(GraphWidget *graph, const uchar *data, qint64 size)
+{
+    if (size<(qint64)sizeof(Header))
+        return false;
+
+    // The tables are read in place, they have to be aligned
+    if (((quintptr)data)%SNAPSHOT_ALIGN!=0)
+    {
+        QVector<quint64> copy((size+sizeof(quint64)-1)/sizeof(quint64));
+        memcpy(copy.data(),data,size);
+        return read(graph,(const uchar *)copy.constData(),size);
+    }
+
+    const Header * h = snapshotTable<Header>(data,size,0,1);
+    // A different magic is also a different byte order
+    if (!h || h->magic!=SNAPSHOT_MAGIC || h->version!=SNAPSHOT_VERSION)
+        return false;
+
+    const GraphRecord * g = snapshotTable<GraphRecord>(data,size,h->graphOffset,1);
+    const NodeRecord * nodes = snapshotTable<NodeRecord>(data,size,h->nodesOffset,h->nodeCount);
+    const LinkRecord * links = snapshotTable<LinkRecord>(data,size,h->linksOffset,h->linkCount);
+    const StyleRecord * styles = snapshotTable<StyleRecord>(data,size,h->stylesOffset,h->styleCount);
+    const quint32 * tags = snapshotTable<quint32>(data,size,h->tagsOffset,h->tagCount);
+
+    SnapshotReader reader;
+    reader.strings = snapshotTable<Span>(data,size,h->stringsOffset,h->stringCount);
+    reader.icons = snapshotTable<Span>(data,size,h->iconsOffset,h->iconCount);
+    reader.stringCount = h->stringCount;
+    reader.iconCount = h->iconCount;
+    reader.stringData = (const QChar *)snapshotTable<uchar>(data,size,h->stringDataOffset,h->stringDataSize);
+    reader.iconData = snapshotTable<uchar>(data,size,h->iconDataOffset,h->iconDataSize);
+
+    if (!g || !nodes || !links || !styles || !tags || !reader.strings || !reader.icons || !reader.stringData || !reader.iconData ||
+            !reader.validSpans(reader.strings,h->stringCount,h->stringDataSize/sizeof(QChar)) ||
+            !reader.validSpans(reader.icons,h->iconCount,h->iconDataSize))
+        return false;
+
+    // Check every reference before touching the graph
+    for (quint32 i=0; i<h->nodeCount; i++)
+    {
+        const NodeRecord & r = nodes[i];
+        bool isGroup = r.flags & NODE_GROUP;
+        if (r.style>=h->styleCount || (quint64)r.tagsFirst+r.tagsCount>h->tagCount)
+            return false;
+        // Groups are only placed in the graph, items in the graph or in a previous group
+        if (r.parent!=SNAPSHOT_NONE && (isGroup || r.parent>=i || !(nodes[r.parent].flags & NODE_GROUP)))
+            return false;
+    }
+    for (quint32 i=0; i<h->linkCount; i++)
+    {
+        const LinkRecord & r = links[i];
+        if (r.item1>=h->nodeCount || r.item2>=h->nodeCount || (nodes[r.item1].flags & NODE_GROUP) || (nodes[r.item2].flags & NODE_GROUP))
+            return false;
+    }
+
+    reader.loadedIcons.resize(h->iconCount);
+    reader.decodedIcons.fill(false,h->iconCount);
+
+    graph->getChangeJournal()->markAll();
+    graph->deleteAll();
+
+    graph->removeKeyAction(GraphWidget::KEYACT_DELETE_KEY_DELETES);
+    graph->removeKeyAction(GraphWidget::KEYACT_ESCAPE_KEY_DESELECT);
+    if (g->flags & GRAPH_DELETEKEY)
+        graph->addKeyAction(GraphWidget::KEYACT_DELETE_KEY_DELETES);
+    if (g->flags & GRAPH_ESCAPEKEY)
+        graph->addKeyAction(GraphWidget::KEYACT_ESCAPE_KEY_DESELECT);
+
+    QFont textFont, subTextFont;
+    textFont.fromString(reader.string(g->textFont));
+    subTextFont.fromString(reader.string(g->subTextFont));
+
+    graph->setTitle(reader.string(g->title));
+    graph->resize(g->width,g->height);
+    graph->setResizable(g->flags & GRAPH_RESIZABLE);
+    graph->setDefaultItemIconSize(g->defaultIconSize);
+    if (g->defaultIcon!=SNAPSHOT_NONE)
+        graph->setDefaultItemIcon(reader.icon(g->defaultIcon));
+    graph->setDefaultNodeTextFont(textFont);
+    graph->setDefaultNodeSubTextFont(subTextFont);
+    graph->setBackgroundColor(QColor::fromRgba(g->backgroundColor));
+    graph->setDefaultNodeTextColor(QColor::fromRgba(g->textColor));
+    graph->setDefaultNodeSubTextColor(QColor::fromRgba(g->subTextColor));
+    graph->setDefaultNodeSelectedBorderColor(QColor::fromRgba(g->selectedBorderColor));
+    graph->setDefaultNodeBorderColor(QColor::fromRgba(g->borderColor));
+    graph->setDefaultNodeFillColor(QColor::fromRgba(g->fillColor));
+    graph->setDefaultNodeFillColor2(QColor::fromRgba(g->fillColor2));
+    graph->setDefaultItemTextPosition((ItemWidget::TextPosition)g->textPosition);
+    graph->setDefaultItemShape((ItemWidget::ItemBoxShape)g->shape);
+    graph->setDefaultNodeFillMode((AbstractNodeWidget::ItemBoxFillMode)g->fillMode);
+    graph->setDefaultNodeBorderRoundRectPixels(g->borderRoundRectPixels);
+
+    // The stored positions are already arranged, nothing is arranged while the nodes are created
+    graph->setAutoArrange(g->flags & GRAPH_AUTOARRANGE);
+    graph->setLoading(true);
+
+    QVector<AbstractNodeWidget *> created(h->nodeCount);
+
+    for (quint32 i=0; i<h->nodeCount; i++)
+    {
+        const NodeRecord & r = nodes[i];
+        const StyleRecord & style = styles[r.style];
+
+        NodeDescriptor node;
+        node.properties = NodeDescriptor::PROP_POS | NodeDescriptor::PROP_TEXT | NodeDescriptor::PROP_SUBTEXT | NodeDescriptor::PROP_DESCRIPTION |
+                          NodeDescriptor::PROP_TEXTFONT | NodeDescriptor::PROP_SUBTEXTFONT | NodeDescriptor::PROP_BORDERCOLOR |
+                          NodeDescriptor::PROP_SELECTEDBORDERCOLOR | NodeDescriptor::PROP_TEXTCOLOR | NodeDescriptor::PROP_SUBTEXTCOLOR |
+                          NodeDescriptor::PROP_FILLCOLOR | NodeDescriptor::PROP_FILLCOLOR2 | NodeDescriptor::PROP_FILLMODE |
+                          NodeDescriptor::PROP_BORDERROUNDRECTPIXELS | NodeDescriptor::PROP_ANCHORED;
+        node.pos = QPoint(r.x,r.y);
+        node.text = reader.string(r.text);
+        node.subText = reader.string(r.subText);
+        node.description.setText(reader.string(r.description));
+        node.textFont = reader.string(style.textFont);
+        node.subTextFont = reader.string(style.subTextFont);
+        node.borderColor = QColor::fromRgba(style.borderColor);
+        node.selectedBorderColor = QColor::fromRgba(style.selectedBorderColor);
+        node.textColor = QColor::fromRgba(style.textColor);
+        node.subTextColor = QColor::fromRgba(style.subTextColor);
+        node.fillColor = QColor::fromRgba(style.fillColor);
+        node.fillColor2 = QColor::fromRgba(style.fillColor2);
+        node.fillMode = style.fillMode;
+        node.borderRoundRectPixels = style.borderRoundRectPixels;
+        node.anchored = r.flags & NODE_ANCHORED;
+
+        AbstractNodeWidget * widget;
+        if (r.flags & NODE_GROUP)
+        {
+            node.properties |= NodeDescriptor::PROP_TEXTALIGNFLAGS | NodeDescriptor::PROP_SUBTEXTALIGNFLAGS |
+                               NodeDescriptor::PROP_TITLEBACKGROUNDCOLOR | NodeDescriptor::PROP_WIDTH | NodeDescriptor::PROP_HEIGHT;
+            node.textAlignFlags = style.textAlignFlags;
+            node.subTextAlignFlags = style.subTextAlignFlags;
+            node.titleBackgroundColor = QColor::fromRgba(style.titleBackgroundColor);
+            node.width = r.width;
+            node.height = r.height;
+
+            widget = new GroupWidget(reader.string(r.id),QSize(r.width,r.height),graph);
+        }
+        else
+        {
+            node.properties |= NodeDescriptor::PROP_TAGS | NodeDescriptor::PROP_ZOOMOUTLEVEL | NodeDescriptor::PROP_TEXTPOSITION |
+                               NodeDescriptor::PROP_SHAPE | NodeDescriptor::PROP_BELONGSTOLAYERZERO;
+            for (quint32 t=0; t<r.tagsCount; t++)
+                node.tags.append(reader.string(tags[r.tagsFirst+t]));
+            node.zoomOutLevel = r.zoomOutLevel;
+            node.textPosition = style.textPosition;
+            node.shape = style.shape;
+            node.belongsToLayerZero = r.flags & NODE_LAYERZERO;
+
+            ItemWidget * item = new ItemWidget(reader.string(r.id), r.parent==SNAPSHOT_NONE? (QWidget *)graph : created[r.parent]);
+            if (r.icon!=SNAPSHOT_NONE)
+                item->setIcon(reader.icon(r.icon));
+            item->setIconSize(r.iconWidth,r.iconHeight);
+            widget = item;
+        }
+
+        widget->setNodeDescriptor(node);
+        widget->setEmbeddedData(reader.string(r.data));
+        widget->show();
+        created[i] = widget;
+    }
+
+    for (quint32 i=0; i<h->linkCount; i++)
+    {
+        const LinkRecord & r = links[i];
+        ((ItemWidget *)created[r.item1])->linkItem((ItemWidget *)created[r.item2], reader.string(r.description),
+                                                   QColor::fromRgba(r.color), (Link::Type)r.type, (Link::Direction)r.direction);
+    }
+
+    graph->setLoading(false);
+
+    graph->update();
+    return true;
+}
+
+bool GraphSnapshot::load(GraphWidget *graph, const QString &file)
+{
+    QFile f(file);
+    if (!f.open(QIODevice::ReadOnly))
+        return false;
+
+    uchar * data = f.map(0,f.size());
+    if (!data)
+    {
+        // Not a mappable file (eg. a resource), read it into memory
+        QByteArray contents = f.readAll();
+        return read(graph,(const uchar *)contents.constData(),contents.size());
+    }
+
+    bool ok = read(graph,data,f.size());
+    f.unmap(data);
+    return ok;
+}
+
+bool GraphSnapshot::xmlToSnapshot(const QString &xmlFile, const QString &snapshotFile)
+{
+    QFile f(xmlFile);
+    if (!f.open(QIODevice::ReadOnly))
+        return false;
+
+    // The graph is never shown, it only holds the nodes during the conversion
+    GraphWidget graph;
+    if (!graph.readXML(&f))
+        return false;
+    return save(&graph,snapshotFile);
+}
+
+bool GraphSnapshot::snapshotToXML(const QString &snapshotFile, const QString &xmlFile)
+{
+    GraphWidget graph;
+    if (!load(&graph,snapshotFile))
+        return false;
+
+    QSaveFile f(xmlFile);
+    if (!f.open(QIODevice::WriteOnly))
+        return false;
+
+    if (!graph.writeXML(&f))
+    {
+        f.cancelWriting();
+        return false;
+    }
+    return f.commit();
+}
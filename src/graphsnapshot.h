@@ -0,0 +1,74 @@
+#ifndef GRAPHSNAPSHOT_H
+#define GRAPHSNAPSHOT_H
+
+#include <QString>
+#include <QIODevice>
+
+namespace QNodeGraph
+{
+
+class GraphWidget;
+
+/**
+ * @brief The GraphSnapshot class Binary graph snapshots (a compact alternative to the XML for periodic saves)
+ *
+ * The file is made of fixed layout tables (graph, nodes, links, styles, tag references, strings and icons),
+ * a string pool (UTF-16, every distinct string stored once) and an icon table (every distinct icon encoded
+ * once as PNG). The load maps the file into memory and builds the graph straight from the tables, without
+ * any text parsing. The tables use the byte order of the machine that wrote the file.
+ */
+class GraphSnapshot
+{
+public:
+    GraphSnapshot();
+
+    /**
+     * @brief write Write a graph snapshot into a device
+     * @param graph graph
+     * @param device output device
+     * @return true if succeed
+     */
+    static bool write(GraphWidget * graph, QIODevice * device);
+    /**
+     * @brief save Write a graph snapshot into a file (the file is replaced only when everything was written)
+     * @param graph graph
+     * @param file snapshot file
+     * @return true if succeed
+     */
+    static bool save(GraphWidget * graph, const QString & file);
+
+    /**
+     * @brief read Replace the graph contents with a snapshot kept in memory
+     * @param graph graph
+     * @param data snapshot data
+     * @param size snapshot size in bytes
+     * @return true if succeed, false if the snapshot is not valid (the graph is not modified)
+     */
+    static bool read(GraphWidget * graph, const uchar * data, qint64 size);
+    /**
+     * @brief load Replace the graph contents with a snapshot file (memory mapped)
+     * @param graph graph
+     * @param file snapshot file
+     * @return true if succeed
+     */
+    static bool load(GraphWidget * graph, const QString & file);
+
+    /**
+     * @brief xmlToSnapshot Convert a QGraphWidget XML file into a snapshot file
+     * @param xmlFile input XML file
+     * @param snapshotFile output snapshot file
+     * @return true if succeed
+     */
+    static bool xmlToSnapshot(const QString & xmlFile, const QString & snapshotFile);
+    /**
+     * @brief snapshotToXML Convert a snapshot file into a QGraphWidget XML file
+     * @param snapshotFile input snapshot file
+     * @param xmlFile output XML file
+     * @return true if succeed
+     */
+    static bool snapshotToXML(const QString & snapshotFile, const QString & xmlFile);
+};
+
+}
+
+#endif // GRAPHSNAPSHOT_H
@@ -2,12 +2,10 @@
 #include <QPainter>
 #include <QString>
 #include <QMouseEvent>
-#include <QDomDocument>
-#include <QDomElement>
 #include <QFontMetrics>
-#include <QTextStream>
 #include <QDebug>
 #include <QBuffer>
+#include <QElapsedTimer>
 
 #include "qnamespace.h"
 #include "groupwidget.h"
@@ -20,12 +18,19 @@
 
 #include "abstractnodewidget.h"
 #include "xmlfunctions.h"
+#include "graphsnapshot.h"
+#include "grapharchive.h"
+#include "graphloader.h"
+#include "graphimporter.h"
 
 #include "arrange.h"
 
 using namespace QNodeGraph;
 
-GraphWidget::GraphWidget(QWidget *parent) : QWidget(parent)
+// Nodes created between time checks of an asynchronous load
+#define ASYNC_LOAD_BATCH 32
+
+GraphWidget::GraphWidget(QWidget *parent) : QWidget(parent), changeJournal(this), edgeRouter(this)
 {
     setAllowOverlap(false);
     setMouseTracking(true);
@@ -69,169 +74,398 @@ GraphWidget::GraphWidget(QWidget *parent) : QWidget(parent)
     // Arrange:
     setAutoArrange(false);
     setAutoArrangeAlgorithm(Arrange::ARRANGEALG_ROWS);
+    setSortBy(Arrange::SORTBY_INSERT_POS);
     setAutoArrangeSpacing(6);
+    setAutoArrangeIncremental(false);
+    setAutoArrangeByComponents(false);
+    setAutoArrangeRelayoutThreshold(25);
+    setAutoArrangeIncrementalCount(0);
+    setChildNodesCount(0);
+    setLoading(false);
+
+    // Links:
+    setLinkRouting(false);
 
     // Accept keyboard focus.
     setFocusPolicy(Qt::StrongFocus);
+
+    // Asynchronous load (a slice on every event loop iteration):
+    asyncLoader = nullptr;
+    asyncLoadSlice = 20;
+    asyncLoadTimer.setInterval(0);
+    connect(&asyncLoadTimer, &QTimer::timeout, this, &GraphWidget::loadSlice);
 }
 
 GraphWidget::~GraphWidget()
 {
+    // The pending changes are saved, and the nodes destroyed while the graph is still complete
+    delete asyncLoader;
+    asyncLoader = nullptr;
+    changeJournal.close();
+    deleteAll();
 }
 
 bool GraphWidget::setXML(const QString &xml)
 {
-    deleteAll();
+    QXmlStreamReader reader(xml);
+    return readXML(reader);
+}
 
-    keyActions.clear();
+bool GraphWidget::readXML(QIODevice *device)
+{
+    QXmlStreamReader reader(device);
+    return readXML(reader);
+}
+
+bool GraphWidget::readXML(QXmlStreamReader &xml)
+{
+    GraphLoader loader(this);
+    bool ok = parseXML(xml,&loader);
+
+    // Icons are decoded in parallel, before creating the items that share them
+    loader.getIcons()->decode();
+    loader.materialize(loader.getNodeCount());
+    loader.finish();
+
+    return ok;
+}
+
+bool GraphWidget::reconcileXML(const QString &xml)
+{
+    QXmlStreamReader reader(xml);
+    return reconcileXML(reader);
+}
+
+bool GraphWidget::reconcileXML(QXmlStreamReader &xml)
+{
+    // A load in progress is completed with the nodes created so far
+    cancelLoad();
+
+    GraphLoader loader(this);
+    if (!parseXML(xml,&loader,false))
+    {
+        // A partial document would remove the nodes not read yet
+        setLoading(false);
+        return false;
+    }
+
+    loader.reconcile(&reconcileIcons);
+    setLoading(false);
+    return true;
+}
+
+bool GraphWidget::setXMLAsync(const QString &xml, int sliceMsecs)
+{
+    QXmlStreamReader reader(xml);
+    return readXMLAsync(reader,sliceMsecs);
+}
 
-    QString errorMsg;
-    int errorLine;
-    int errorColumn;
+bool GraphWidget::readXMLAsync(QIODevice *device, int sliceMsecs)
+{
+    QXmlStreamReader reader(device);
+    return readXMLAsync(reader,sliceMsecs);
+}
 
-    QDomDocument doc;
-    if (!doc.setContent(xml,false, &errorMsg, &errorLine, &errorColumn))
+bool GraphWidget::readXMLAsync(QXmlStreamReader &xml, int sliceMsecs)
+{
+    // (Parsing replaces the graph, stopping any other load in progress)
+    GraphLoader * loader = new GraphLoader(this);
+    if (!parseXML(xml,loader))
+    {
+        delete loader;
+        setLoading(false);
+        update();
         return false;
+    }
+    loader->getIcons()->decode();
+
+    // Nothing is arranged until the last node is created
+    setLoading(true);
+    asyncLoader = loader;
+    asyncLoadSlice = sliceMsecs;
+    asyncLoadTimer.start();
+
+    // The graphic properties are shown meanwhile
+    update();
+    return true;
+}
+
+void GraphWidget::cancelLoad()
+{
+    if (!asyncLoader)
+        return;
+
+    asyncLoadTimer.stop();
+    GraphLoader * loader = asyncLoader;
+    asyncLoader = nullptr;
+
+    loader->finish();
+    delete loader;
+
+    emit loadFinished(false);
+}
+
+bool GraphWidget::getAsyncLoading() const
+{
+    return asyncLoader!=nullptr;
+}
+
+void GraphWidget::loadSlice()
+{
+    if (!asyncLoader)
+        return;
+
+    QElapsedTimer elapsed;
+    elapsed.start();
+
+    int first = asyncLoader->getCreatedCount();
+    int pending;
+    do
+        pending = asyncLoader->materialize(ASYNC_LOAD_BATCH);
+    while (pending && !elapsed.hasExpired(asyncLoadSlice));
+
+    int created = asyncLoader->getCreatedCount(), total = asyncLoader->getNodeCount();
+    QList<AbstractNodeWidget *> nodes = asyncLoader->getCreatedNodes(first,created-first);
+
+    if (pending)
+    {
+        update();
+    }
+    else
+    {
+        // The load is over before notifying (the receivers can start other load)
+        asyncLoadTimer.stop();
+        GraphLoader * loader = asyncLoader;
+        asyncLoader = nullptr;
+        loader->finish();
+        delete loader;
+    }
+
+    emit nodesLoaded(nodes);
+    emit loadProgress(created,total);
+    if (!pending)
+        emit loadFinished(true);
+}
+
+bool GraphWidget::parseXML(QXmlStreamReader &xml, GraphLoader *loader, bool replace)
+{
+    if (replace)
+    {
+        // The whole graph is replaced (the journal is compacted instead of recording every node)
+        changeJournal.markAll();
+        deleteAll();
+        reconcileIcons = IconTable();
+    }
+
+    keyActions.clear();
+
+    // The document is parsed into descriptors first, then the nodes are created in batches
+    QVector<NodeDescriptor> nodes;
+    QList<LinkDescriptor> links;
 
-    QDomElement myroot = doc.documentElement();
     // Not a QGraphWidget element
-    if (myroot.tagName() != "QGraphWidget")
+    if (!xml.readNextStartElement() || xml.name() != QLatin1String("QGraphWidget"))
         return false;
 
-    QDomNode child = myroot.firstChild();
-    while (!child.isNull())
+    // First every node is created (without arranging), then the links are resolved and every container is arranged once
+    setLoading(true);
+
+    while (xml.readNextStartElement())
     {
-        if (child.toElement().tagName() == "workSize")
+        auto name = xml.name();
+
+        if (name == QLatin1String("workSize"))
         {
-            int x = child.toElement().attribute("x").toUInt();
-            int y = child.toElement().attribute("y").toUInt();
+            int x = xml.attributes().value("x").toUInt();
+            int y = xml.attributes().value("y").toUInt();
             resize(x,y);
+            xml.skipCurrentElement();
         }
-        else if (child.toElement().tagName() == "defaultIcon")
+        else if (name == QLatin1String("defaultIcon"))
         {
-            int x = child.toElement().attribute("x").toUInt();
+            int x = xml.attributes().value("x").toUInt();
             setDefaultItemIconSize(x);
 
-            QByteArray bArrayElement = QByteArray::fromBase64(QByteArray(child.toElement().text().toUtf8()));
+            QByteArray bArrayElement = QByteArray::fromBase64(xml.readElementText().toLatin1());
             QPixmap p;
             p.loadFromData(bArrayElement);
+            // (Replaced, not accumulated on every load)
+            itemsDefaultIcon = QIcon();
             itemsDefaultIcon.addPixmap( p );
         }
-        else if (child.toElement().tagName() == "title")
+        else if (name == QLatin1String("title"))
         {
-            QByteArray bArrayElement = QByteArray::fromBase64(QByteArray(child.toElement().text().toUtf8()));
-            title = QString().fromUtf8(bArrayElement.data(),bArrayElement.size());
+            title = XMLFunctions::fromBase64(xml.readElementText());
         }
-        else if (child.toElement().tagName() == "autoArrange")
+        else if (name == QLatin1String("autoArrange"))
         {
-            autoArrange = child.toElement().text().toUInt();
+            autoArrange = xml.readElementText().toUInt();
         }
-        else if (child.toElement().tagName() == "resizable")
+        else if (name == QLatin1String("resizable"))
         {
-            setResizable(child.toElement().text().toUInt()==1?true:false);
+            setResizable(xml.readElementText().toUInt()==1?true:false);
         }
-        else if (child.toElement().tagName() == "deleteOnDeleteKey")
+        else if (name == QLatin1String("deleteOnDeleteKey"))
         {
-            if (child.toElement().text().toUInt())
+            if (xml.readElementText().toUInt())
                 addKeyAction(KEYACT_DELETE_KEY_DELETES);
         }
-        else if (child.toElement().tagName() == "deselectOnEscapeKey")
+        else if (name == QLatin1String("deselectOnEscapeKey"))
         {
-            if (child.toElement().text().toUInt())
+            if (xml.readElementText().toUInt())
                 addKeyAction(KEYACT_ESCAPE_KEY_DESELECT);
         }
-        else if (child.toElement().tagName() == "defaultTextPosition")
+        else if (name == QLatin1String("defaultTextPosition"))
         {
-            setDefaultItemTextPosition((ItemWidget::TextPosition)child.toElement().text().toUInt());
+            setDefaultItemTextPosition((ItemWidget::TextPosition)xml.readElementText().toUInt());
         }
-        else if (child.toElement().tagName() == "backgroundColor")
+        else if (name == QLatin1String("backgroundColor"))
         {
-            setBackgroundColor(XMLFunctions::colorFromXML(child));
+            setBackgroundColor(XMLFunctions::colorFromXML(xml.attributes()));
+            xml.skipCurrentElement();
         }
-        else if (child.toElement().tagName() == "defaultTextColor")
+        else if (name == QLatin1String("defaultTextColor"))
         {
-            setDefaultNodeTextColor(XMLFunctions::colorFromXML(child));
+            setDefaultNodeTextColor(XMLFunctions::colorFromXML(xml.attributes()));
+            xml.skipCurrentElement();
         }
-        else if (child.toElement().tagName() == "defaultSubTextColor")
+        else if (name == QLatin1String("defaultSubTextColor"))
         {
-            setDefaultNodeSubTextColor(XMLFunctions::colorFromXML(child));
+            setDefaultNodeSubTextColor(XMLFunctions::colorFromXML(xml.attributes()));
+            xml.skipCurrentElement();
         }
-        else if (child.toElement().tagName() == "defaultSelectedBorderColor")
+        else if (name == QLatin1String("defaultSelectedBorderColor"))
         {
-            setDefaultNodeSelectedBorderColor( XMLFunctions::colorFromXML(child) );
+            setDefaultNodeSelectedBorderColor( XMLFunctions::colorFromXML(xml.attributes()) );
+            xml.skipCurrentElement();
         }
-        else if (child.toElement().tagName() == "defaultBorderColor")
+        else if (name == QLatin1String("defaultBorderColor"))
         {
-            setDefaultNodeBorderColor( XMLFunctions::colorFromXML(child) );
+            setDefaultNodeBorderColor( XMLFunctions::colorFromXML(xml.attributes()) );
+            xml.skipCurrentElement();
         }
-        else if (child.toElement().tagName() == "defaultFillColor")
+        else if (name == QLatin1String("defaultFillColor"))
         {
-            setDefaultNodeFillColor( XMLFunctions::colorFromXML(child) );
+            setDefaultNodeFillColor( XMLFunctions::colorFromXML(xml.attributes()) );
+            xml.skipCurrentElement();
         }
-        else if (child.toElement().tagName() == "defaultFillColor2")
+        else if (name == QLatin1String("defaultFillColor2"))
         {
-            setDefaultNodeFillColor2( XMLFunctions::colorFromXML(child) );
+            setDefaultNodeFillColor2( XMLFunctions::colorFromXML(xml.attributes()) );
+            xml.skipCurrentElement();
         }
-        else if (child.toElement().tagName() == "defaultBorderRoundRectPixels")
+        else if (name == QLatin1String("defaultBorderRoundRectPixels"))
         {
-            setDefaultNodeBorderRoundRectPixels(child.toElement().text().toUInt());
+            setDefaultNodeBorderRoundRectPixels(xml.readElementText().toUInt());
         }
-        else if (child.toElement().tagName() == "defaultShape")
+        else if (name == QLatin1String("defaultShape"))
         {
-            setDefaultItemShape((ItemWidget::ItemBoxShape)child.toElement().text().toUInt());
+            setDefaultItemShape((ItemWidget::ItemBoxShape)xml.readElementText().toUInt());
         }
-        else if (child.toElement().tagName() == "defaultFillMode")
+        else if (name == QLatin1String("defaultFillMode"))
         {
-            setDefaultNodeFillMode((AbstractNodeWidget::ItemBoxFillMode)child.toElement().text().toUInt());
+            setDefaultNodeFillMode((AbstractNodeWidget::ItemBoxFillMode)xml.readElementText().toUInt());
         }
-        else if (child.toElement().tagName() == "defaultTextFont")
+        else if (name == QLatin1String("defaultTextFont"))
         {
-            QByteArray bArrayElement = QByteArray::fromBase64(QByteArray(child.toElement().text().toUtf8()));
-            itemsDefaultTextFont.fromString( QString().fromUtf8(bArrayElement.data(),bArrayElement.size()) );
+            itemsDefaultTextFont.fromString( XMLFunctions::fromBase64(xml.readElementText()) );
         }
-        else if (child.toElement().tagName() == "defaultSubTextFont")
+        else if (name == QLatin1String("defaultSubTextFont"))
         {
-            QByteArray bArrayElement = QByteArray::fromBase64(QByteArray(child.toElement().text().toUtf8()));
-            itemsDefaultSubTextFont.fromString( QString().fromUtf8(bArrayElement.data(),bArrayElement.size()) );
+            itemsDefaultSubTextFont.fromString( XMLFunctions::fromBase64(xml.readElementText()) );
         }
-        else if (child.toElement().tagName() == "Groups")
+        else if (name == QLatin1String("icons"))
         {
-            QDomNode itemChilds = child.toElement().firstChild();
-            while (!itemChilds.isNull())
-            {
-                if (itemChilds.toElement().tagName()=="GroupWidget")
-                {
-                    // Create new ItemWidget element here.
-                    QString parseData;
-                    QTextStream textStream(&parseData, QIODevice::WriteOnly);
-                    itemChilds.save(textStream,1);
-                    new GroupWidget(this,parseData);
-                }
-                itemChilds = itemChilds.nextSibling();
-            }
+            GraphLoader::readIcons(xml,loader->getIcons());
         }
-        else if (child.toElement().tagName() == "Items")
+        else if (name == QLatin1String("Groups") || name == QLatin1String("Items"))
         {
-            QDomNode itemChilds = child.toElement().firstChild();
-            while (!itemChilds.isNull())
+            while (xml.readNextStartElement())
             {
-                if (itemChilds.toElement().tagName()=="ItemWidget")
-                {
-                    // Create new ItemWidget element here.
-                    QString parseData;
-                    QTextStream textStream(&parseData, QIODevice::WriteOnly);
-                    itemChilds.save(textStream,1);
-                    new ItemWidget(this,parseData);
-                }
-                itemChilds = itemChilds.nextSibling();
+                // The group items are parsed with it
+                if (xml.name() == QLatin1String("GroupWidget") || xml.name() == QLatin1String("ItemWidget"))
+                    GraphLoader::readNode(xml,-1,&nodes,&links);
+                else
+                    xml.skipCurrentElement();
             }
         }
+        else
+            xml.skipCurrentElement();
+    }
+
+    loader->append(nodes,links);
+    return !xml.hasError();
+}
+
+bool GraphWidget::saveSnapshot(const QString &file)
+{
+    return GraphSnapshot::save(this,file);
+}
+
+bool GraphWidget::loadSnapshot(const QString &file)
+{
+    return GraphSnapshot::load(this,file);
+}
+
+bool GraphWidget::saveArchive(const QString &file, int compressionLevel)
+{
+    return GraphArchive::save(this,file,compressionLevel);
+}
+
+bool GraphWidget::loadArchive(const QString &file)
+{
+    return GraphArchive::load(this,file);
+}
+
+bool GraphWidget::importGraphML(QIODevice *device)
+{
+    GraphImporter importer(this);
+    return importer.importGraphML(device);
+}
+
+bool GraphWidget::importDOT(QIODevice *device)
+{
+    GraphImporter importer(this);
+    return importer.importDOT(device);
+}
+
+int GraphWidget::resolveLinks(const QList<ItemWidget *> &items)
+{
+    QList<LinkDescriptor> links;
+    for (auto item : items)
+        links.append(item->takeLinkDescriptors());
+    return resolveLinks(links);
+}
+
+int GraphWidget::resolveLinks(const QList<LinkDescriptor> &links)
+{
+    if (links.isEmpty())
+        return 0;
+
+    // ID index of every item of the graph (links can point to any item, created before or after)
+    QHash<QString, ItemWidget *> index;
+    for (auto item : allRecursiveItems(this))
+        index.insert(item->getID(),item);
 
-        child = child.nextSibling();
+    QSet<QPair<QString,QString>> created;
+    int count = 0;
+    for (const auto & link : links)
+    {
+        // The same link comes from both endpoints
+        QPair<QString,QString> key = link.id1<link.id2? qMakePair(link.id1,link.id2) : qMakePair(link.id2,link.id1);
+        if (created.contains(key))
+            continue;
+
+        ItemWidget * item1 = index.value(link.id1);
+        ItemWidget * item2 = index.value(link.id2);
+        if (!item1 || !item2)
+            continue;
+
+        created.insert(key);
+        item1->linkItem(item2, link.description, link.color, (Link::Type)link.type, (Link::Direction)link.direction);
+        count++;
     }
-    repaint();
-    update();
-    return true;
+    return count;
 }
 
 void GraphWidget::setFilterText(const QString & filterText, bool includeLinkedElements)
@@ -314,67 +548,109 @@ void GraphWidget::removeSelectionMarkOnAllItemsRecursively()
 
 QString GraphWidget::getXML()
 {
+    QString exportedXML;
+    QXmlStreamWriter xml(&exportedXML);
+    xml.writeStartDocument();
+    writeXML(xml);
+    xml.writeEndDocument();
+    return exportedXML;
+}
+
+bool GraphWidget::writeXML(QIODevice *device)
+{
+    QXmlStreamWriter xml(device);
+    xml.writeStartDocument();
+    writeXML(xml);
+    xml.writeEndDocument();
+    return !xml.hasError();
+}
 
+void GraphWidget::writeXML(QXmlStreamWriter &xml, bool contents)
+{
     QByteArray iconData;
     QBuffer iconDataBuffer(&iconData);
     iconDataBuffer.open(QIODevice::WriteOnly);
     itemsDefaultIcon.pixmap(getDefaultItemIconSize(), getDefaultItemIconSize()).save(&iconDataBuffer, "PNG");
 
-    QString exportedXML;
-    exportedXML = "<?xml version=\"1.0\" encoding='UTF-8'?>";
+    xml.writeStartElement("QGraphWidget");
+    // 1.1: item icons are references to the icons table
+    xml.writeAttribute("version","1.1");
+
+    XMLFunctions::writeSimpleTag(xml, "title", (QString) title.toUtf8().toBase64());
+
+    xml.writeEmptyElement("workSize");
+    xml.writeAttribute("x",QString::number(size().width()));
+    xml.writeAttribute("y",QString::number(size().height()));
+
+    xml.writeStartElement("defaultIcon");
+    xml.writeAttribute("x",QString::number(getDefaultItemIconSize()));
+    xml.writeAttribute("y",QString::number(getDefaultItemIconSize()));
+    xml.writeCharacters(QString(iconData.toBase64()));
+    xml.writeEndElement();
 
-    exportedXML.append("<QGraphWidget version=\"1.0\">");
+    XMLFunctions::writeSimpleTag(xml, "autoArrange", (uint64_t) autoArrange);
+    XMLFunctions::writeSimpleTag(xml, "resizable", resizable);
 
-    exportedXML.append(XMLFunctions::createSimpleTag("title", (QString) title.toUtf8().toBase64()));
-    exportedXML.append(QString("<workSize x=\"%1\" y=\"%2\"></workSize>").arg(size().width()).arg(size().height()));
-    exportedXML.append(QString("<defaultIcon x=\"%1\" y=\"%2\">%3</defaultIcon>").arg(
-                           QString().setNum(getDefaultItemIconSize()),
-                           QString().setNum(getDefaultItemIconSize()),
-                           QString(iconData.toBase64()))
-                       );
+    XMLFunctions::writeSimpleTag(xml, "deleteOnDeleteKey", getKeyAction(KEYACT_DELETE_KEY_DELETES));
+    XMLFunctions::writeSimpleTag(xml, "deselectOnEscapeKey", getKeyAction(KEYACT_ESCAPE_KEY_DESELECT));
 
-    exportedXML.append(XMLFunctions::createSimpleTag("autoArrange", (uint64_t) autoArrange));
-    exportedXML.append(XMLFunctions::createSimpleTag("resizable", resizable));
+    XMLFunctions::writeSimpleTag(xml, "defaultTextPosition",(uint64_t)itemsDefaultTextPosition);
 
-    exportedXML.append(XMLFunctions::createSimpleTag("deleteOnDeleteKey", getKeyAction(KEYACT_DELETE_KEY_DELETES)));
-    exportedXML.append(XMLFunctions::createSimpleTag("deselectOnEscapeKey", getKeyAction(KEYACT_ESCAPE_KEY_DESELECT)));
+    XMLFunctions::writeColorXMLTag(xml, "backgroundColor",backgroundColor);
+    XMLFunctions::writeColorXMLTag(xml, "defaultTextColor",defaultItemTextColor);
+    XMLFunctions::writeColorXMLTag(xml, "defaultSubTextColor",defaultItemSubTextColor);
+    XMLFunctions::writeColorXMLTag(xml, "defaultSelectedBorderColor",defaultItemSelectedBorderColor);
+    XMLFunctions::writeColorXMLTag(xml, "defaultBorderColor",defaultItemBorderColor);
+    XMLFunctions::writeColorXMLTag(xml, "defaultFillColor",defaultItemFillColor);
+    XMLFunctions::writeColorXMLTag(xml, "defaultFillColor2",defaultItemFillColor2);
 
-    exportedXML.append(XMLFunctions::createSimpleTag("defaultTextPosition",(uint64_t)itemsDefaultTextPosition));
 
-    exportedXML.append(XMLFunctions::createColorXMLTag("backgroundColor",backgroundColor));
-    exportedXML.append(XMLFunctions::createColorXMLTag("defaultTextColor",defaultItemTextColor));
-    exportedXML.append(XMLFunctions::createColorXMLTag("defaultSubTextColor",defaultItemSubTextColor));
-    exportedXML.append(XMLFunctions::createColorXMLTag("defaultSelectedBorderColor",defaultItemSelectedBorderColor));
-    exportedXML.append(XMLFunctions::createColorXMLTag("defaultBorderColor",defaultItemBorderColor));
-    exportedXML.append(XMLFunctions::createColorXMLTag("defaultFillColor",defaultItemFillColor));
-    exportedXML.append(XMLFunctions::createColorXMLTag("defaultFillColor2",defaultItemFillColor2));
+    XMLFunctions::writeSimpleTag(xml, "defaultBorderRoundRectPixels",(uint64_t)itemsDefaultBorderRoundRectPixels);
+    XMLFunctions::writeSimpleTag(xml, "defaultShape",(uint64_t)itemsDefaultShape);
+    XMLFunctions::writeSimpleTag(xml, "defaultFillMode",(uint64_t)itemsDefaultFillMode);
 
+    XMLFunctions::writeSimpleTag(xml, "defaultTextFont",(QString)itemsDefaultTextFont.toString().toUtf8().toBase64());
+    XMLFunctions::writeSimpleTag(xml, "defaultSubTextFont",(QString)itemsDefaultSubTextFont.toString().toUtf8().toBase64());
 
-    exportedXML.append(XMLFunctions::createSimpleTag("defaultBorderRoundRectPixels",(uint64_t)itemsDefaultBorderRoundRectPixels));
-    exportedXML.append(XMLFunctions::createSimpleTag("defaultShape",(uint64_t)itemsDefaultShape));
-    exportedXML.append(XMLFunctions::createSimpleTag("defaultFillMode",(uint64_t)itemsDefaultFillMode));
+    if (!contents)
+    {
+        xml.writeEndElement(); // QGraphWidget
+        return;
+    }
+
+    // Every distinct icon is encoded once, the items reference it by key
+    IconTable icons;
+    for (auto item : GraphWidget::allRecursiveItems(this))
+        icons.add(item->getIcon(),item->getIconSize());
 
-    exportedXML.append(XMLFunctions::createSimpleTag("defaultTextFont",(QString)itemsDefaultTextFont.toString().toUtf8().toBase64()));
-    exportedXML.append(XMLFunctions::createSimpleTag("defaultSubTextFont",(QString)itemsDefaultSubTextFont.toString().toUtf8().toBase64()));
+    xml.writeStartElement("icons");
+    for (const auto & key : icons.getKeys())
+    {
+        xml.writeStartElement("icon");
+        xml.writeAttribute("key",key);
+        xml.writeCharacters(QString(icons.getData(key).toBase64()));
+        xml.writeEndElement();
+    }
+    xml.writeEndElement();
 
-    exportedXML.append("<Groups>");
+    // Every node is written straight into the writer (the document is never kept in memory)
+    xml.writeStartElement("Groups");
     for (auto group : GraphWidget::allChildrenGroups(this))
     {
-        exportedXML.append(group->getXML("GroupWidget",false));
+        group->writeXML(xml,"GroupWidget",&icons);
     }
-    exportedXML.append("</Groups>");
+    xml.writeEndElement();
 
-    exportedXML.append("<Items>");
+    xml.writeStartElement("Items");
 
     for (auto item : GraphWidget::allChildrenItems(this))
     {
-        exportedXML.append(item->getXML("ItemWidget",false));
+        item->writeXML(xml,"ItemWidget",&icons);
     }
 
-    exportedXML.append("</Items>");
+    xml.writeEndElement();
 
-    exportedXML.append("</QGraphWidget>");
-    return exportedXML;
+    xml.writeEndElement(); // QGraphWidget
 }
 
 QList<ItemWidget *> GraphWidget::getSelectedItemsRecursively(QWidget *v)
@@ -437,8 +713,10 @@ void GraphWidget::paintEvent(QPaintEvent *e)
 
     painter.drawPixmap(0,0, drawingArea);
 
-    // Draw links for all items...
-    for (ItemWidget * item : allRecursiveItems(this))
+    // Draw links for all items (routes affected by the marked changes are computed again here)...
+    QList<ItemWidget *> items = allRecursiveItems(this);
+    edgeRouter.update();
+    for (ItemWidget * item : items)
     {
         QList< void * > linkingList = item->getLinks();
         for (int j=0;j<linkingList.count();j++)
@@ -446,7 +724,7 @@ void GraphWidget::paintEvent(QPaintEvent *e)
             Link * currentLink = (Link *) linkingList[j];
             if (currentLink->getItem1()==item)
             {
-                currentLink->paint(painter,backgroundColor);
+                currentLink->paint(painter,backgroundColor,edgeRouter.getRoute(currentLink));
             }
         }
     }
@@ -780,6 +1058,16 @@ bool GraphWidget::getResizable()
 
 void GraphWidget::deleteAll()
 {
+    // A load in progress would keep creating nodes
+    if (asyncLoader)
+    {
+        asyncLoadTimer.stop();
+        delete asyncLoader;
+        asyncLoader = nullptr;
+        setLoading(false);
+        emit loadFinished(false);
+    }
+
     for (auto obj : GraphWidget::allChildrenItemsAndGroups(this))
     {
         delete obj;
@@ -1309,6 +1597,107 @@ void GraphWidget::setAutoArrange(bool newAutoArrange)
     autoArrange = newAutoArrange;
 }
 
+bool GraphWidget::getLoading() const
+{
+    return loading;
+}
+
+void GraphWidget::setLoading(bool newLoading)
+{
+    loading = newLoading;
+}
+
+bool GraphWidget::getAutoArrangeIncremental() const
+{
+    return autoArrangeIncremental;
+}
+
+void GraphWidget::setAutoArrangeIncremental(bool newAutoArrangeIncremental)
+{
+    autoArrangeIncremental = newAutoArrangeIncremental;
+}
+
+bool GraphWidget::getAutoArrangeByComponents() const
+{
+    return autoArrangeByComponents;
+}
+
+void GraphWidget::setAutoArrangeByComponents(bool newAutoArrangeByComponents)
+{
+    autoArrangeByComponents = newAutoArrangeByComponents;
+}
+
+int GraphWidget::getAutoArrangeRelayoutThreshold() const
+{
+    return autoArrangeRelayoutThreshold;
+}
+
+void GraphWidget::setAutoArrangeRelayoutThreshold(int newAutoArrangeRelayoutThreshold)
+{
+    autoArrangeRelayoutThreshold = newAutoArrangeRelayoutThreshold;
+}
+
+int GraphWidget::getAutoArrangeIncrementalCount() const
+{
+    return autoArrangeIncrementalCount;
+}
+
+void GraphWidget::setAutoArrangeIncrementalCount(int newAutoArrangeIncrementalCount)
+{
+    autoArrangeIncrementalCount = newAutoArrangeIncrementalCount;
+}
+
+int GraphWidget::getChildNodesCount() const
+{
+    return childNodesCount;
+}
+
+void GraphWidget::setChildNodesCount(int newChildNodesCount)
+{
+    childNodesCount = newChildNodesCount;
+}
+
+LayoutRandom *GraphWidget::getLayoutRandom()
+{
+    return &layoutRandom;
+}
+
+quint64 GraphWidget::getLayoutSeed() const
+{
+    return layoutRandom.getSeed();
+}
+
+void GraphWidget::setLayoutSeed(quint64 newLayoutSeed)
+{
+    layoutRandom.setSeed(newLayoutSeed);
+}
+
+LayoutCache *GraphWidget::getLayoutCache()
+{
+    return &layoutCache;
+}
+
+ChangeJournal *GraphWidget::getChangeJournal()
+{
+    return &changeJournal;
+}
+
+bool GraphWidget::getLinkRouting() const
+{
+    return edgeRouter.getEnabled();
+}
+
+void GraphWidget::setLinkRouting(bool newLinkRouting)
+{
+    edgeRouter.setEnabled(newLinkRouting);
+    update();
+}
+
+EdgeRouter *GraphWidget::getEdgeRouter()
+{
+    return &edgeRouter;
+}
+
 
 void GraphWidget::setTitle(const QString & title)
 {
@@ -5,13 +5,20 @@
 #include <QSize>
 #include <QIcon>
 #include <QList>
+#include <QTimer>
 
 #include "itemwidget.h"
 #include "groupwidget.h"
+#include "edgerouter.h"
+#include "layoutcache.h"
+#include "changejournal.h"
+#include "layoutrandom.h"
 
 namespace QNodeGraph
 {
 
+class GraphLoader;
+
 struct XY
 {
     XY()
@@ -386,6 +393,112 @@ public:
      */
     void setAutoArrangeSpacing(int newAutoArrangeSpacing);
 
+    /**
+     * @brief getAutoArrangeIncremental Get if new items/links are placed incrementally instead of re-arranging everything
+     * @return true for incremental placement
+     */
+    bool getAutoArrangeIncremental() const;
+    /**
+     * @brief setAutoArrangeIncremental Set to place new items/links incrementally (only when auto arrange is enabled)
+     * @param newAutoArrangeIncremental true for incremental placement
+     */
+    void setAutoArrangeIncremental(bool newAutoArrangeIncremental);
+
+    /**
+     * @brief getAutoArrangeByComponents Get if the connected components are arranged independently and packed into the area
+     * @return true for arrange by components
+     */
+    bool getAutoArrangeByComponents() const;
+    /**
+     * @brief setAutoArrangeByComponents Set to arrange every connected component independently (tree and star algorithms)
+     * @param newAutoArrangeByComponents true for arrange by components
+     */
+    void setAutoArrangeByComponents(bool newAutoArrangeByComponents);
+
+    /**
+     * @brief getAutoArrangeRelayoutThreshold Get the disruption threshold that forces a full re-arrange
+     * @return percentage of nodes placed incrementally since the last full arrange
+     */
+    int getAutoArrangeRelayoutThreshold() const;
+    /**
+     * @brief setAutoArrangeRelayoutThreshold Set the disruption threshold that forces a full re-arrange
+     * @param newAutoArrangeRelayoutThreshold percentage of nodes placed incrementally since the last full arrange
+     */
+    void setAutoArrangeRelayoutThreshold(int newAutoArrangeRelayoutThreshold);
+
+    /**
+     * @brief getAutoArrangeIncrementalCount Get the incremental placements done since the last full arrange
+     * @return placement count
+     */
+    int getAutoArrangeIncrementalCount() const;
+    /**
+     * @brief setAutoArrangeIncrementalCount Set the incremental placements done since the last full arrange
+     * @param newAutoArrangeIncrementalCount placement count (zero after a full arrange)
+     */
+    void setAutoArrangeIncrementalCount(int newAutoArrangeIncrementalCount);
+    /**
+     * @brief getChildNodesCount Get the items and groups directly inside (kept by the nodes when they are created/destroyed)
+     * @return node count
+     */
+    int getChildNodesCount() const;
+    /**
+     * @brief setChildNodesCount Set the items and groups directly inside
+     * @param newChildNodesCount node count
+     */
+    void setChildNodesCount(int newChildNodesCount);
+    /**
+     * @brief getLoading Get if the graph is loading a document (nothing is auto arranged meanwhile)
+     * @return true if loading
+     */
+    bool getLoading() const;
+    /**
+     * @brief setLoading Set if the graph is loading a document (nothing is auto arranged meanwhile)
+     * @param newLoading true when the load starts, false when it ends
+     */
+    void setLoading(bool newLoading);
+
+    /**
+     * @brief getLayoutRandom Get the random generator used by the randomized layouts
+     * @return random generator
+     */
+    LayoutRandom * getLayoutRandom();
+    /**
+     * @brief getLayoutSeed Get the seed of the layout random generator
+     * @return seed
+     */
+    quint64 getLayoutSeed() const;
+    /**
+     * @brief setLayoutSeed Restart the layout random generator with a seed (same seed, same random layouts)
+     * @param newLayoutSeed seed
+     */
+    void setLayoutSeed(quint64 newLayoutSeed);
+    /**
+     * @brief getLayoutCache Get the cache with the results of the last arranges (enable/disable it or set his file here)
+     * @return layout cache
+     */
+    LayoutCache * getLayoutCache();
+    /**
+     * @brief getChangeJournal Get the incremental autosave (open the graph file here to journal every change)
+     * @return change journal
+     */
+    ChangeJournal * getChangeJournal();
+
+    /**
+     * @brief getLinkRouting Get if the links are routed around the items (instead of straight lines)
+     * @return true if routed
+     */
+    bool getLinkRouting() const;
+    /**
+     * @brief setLinkRouting Route the links around the items with orthogonal lines
+     * @param newLinkRouting true for routed links, false for straight lines
+     */
+    void setLinkRouting(bool newLinkRouting);
+    /**
+     * @brief getEdgeRouter Get the link router (set the distance kept from the items here)
+     * @return link router
+     */
+    EdgeRouter * getEdgeRouter();
+
     /**
      * @brief setResizable set if the graphic is resizeable or not
      * @param resizable true for allows manual resizing
@@ -404,12 +517,135 @@ public:
      * @return XML data
      */
     QString getXML();
+    /**
+     * @brief writeXML Write the XML document with all the graphic into a device (eg. file or socket),
+     *                 without keeping the document in memory
+     * @param device open device
+     * @return true if no error ocurred
+     */
+    bool writeXML(QIODevice * device);
+    /**
+     * @brief writeXML Write the graphic element into a XML writer (to embed the graphic into another document)
+     * @param xml XML writer
+     * @param contents write the icons and nodes (false to write only the graphic properties)
+     */
+    void writeXML(QXmlStreamWriter & xml, bool contents = true);
     /**
      * @brief setXML Set XML to set all the graphic
      * @param xml XML data
      * @return true if no error ocurred
      */
     bool setXML(const QString & xml);
+    /**
+     * @brief readXML Read the whole graphic from a device (streamed, without loading the document into memory)
+     * @param device input device
+     * @return true if no error ocurred
+     */
+    bool readXML(QIODevice * device);
+    /**
+     * @brief readXML Read the graphic element from a XML reader (to load a graphic embedded into another document)
+     * @param xml XML reader positioned before the QGraphWidget element (it is left after the end element)
+     * @return true if no error ocurred
+     */
+    bool readXML(QXmlStreamReader & xml);
+    /**
+     * @brief reconcileXML Update the graphic to match a XML document, without rebuilding it: nodes and links are
+     *                     matched by ID, only the changed properties are applied and only the difference is added or
+     *                     removed (see GraphLoader::reconcile). The matched nodes keep their position and selection.
+     * @param xml XML data
+     * @return true if no error ocurred (nodes and links are not modified if the document is not valid)
+     */
+    bool reconcileXML(const QString & xml);
+    /**
+     * @brief reconcileXML Update the graphic to match the graphic element from a XML reader (see reconcileXML)
+     * @param xml XML reader positioned before the QGraphWidget element (it is left after the end element)
+     * @return true if no error ocurred
+     */
+    bool reconcileXML(QXmlStreamReader & xml);
+    /**
+     * @brief setXMLAsync Set XML to set all the graphic without blocking the event loop: the document is parsed at
+     *                    once, then the nodes are created in time slices (see loadProgress, nodesLoaded and
+     *                    loadFinished). The graph can be used meanwhile, it's arranged and linked at the end.
+     * @param xml XML data
+     * @param sliceMsecs time spent creating nodes on every event loop iteration
+     * @return true if the load started, false on errors parsing the document (nothing is loaded, loadFinished is not emitted)
+     */
+    bool setXMLAsync(const QString & xml, int sliceMsecs = 20);
+    /**
+     * @brief readXMLAsync Read the whole graphic from a device without blocking the event loop (see setXMLAsync)
+     * @param device input device
+     * @param sliceMsecs time spent creating nodes on every event loop iteration
+     * @return true if no error ocurred parsing the document
+     */
+    bool readXMLAsync(QIODevice * device, int sliceMsecs = 20);
+    /**
+     * @brief readXMLAsync Read the graphic element from a XML reader without blocking the event loop (see setXMLAsync)
+     * @param xml XML reader positioned before the QGraphWidget element (it is left after the end element)
+     * @param sliceMsecs time spent creating nodes on every event loop iteration
+     * @return true if no error ocurred parsing the document
+     */
+    bool readXMLAsync(QXmlStreamReader & xml, int sliceMsecs = 20);
+    /**
+     * @brief cancelLoad Stop the asynchronous load in progress (the nodes already created are kept, linked and arranged)
+     */
+    void cancelLoad();
+    /**
+     * @brief getAsyncLoading Get if an asynchronous load is in progress
+     * @return true if loading
+     */
+    bool getAsyncLoading() const;
+    /**
+     * @brief saveSnapshot Save the whole graphic into a binary snapshot file (see GraphSnapshot)
+     * @param file snapshot file
+     * @return true if no error ocurred
+     */
+    bool saveSnapshot(const QString & file);
+    /**
+     * @brief loadSnapshot Load the whole graphic from a binary snapshot file (memory mapped, see GraphSnapshot)
+     * @param file snapshot file
+     * @return true if no error ocurred
+     */
+    bool loadSnapshot(const QString & file);
+    /**
+     * @brief saveArchive Save the whole graphic into a compressed archive file (chunks compressed in parallel, see GraphArchive)
+     * @param file archive file
+     * @param compressionLevel zlib compression level (0-9, -1 for the zlib default)
+     * @return true if no error ocurred
+     */
+    bool saveArchive(const QString & file, int compressionLevel = -1);
+    /**
+     * @brief loadArchive Load the whole graphic from a compressed archive file (see GraphArchive)
+     * @param file archive file
+     * @return true if no error ocurred
+     */
+    bool loadArchive(const QString & file);
+    /**
+     * @brief importGraphML Add the nodes and edges of a GraphML document to the graphic (see GraphImporter to map
+     *                      the attributes to the item and link properties)
+     * @param device input device
+     * @return true if no error ocurred
+     */
+    bool importGraphML(QIODevice * device);
+    /**
+     * @brief importDOT Add the nodes and edges of a Graphviz DOT document to the graphic (see GraphImporter to map
+     *                  the attributes to the item and link properties)
+     * @param device input device
+     * @return true if no error ocurred
+     */
+    bool importDOT(QIODevice * device);
+    /**
+     * @brief resolveLinks Create the links read from the XML of some items (after creating every item of the document)
+     *                     Every link is stored on both endpoints, it's created only once.
+     * @param items items with links read from XML
+     * @return links created
+     */
+    int resolveLinks(const QList<ItemWidget *> & items);
+    /**
+     * @brief resolveLinks Create links referenced by item ID (links to unknown items, or already created, are skipped)
+     * @param links links
+     * @return links created
+     */
+    int resolveLinks(const QList<LinkDescriptor> & links);
 
 
     /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -471,10 +707,25 @@ public:
 
 
 private:
-    bool autoArrange;
+    bool autoArrange, autoArrangeIncremental, autoArrangeByComponents;
+    bool loading;
     int autoArrangeAlgorithm, autoArrangeSpacing;
+    int autoArrangeRelayoutThreshold, autoArrangeIncrementalCount, childNodesCount;
+    LayoutRandom layoutRandom;
+    LayoutCache layoutCache;
+    ChangeJournal changeJournal;
+    EdgeRouter edgeRouter;
     int sortBy;
 
+    // Asynchronous load:
+    GraphLoader * asyncLoader;
+    QTimer asyncLoadTimer;
+    int asyncLoadSlice;
+    bool parseXML(QXmlStreamReader & xml, GraphLoader * loader, bool replace = true);
+    // Icons of the reconciled documents (shared by the nodes, to compare them)
+    IconTable reconcileIcons;
+    void loadSlice();
+
     bool isUnderSelection();
     void orderMouseRectCoordinates();
 
@@ -532,6 +783,12 @@ signals:
     void itemsRightClickEvent(QList<ItemWidget *> emisor);
     // Link 2 items
     void itemLinked(ItemWidget * first, ItemWidget *second);
+    // Asynchronous load: nodes created so far, of the total nodes in the document
+    void loadProgress(int created, int total);
+    // Asynchronous load: nodes created (and shown) by the last time slice
+    void nodesLoaded(QList<AbstractNodeWidget *> nodes);
+    // Asynchronous load ended (completed is false if it was cancelled or replaced by other load)
+    void loadFinished(bool completed);
 };
 }
 #endif
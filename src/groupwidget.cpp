@@ -7,7 +7,6 @@
 #include "arrange.h"
 
 #include <QMouseEvent>
-#include <QTextStream>
 #include <QIODevice>
 
 #define SPACING_VSIDES_GROUP 3
@@ -22,6 +21,11 @@ void GroupWidget::localInit()
     setAutoArrange(true);
     setAutoArrangeSpacing(6);
     setAutoArrangeAlgorithm( Arrange::ARRANGEALG_ROWS );
+    setAutoArrangeIncremental(false);
+    setAutoArrangeByComponents(false);
+    setAutoArrangeRelayoutThreshold(25);
+    setAutoArrangeIncrementalCount(0);
+    setChildNodesCount(0);
     setSortBy(Arrange::SORTBY_INSERT_POS);
     setTitleBackgroundColor(QColor(50,50,50,200));
     setTextColor(Qt::white);
@@ -37,8 +41,12 @@ void GroupWidget::localInit()
 
     // Recalculate Widget Size/Resize based all available info.
     recalculateSize();
-    // Setup a random position over the workspace
-    moveToRandom();
+    // Setup a random position over the workspace (the loaded nodes are placed by the document or the loader)
+    if (!GRAPH->getLoading())
+        moveToRandom();
+
+    Arrange::countChildNode((QWidget *)parent(),1);
+    journalChange(ChangeJournal::CHANGE_ADDED);
 
     // Autosort/arrange items in workspace
     Arrange::triggerAutoArrange((QWidget *)parent());
@@ -57,6 +65,7 @@ const QColor &GroupWidget::getTitleBackgroundColor() const
 void GroupWidget::setTitleBackgroundColor(const QColor &newTitleColor)
 {
     titleBackgroundColor = newTitleColor;
+    journalChange(ChangeJournal::CHANGE_RESTYLED);
 }
 
 int GroupWidget::getAutoArrangeSpacing() const
@@ -69,9 +78,19 @@ void GroupWidget::setAutoArrangeSpacing(int newAutoArrangeSpacing)
     autoArrangeSpacing = newAutoArrangeSpacing;
 }
 
-GroupWidget::GroupWidget(QWidget *parent, const QString & xml) : AbstractNodeWidget(parent,xml, "GroupWidget")
+GroupWidget::GroupWidget(QWidget *parent, const QString & xml) : AbstractNodeWidget(QString(),parent)
+{
+    // Initialized with the defaults first, the XML only overrides the properties found on it
+    localInit();
+    setXML("GroupWidget",xml);
+    GRAPH->resolveLinks(allRecursiveItems());
+}
+
+GroupWidget::GroupWidget(QWidget *parent, QXmlStreamReader &xml, IconTable *icons) : AbstractNodeWidget(QString(),parent)
 {
     localInit();
+    readXML(xml,icons);
+    GRAPH->resolveLinks(allRecursiveItems());
 }
 
 GroupWidget::GroupWidget(const QString &id, QSize size, QWidget * parent, const QString & text, const QString &subtext) : AbstractNodeWidget(id,parent,text,subtext)
@@ -101,7 +120,8 @@ GroupWidget::GroupWidget(const QString &id, QSize size, QWidget *parent) : Abstr
 
 GroupWidget::~GroupWidget()
 {
-    for ( auto i : allRecursiveItems() )
+    // Nested groups too, while this group can still account their removal
+    for ( auto i : GraphWidget::allChildrenItemsAndGroups(this) )
     {
         delete i;
     }
@@ -196,84 +216,68 @@ void GroupWidget::paintEvent(QPaintEvent * e)
     QWidget::paintEvent(e);
 }
 
-QString GroupWidget::getXMLLocal()
+void GroupWidget::writeXMLLocal(QXmlStreamWriter &xml, IconTable *icons)
 {
-    QString exportedXML;
-    exportedXML.append("<Items>");
+    xml.writeStartElement("Items");
 
     for (auto item : GraphWidget::allChildrenItems(this))
     {
-        exportedXML.append(item->getXML("ItemWidget",false));
+        item->writeXML(xml,"ItemWidget",icons);
     }
 
-    exportedXML.append("</Items>");
-    return exportedXML;
+    xml.writeEndElement();
 }
 
-QString GroupWidget::getXMLLocalProperties()
+void GroupWidget::writeXMLLocalProperties(QXmlStreamWriter &xml, IconTable *)
 {
-    QString exportedXML;  
-
-    exportedXML.append( XMLFunctions::createSimpleTag("textAlignFlags", (uint64_t)textAlignFlags));
-    exportedXML.append( XMLFunctions::createSimpleTag("subTextAlignFlags", (uint64_t)subTextAlignFlags));
+    XMLFunctions::writeSimpleTag(xml, "textAlignFlags", (uint64_t)textAlignFlags);
+    XMLFunctions::writeSimpleTag(xml, "subTextAlignFlags", (uint64_t)subTextAlignFlags);
 
-    exportedXML.append(XMLFunctions::createColorXMLTag("titleBackgroundColor",titleBackgroundColor));
+    XMLFunctions::writeColorXMLTag(xml, "titleBackgroundColor",titleBackgroundColor);
 
-    exportedXML.append( XMLFunctions::createSimpleTag("width", (uint64_t)size().width()));
-    exportedXML.append( XMLFunctions::createSimpleTag("height", (uint64_t)size().height()));
-
-    return exportedXML;
+    XMLFunctions::writeSimpleTag(xml, "width", (uint64_t)size().width());
+    XMLFunctions::writeSimpleTag(xml, "height", (uint64_t)size().height());
 }
 
-bool GroupWidget::setXMLLocalProperties(const QDomNode &child)
+void GroupWidget::setNodeDescriptorLocal(const NodeDescriptor &node, IconTable *)
 {
-    if (child.toElement().tagName() == "textAlignFlags")
-    {
-        textAlignFlags = child.toElement().text().toInt();
-    }
-    else if (child.toElement().tagName() == "subTextAlignFlags")
-    {
-        subTextAlignFlags = child.toElement().text().toInt();
-    }
-    else if (child.toElement().tagName() == "titleBackgroundColor")
-    {
-        titleBackgroundColor = XMLFunctions::colorFromXML(child);
-    }
-    if (child.toElement().tagName() == "width")
-    {
-        resize( child.toElement().text().toInt(), height());
-    }
-    else if (child.toElement().tagName() == "height")
-    {
-        resize( width(), child.toElement().text().toInt());
-    }
+    if (node.has(NodeDescriptor::PROP_TEXTALIGNFLAGS))
+        textAlignFlags = node.textAlignFlags;
+    if (node.has(NodeDescriptor::PROP_SUBTEXTALIGNFLAGS))
+        subTextAlignFlags = node.subTextAlignFlags;
+    if (node.has(NodeDescriptor::PROP_TITLEBACKGROUNDCOLOR))
+        titleBackgroundColor = node.titleBackgroundColor;
+    if (node.has(NodeDescriptor::PROP_WIDTH))
+        resize( node.width, height());
+    if (node.has(NodeDescriptor::PROP_HEIGHT))
+        resize( width(), node.height);
+}
 
-    else
-        return false;
-    return true;
+void GroupWidget::getNodeDescriptorLocal(NodeDescriptor *node) const
+{
+    node->properties |= NodeDescriptor::PROP_TEXTALIGNFLAGS | NodeDescriptor::PROP_SUBTEXTALIGNFLAGS |
+                        NodeDescriptor::PROP_TITLEBACKGROUNDCOLOR | NodeDescriptor::PROP_WIDTH | NodeDescriptor::PROP_HEIGHT;
+    node->textAlignFlags = textAlignFlags;
+    node->subTextAlignFlags = subTextAlignFlags;
+    node->titleBackgroundColor = titleBackgroundColor;
+    node->width = width();
+    node->height = height();
 }
 
-bool GroupWidget::setXMLLocal(const QDomNode &child)
+bool GroupWidget::readXMLLocal(QXmlStreamReader &xml, IconTable *icons)
 {
+    if (xml.name() != QLatin1String("Items"))
+        return false;
 
-     if (child.toElement().tagName() == "Items")
+    while (xml.readNextStartElement())
     {
-        QDomNode itemChilds = child.toElement().firstChild();
-        while (!itemChilds.isNull())
-        {
-            if (itemChilds.toElement().tagName()=="ItemWidget")
-            {
-                // Create new ItemWidget element here.
-                QString parseData;
-                QTextStream textStream(&parseData, QIODevice::WriteOnly);
-                itemChilds.save(textStream,1);
-                new ItemWidget(this,parseData);
-            }
-            itemChilds = itemChilds.nextSibling();
-        }
+        // The items are created while reading (single pass), their links are resolved by the group constructor
+        if (xml.name() == QLatin1String("ItemWidget"))
+            (new ItemWidget(QString(),this))->readXML(xml,icons);
+        else
+            xml.skipCurrentElement();
     }
-
-     return true;
+    return true;
 }
 
 void GroupWidget::recalculateSize()
@@ -315,6 +319,56 @@ void GroupWidget::setAutoArrange(bool newAutoArrange)
     autoArrange = newAutoArrange;
 }
 
+bool GroupWidget::getAutoArrangeIncremental() const
+{
+    return autoArrangeIncremental;
+}
+
+void GroupWidget::setAutoArrangeIncremental(bool newAutoArrangeIncremental)
+{
+    autoArrangeIncremental = newAutoArrangeIncremental;
+}
+
+bool GroupWidget::getAutoArrangeByComponents() const
+{
+    return autoArrangeByComponents;
+}
+
+void GroupWidget::setAutoArrangeByComponents(bool newAutoArrangeByComponents)
+{
+    autoArrangeByComponents = newAutoArrangeByComponents;
+}
+
+int GroupWidget::getAutoArrangeRelayoutThreshold() const
+{
+    return autoArrangeRelayoutThreshold;
+}
+
+void GroupWidget::setAutoArrangeRelayoutThreshold(int newAutoArrangeRelayoutThreshold)
+{
+    autoArrangeRelayoutThreshold = newAutoArrangeRelayoutThreshold;
+}
+
+int GroupWidget::getAutoArrangeIncrementalCount() const
+{
+    return autoArrangeIncrementalCount;
+}
+
+void GroupWidget::setAutoArrangeIncrementalCount(int newAutoArrangeIncrementalCount)
+{
+    autoArrangeIncrementalCount = newAutoArrangeIncrementalCount;
+}
+
+int GroupWidget::getChildNodesCount() const
+{
+    return childNodesCount;
+}
+
+void GroupWidget::setChildNodesCount(int newChildNodesCount)
+{
+    childNodesCount = newChildNodesCount;
+}
+
 bool GroupWidget::getResizable() const
 {
     return resizable;
@@ -379,9 +433,11 @@ void GroupWidget::mouseReleaseEvent(QMouseEvent *event)
 void GroupWidget::setSubTextAlignFlags(int newSubTextAlignFlags)
 {
     subTextAlignFlags = newSubTextAlignFlags;
+    journalChange(ChangeJournal::CHANGE_RESTYLED);
 }
 
 void GroupWidget::setTextAlignFlags(int newTextAlignFlags)
 {
     textAlignFlags = newTextAlignFlags;
+    journalChange(ChangeJournal::CHANGE_RESTYLED);
 }
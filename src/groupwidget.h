@@ -17,6 +17,14 @@ public:
      * @param xml XML to set
      */
     GroupWidget(QWidget *parent, const QString &xml);
+    /**
+     * @brief GroupWidget Group Node Widget Constructor
+     * @param parent parent graph
+     * @param xml XML reader positioned at the GroupWidget start element (it is left after the end element)
+     *            (the links to the items already in the graph are created, the others are dropped)
+     * @param icons document icon table (to resolve the icon keys), or nullptr
+     */
+    GroupWidget(QWidget *parent, QXmlStreamReader &xml, IconTable * icons = nullptr);
     /**
      * @brief GroupWidget Group Node Widget Constructor
      * @param id node identifier
@@ -115,6 +123,60 @@ public:
      */
     void setAutoArrangeSpacing(int newAutoArrangeSpacing);
 
+    /**
+     * @brief getAutoArrangeIncremental Get if new items/links are placed incrementally instead of re-arranging everything
+     * @return true for incremental placement
+     */
+    bool getAutoArrangeIncremental() const;
+    /**
+     * @brief setAutoArrangeIncremental Set to place new items/links incrementally (only when auto arrange is enabled)
+     * @param newAutoArrangeIncremental true for incremental placement
+     */
+    void setAutoArrangeIncremental(bool newAutoArrangeIncremental);
+
+    /**
+     * @brief getAutoArrangeByComponents Get if the connected components are arranged independently and packed into the area
+     * @return true for arrange by components
+     */
+    bool getAutoArrangeByComponents() const;
+    /**
+     * @brief setAutoArrangeByComponents Set to arrange every connected component independently (tree and star algorithms)
+     * @param newAutoArrangeByComponents true for arrange by components
+     */
+    void setAutoArrangeByComponents(bool newAutoArrangeByComponents);
+
+    /**
+     * @brief getAutoArrangeRelayoutThreshold Get the disruption threshold that forces a full re-arrange
+     * @return percentage of nodes placed incrementally since the last full arrange
+     */
+    int getAutoArrangeRelayoutThreshold() const;
+    /**
+     * @brief setAutoArrangeRelayoutThreshold Set the disruption threshold that forces a full re-arrange
+     * @param newAutoArrangeRelayoutThreshold percentage of nodes placed incrementally since the last full arrange
+     */
+    void setAutoArrangeRelayoutThreshold(int newAutoArrangeRelayoutThreshold);
+
+    /**
+     * @brief getAutoArrangeIncrementalCount Get the incremental placements done since the last full arrange
+     * @return placement count
+     */
+    int getAutoArrangeIncrementalCount() const;
+    /**
+     * @brief setAutoArrangeIncrementalCount Set the incremental placements done since the last full arrange
+     * @param newAutoArrangeIncrementalCount placement count (zero after a full arrange)
+     */
+    void setAutoArrangeIncrementalCount(int newAutoArrangeIncrementalCount);
+    /**
+     * @brief getChildNodesCount Get the items and groups directly inside (kept by the nodes when they are created/destroyed)
+     * @return node count
+     */
+    int getChildNodesCount() const;
+    /**
+     * @brief setChildNodesCount Set the items and groups directly inside
+     * @param newChildNodesCount node count
+     */
+    void setChildNodesCount(int newChildNodesCount);
+
     /**
      * @brief getTitleBackgroundColor Get Group Title background Color
      * @return color
@@ -136,11 +198,12 @@ protected:
 
     void localInit();
 
-    QString getXMLLocal();
-    QString getXMLLocalProperties();
+    void writeXMLLocal(QXmlStreamWriter & xml, IconTable * icons);
+    void writeXMLLocalProperties(QXmlStreamWriter & xml, IconTable * icons);
 
-    bool setXMLLocalProperties(const QDomNode &child);
-    bool setXMLLocal(const QDomNode & child);
+    bool readXMLLocal(QXmlStreamReader & xml, IconTable * icons);
+    void setNodeDescriptorLocal(const NodeDescriptor & node, IconTable * icons);
+    void getNodeDescriptorLocal(NodeDescriptor * node) const;
 
     void recalculateSize();
     void setInternalObjectID();
@@ -152,8 +215,9 @@ private:
     bool resizable;
     bool resizingX, resizingY;
 
-    bool autoArrange;
+    bool autoArrange, autoArrangeIncremental, autoArrangeByComponents;
     int autoArrangeAlgorithm, sortBy, autoArrangeSpacing;
+    int autoArrangeRelayoutThreshold, autoArrangeIncrementalCount, childNodesCount;
 
     QPoint mouseCurrentPos;
     QColor titleBackgroundColor;
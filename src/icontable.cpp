@@ -0,0 +1,120 @@
+#include "icontable.h"
+#include "parallel.h"
+
+#include <QBuffer>
+#include <QCryptographicHash>
+#include <QImage>
+#include <QPixmap>
+#include <QVector>
+
+using namespace QNodeGraph;
+
+IconTable::IconTable()
+{
+}
+
+QString IconTable::add(const QIcon &icon, const QSize &size)
+{
+    if (icon.isNull())
+        return QString();
+
+    // Copies of the same icon share the cache key (no need to look at the pixels again)
+    QPair<qint64,qint64> iconKey(icon.cacheKey(), ((qint64)size.width()<<32) | (quint32)size.height());
+    auto it = added.constFind(iconKey);
+    if (it!=added.constEnd())
+        return it.value();
+
+    QPixmap pixmap = icon.pixmap(size.width(), size.height());
+    QImage image = pixmap.toImage().convertToFormat(QImage::Format_ARGB32);
+
+    // Content key: hash of the pixels (equal icons from different objects are encoded only once)
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    qint32 dimensions[2] = { image.width(), image.height() };
+    hash.addData(QByteArray::fromRawData((const char *)dimensions, sizeof(dimensions)));
+    hash.addData(QByteArray::fromRawData((const char *)image.constBits(), image.bytesPerLine()*image.height()));
+    QString key = QString(hash.result().toHex());
+
+    if (!data.contains(key))
+    {
+        QByteArray png;
+        QBuffer buffer(&png);
+        buffer.open(QIODevice::WriteOnly);
+        pixmap.save(&buffer, "PNG");
+
+        data.insert(key,png);
+        icons.insert(key,icon);
+        keys.append(key);
+    }
+
+    added.insert(iconKey,key);
+    return key;
+}
+
+void IconTable::insert(const QString &key, const QByteArray &data)
+{
+    if (!this->data.contains(key))
+        keys.append(key);
+    this->data.insert(key,data);
+    icons.remove(key);
+    images.remove(key);
+}
+
+const QStringList &IconTable::getKeys() const
+{
+    return keys;
+}
+
+QByteArray IconTable::getData(const QString &key) const
+{
+    return data.value(key);
+}
+
+QIcon IconTable::getIcon(const QString &key)
+{
+    auto it = icons.constFind(key);
+    if (it!=icons.constEnd())
+        return it.value();
+
+    QPixmap pixmap;
+    auto image = images.constFind(key);
+    if (image!=images.constEnd())
+    {
+        pixmap = QPixmap::fromImage(image.value());
+        images.remove(key);
+    }
+    else
+    {
+        auto encoded = data.constFind(key);
+        if (encoded==data.constEnd())
+            return QIcon();
+        pixmap.loadFromData(encoded.value(), "PNG");
+    }
+
+    QIcon icon(pixmap);
+    icons.insert(key,icon);
+    return icon;
+}
+
+void IconTable::decode()
+{
+    QVector<QByteArray> pending;
+    QStringList pendingKeys;
+    for (const auto & key : qAsConst(keys))
+    {
+        if (!icons.contains(key) && !images.contains(key))
+        {
+            pending.append(data.value(key));
+            pendingKeys.append(key);
+        }
+    }
+
+    QVector<QImage> decoded(pending.count());
+    QImage * decodedData = decoded.data();
+    const QByteArray * pendingData = pending.constData();
+    Parallel::forEach(pending.count(), [=](int i) {
+        decodedData[i].loadFromData(pendingData[i], "PNG");
+    });
+
+    for (int i=0; i<pendingKeys.count(); i++)
+        images.insert(pendingKeys[i],decoded[i]);
+}
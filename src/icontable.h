@@ -0,0 +1,76 @@
+#ifndef ICONTABLE_H
+#define ICONTABLE_H
+
+#include <QHash>
+#include <QPair>
+#include <QString>
+#include <QStringList>
+#include <QByteArray>
+#include <QIcon>
+#include <QImage>
+#include <QSize>
+
+namespace QNodeGraph
+{
+
+/**
+ * @brief The IconTable class Document level icon table keyed by the icon content
+ *
+ * When saving, every distinct icon is encoded (PNG) once and the items reference it by key. When loading,
+ * every icon is decoded once and the same QIcon is shared by all the items referencing it.
+ */
+class IconTable
+{
+public:
+    IconTable();
+
+    /**
+     * @brief add Add an icon (encoded only if the same content was not added before)
+     * @param icon icon
+     * @param size icon size to encode
+     * @return content key (empty if the icon is null)
+     */
+    QString add(const QIcon & icon, const QSize & size);
+    /**
+     * @brief insert Insert an encoded icon read from a document
+     * @param key content key
+     * @param data encoded icon (PNG)
+     */
+    void insert(const QString & key, const QByteArray & data);
+
+    /**
+     * @brief getKeys Get the keys of every icon (in insertion order)
+     * @return keys
+     */
+    const QStringList & getKeys() const;
+    /**
+     * @brief getData Get an encoded icon
+     * @param key content key
+     * @return encoded icon (PNG), empty if not found
+     */
+    QByteArray getData(const QString & key) const;
+    /**
+     * @brief getIcon Get a decoded icon (decoded on the first call and shared)
+     * @param key content key
+     * @return icon, null if not found
+     */
+    QIcon getIcon(const QString & key);
+    /**
+     * @brief decode Decode every icon read from a document at once, in parallel (otherwise they are decoded
+     *               by getIcon, one by one in the GUI thread)
+     */
+    void decode();
+
+private:
+    // Icon cache key and size of the icons already added
+    QHash<QPair<qint64,qint64>, QString> added;
+    QHash<QString, QByteArray> data;
+    QHash<QString, QIcon> icons;
+    // Decoded by decode(), not converted into icons yet (a QPixmap is only created in the GUI thread)
+    QHash<QString, QImage> images;
+    QStringList keys;
+};
+
+}
+
+#endif // ICONTABLE_H
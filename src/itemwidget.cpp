@@ -67,7 +67,7 @@ void ItemWidget::localInit()
     setIconSize(GRAPH->getDefaultItemIconSize());
 
     // Texts:
-    description = "";
+    description.setText("");
     subText = "";
     setTextPosition(GRAPH->getDefaultItemTextPosition());
 
@@ -81,6 +81,8 @@ void ItemWidget::localInit()
 
     // Layers/Zoom:
     setBelongsToLayerZero(false);
+    setLayer(-1);
+    setSortPosition(-1);
     setZoomOutLevel(0);
 
     // Filter:
@@ -89,16 +91,31 @@ void ItemWidget::localInit()
     ////////////////////////////////////////////////////////////////////////////
     recalculateSize();
 
-    // Setup a random position over the workspace
-    moveToRandom();
+    // Setup a random position over the workspace (the loaded nodes are placed by the document or the loader)
+    if (!GRAPH->getLoading())
+        moveToRandom();
+
+    Arrange::countChildNode((QWidget *)parent(),1);
+    GRAPH->getEdgeRouter()->markNode(this);
+    journalChange(ChangeJournal::CHANGE_ADDED);
 
     // Autosort/arrange items in workspace
-    Arrange::triggerAutoArrange((QWidget *)parent());
+    Arrange::triggerAutoArrangeOnNewItem((QWidget *)parent(), this);
+}
+
+ItemWidget::ItemWidget(QWidget *parent, const QString & xml) : AbstractNodeWidget(QString(),parent)
+{
+    // Initialized with the defaults first, the XML only overrides the properties found on it
+    localInit();
+    setXML("ItemWidget",xml);
+    GRAPH->resolveLinks(QList<ItemWidget *>() << this);
 }
 
-ItemWidget::ItemWidget(QWidget *parent, const QString & xml) : AbstractNodeWidget(parent,xml, "ItemWidget")
+ItemWidget::ItemWidget(QWidget *parent, QXmlStreamReader &xml, IconTable *icons) : AbstractNodeWidget(QString(),parent)
 {
     localInit();
+    readXML(xml,icons);
+    GRAPH->resolveLinks(QList<ItemWidget *>() << this);
 }
 
 ItemWidget::ItemWidget(const QString &id, QWidget * parent, const QString & text, const QString &subtext) : AbstractNodeWidget(id,parent,text,subtext)
@@ -118,6 +135,8 @@ ItemWidget::ItemWidget(const QString &id, QWidget *parent) : AbstractNodeWidget(
 
 ItemWidget::~ItemWidget()
 {
+    GRAPH->getEdgeRouter()->markRemoved(this);
+
     // TODO: orphan links?
     // Destroy links
     while (links.size())
@@ -137,6 +156,7 @@ void ItemWidget::setIcon(const QIcon &icon)
     if ( this->icon != nullptr )
         delete this->icon;
     this->icon = new QIcon( icon );
+    journalChange(ChangeJournal::CHANGE_RESTYLED);
 }
 
 void ItemWidget::setIconSize(int w)
@@ -148,18 +168,31 @@ void ItemWidget::setIconSize(int w, int h)
 {
     IconSize.setWidth ( w );
     IconSize.setHeight ( h );
+    journalChange(ChangeJournal::CHANGE_RESTYLED);
     recalculateSize();
 }
 
+QIcon ItemWidget::getIcon() const
+{
+    return *icon;
+}
+
+QSize ItemWidget::getIconSize() const
+{
+    return IconSize;
+}
+
 void ItemWidget::setTextPosition(const ItemWidget::TextPosition & textPosition)
 {
     this->textPosition = textPosition;
+    journalChange(ChangeJournal::CHANGE_RESTYLED);
     recalculateSize();
 }
 
 void ItemWidget::setZoomOutLevel(const unsigned int &zoomOutLevel)
 {
     this->zoomOutLevel = zoomOutLevel;
+    journalChange(ChangeJournal::CHANGE_RESTYLED);
     recalculateSize();
 }
 
@@ -171,8 +204,8 @@ void ItemWidget::filter(const QString &filterText)
     }
     else if (text.toLower().contains(filterText.toLower()) ||
              subText.toLower().contains(filterText.toLower()) ||
-             description.toLower().contains(filterText.toLower()) ||
-             embeddedData.toLower().contains(filterText.toLower()))
+             description.getText().toLower().contains(filterText.toLower()) ||
+             embeddedData.getText().toLower().contains(filterText.toLower()))
         currentFilterMatch = true;
     else
     {
@@ -503,16 +536,19 @@ ItemWidget::ItemBoxShape ItemWidget::getShape() const
 void ItemWidget::setShape(ItemWidget::ItemBoxShape newShape)
 {
     this->shape = newShape;
+    journalChange(ChangeJournal::CHANGE_RESTYLED);
 }
 
 void ItemWidget::addTag(const QString &tag)
 {
     tags.insert(tag);
+    journalChange(ChangeJournal::CHANGE_RESTYLED);
 }
 
 void ItemWidget::removeTag(const QString &tag)
 {
     tags.remove(tag);
+    journalChange(ChangeJournal::CHANGE_RESTYLED);
 }
 
 QSet<QString> ItemWidget::getTags()
@@ -564,6 +600,7 @@ void ItemWidget::linkItem(ItemWidget * itemToLink, const QString & linkName, con
     {
         if ((*(Link *)links[i])==(* link))
         {
+            GRAPH->getEdgeRouter()->removeLink((Link *)links[i]);
             links.removeAll(links[i]);
             i=-1;
         }
@@ -574,9 +611,11 @@ void ItemWidget::linkItem(ItemWidget * itemToLink, const QString & linkName, con
 
     // Insert in the oppposite/linked item.
     itemToLink->addLink(link);
+    GRAPH->getChangeJournal()->markLink(this,itemToLink);
+    GRAPH->getEdgeRouter()->markLink(link);
 
     // Autosort items in workspace
-    Arrange::triggerAutoArrange(GRAPH);
+    Arrange::triggerAutoArrangeOnNewLink(GRAPH, this, itemToLink);
 }
 
 void ItemWidget::addLink(void * linkPtr)
@@ -588,6 +627,7 @@ void ItemWidget::addLink(void * linkPtr)
     {
         if ((*(Link *)links[i])==(* link))
         {
+            GRAPH->getEdgeRouter()->removeLink((Link *)links[i]);
             links.removeAll(links[i]);
             i=-1;
         }
@@ -608,12 +648,14 @@ void ItemWidget::removeLink(ItemWidget * linkedNode, bool destroyLinkObject)
         if ((*(Link *)links[i])==( x))
         {
             Link * linkToRemove = ( Link *) links[i];
+            GRAPH->getEdgeRouter()->removeLink(linkToRemove);
             if (destroyLinkObject)
                 delete linkToRemove;
             links.removeAll(linkToRemove);
             i=-1;
         }
     }
+    GRAPH->getChangeJournal()->markLink(this,linkedNode);
 }
 
 QList< void * > ItemWidget::getLinks()
@@ -621,6 +663,18 @@ QList< void * > ItemWidget::getLinks()
     return links;
 }
 
+QList<LinkDescriptor> ItemWidget::takeLinkDescriptors()
+{
+    QList<LinkDescriptor> r;
+    r.swap(linkDescriptors);
+    return r;
+}
+
+int ItemWidget::getLinksCount() const
+{
+    return links.count();
+}
+
 QPoint ItemWidget::getIconCenterPoint() const
 {
     double zoomOutFactor = getZoomOutFactor();
@@ -722,6 +776,7 @@ bool ItemWidget::getBelongsToLayerZero() const
 void ItemWidget::setBelongsToLayerZero(const bool & belongsToLayerZero)
 {
     this->belongsToLayerZero=belongsToLayerZero;
+    journalChange(ChangeJournal::CHANGE_RESTYLED);
 }
 
 void ItemWidget::calcSortPosition()
@@ -761,193 +816,111 @@ void ItemWidget::zoomOutLevelDown()
         zoomOutLevel--;
 }
 
-bool ItemWidget::setXMLLocalProperties(const QDomNode & child)
+void ItemWidget::setNodeDescriptorLocal(const NodeDescriptor &node, IconTable *icons)
 {
-    if (child.toElement().tagName() == "tags")
+    if (node.has(NodeDescriptor::PROP_TAGS))
     {
         tags.clear();
-        for (QDomNode tagChild = child.firstChild();!tagChild.isNull(); tagChild = child.nextSibling())
-        {
-            QDomElement element = tagChild.toElement();
-            if (element.tagName() == "tag")
-            {
-                addTag(QByteArray::fromBase64(QByteArray(element.text().toUtf8())));
-            }
-        }
+        for (const auto & tag : node.tags)
+            addTag(tag);
     }
-    else if (child.toElement().tagName() == "zoomOutLevel")
+    if (node.has(NodeDescriptor::PROP_ZOOMOUTLEVEL))
+        zoomOutLevel = node.zoomOutLevel;
+    if (node.has(NodeDescriptor::PROP_ICON))
     {
-        zoomOutLevel = child.toElement().text().toUInt();
+        IconSize = node.iconSize;
+        // Icons referenced by key are decoded once and shared by every item
+        if (node.iconKey.isEmpty())
+            setIcon(QIcon(QPixmap::fromImage(node.icon)));
+        else if (icons)
+            setIcon(icons->getIcon(node.iconKey));
     }
-    else if (child.toElement().tagName() == "icon")
-    {
-        if (icon) delete icon;
-
-        int x = child.toElement().attribute("x").toUInt();
-        int y = child.toElement().attribute("y").toUInt();
-
-        IconSize.setHeight(y);
-        IconSize.setWidth(x);
+    if (node.has(NodeDescriptor::PROP_TEXTPOSITION))
+        textPosition = ((ItemWidget::TextPosition)node.textPosition);
+    if (node.has(NodeDescriptor::PROP_SHAPE))
+        shape = ((ItemWidget::ItemBoxShape)node.shape);
+    if (node.has(NodeDescriptor::PROP_BELONGSTOLAYERZERO))
+        belongsToLayerZero = node.belongsToLayerZero;
+}
 
-        QByteArray bArrayElement = QByteArray::fromBase64(QByteArray(child.toElement().text().toUtf8()));
-        QPixmap pArrayElement;
-        pArrayElement.loadFromData(bArrayElement);
-        icon = new QIcon(pArrayElement);
-    }
-    else if (child.toElement().tagName() == "textPosition")
-    {
-        textPosition = ((ItemWidget::TextPosition)child.toElement().text().toUInt());
-    }
-    else if (child.toElement().tagName() == "shape")
-    {
-        shape = ((ItemWidget::ItemBoxShape)child.toElement().text().toUInt());
-    }
-    else if (child.toElement().tagName() == "belongsToLayerZero")
-    {
-        belongsToLayerZero = child.toElement().text().toUInt()==1?true:false;
-    }
-    return true;
+void ItemWidget::getNodeDescriptorLocal(NodeDescriptor *node) const
+{
+    node->properties |= NodeDescriptor::PROP_TAGS | NodeDescriptor::PROP_ZOOMOUTLEVEL | NodeDescriptor::PROP_TEXTPOSITION |
+                        NodeDescriptor::PROP_SHAPE | NodeDescriptor::PROP_BELONGSTOLAYERZERO;
+    node->tags = tags.values();
+    node->zoomOutLevel = zoomOutLevel;
+    node->iconSize = IconSize;
+    node->textPosition = textPosition;
+    node->shape = shape;
+    node->belongsToLayerZero = belongsToLayerZero;
 }
 
-bool ItemWidget::setXMLLinks(const QDomNode &master)
+bool ItemWidget::readXMLLocal(QXmlStreamReader &xml, IconTable *)
 {
-    QString id1;
-    QString id2;
-    QString link_name;
-    QColor link_color;
-    Link::Type linkType = Link::TYPE_UNDIRECTED;
-    Link::Direction linkDirection = Link::DIR_BOTH;
+    if (xml.name() != QLatin1String("links"))
+        return false;
 
-    QDomNode child = master.firstChild();
-    while (!child.isNull())
+    while (xml.readNextStartElement())
     {
-
-        if (child.toElement().tagName() == "id1")
+        if (xml.name() == QLatin1String("link"))
         {
-            QByteArray bArrayElement = QByteArray::fromBase64(QByteArray(child.toElement().text().toUtf8()));
-            id1 = QString().fromUtf8(bArrayElement.data(),bArrayElement.size());
+            // Created when every item exists (the peer can be later in the document)
+            LinkDescriptor link;
+            LinkDescriptor::read(xml,&link);
+            linkDescriptors.append(link);
         }
-        if (child.toElement().tagName() == "id2")
-        {
-            QByteArray bArrayElement = QByteArray::fromBase64(QByteArray(child.toElement().text().toUtf8()));
-            id2 = QString().fromUtf8(bArrayElement.data(),bArrayElement.size());
-        }
-        if (child.toElement().tagName() == "description")
-        {
-            QByteArray bArrayElement = QByteArray::fromBase64(QByteArray(child.toElement().text().toUtf8()));
-            link_name = QString().fromUtf8(bArrayElement.data(),bArrayElement.size());
-        }
-        else if (child.toElement().tagName() == "color")
-        {
-            int r = child.toElement().attribute("r").toUInt();
-            int g = child.toElement().attribute("g").toUInt();
-            int b = child.toElement().attribute("b").toUInt();
-            link_color.setRgb(r,g,b);
-        }
-        else if (child.toElement().tagName() == "linkType")
-        {
-            linkType = (Link::Type)child.toElement().text().toUInt();
-        }
-        else if (child.toElement().tagName() == "linkDirection")
-        {
-            linkDirection = (Link::Direction)child.toElement().text().toUInt();
-        }
-        child = child.nextSibling();
+        else
+            xml.skipCurrentElement();
     }
-
-    if (id1==id) // Link with the id2
-        linkItem(GRAPH->getItemById(id2), link_name, link_color, linkType, linkDirection );
-    else if (id2==id) //Link with the id1
-        linkItem(GRAPH->getItemById(id1), link_name, link_color, linkType, linkDirection );
-
     return true;
 }
 
-bool ItemWidget::setNodeXMLLinks(const QDomNode &master)
+void ItemWidget::writeXMLLocal(QXmlStreamWriter &xml, IconTable *)
 {
-    QDomNode child = master.firstChild();
-    while (!child.isNull())
-    {
-        if (child.toElement().tagName() == "link")
-        {
-            setXMLLinks(child);
-        }
-        child = child.nextSibling();
-    }
-    return true;
+    xml.writeStartElement("links");
+    for (int i=0;i<links.count();i++)
+        LinkDescriptor::fromLink((Link *) links[i]).write(xml);
+    xml.writeEndElement();
 }
 
-
-bool ItemWidget::setXMLLocal(const QDomNode & child)
+void ItemWidget::writeXMLLocalProperties(QXmlStreamWriter &xml, IconTable *icons)
 {
-    if (child.toElement().tagName() == "links")
+    writeXMLTags(xml);
+    XMLFunctions::writeSimpleTag(xml, "zoomOutLevel", (uint64_t)zoomOutLevel);
+
+    if (icons)
     {
-        setNodeXMLLinks(child);
+        // Reference to the document icon table
+        xml.writeEmptyElement("icon");
+        xml.writeAttribute("x",QString::number(IconSize.width()));
+        xml.writeAttribute("y",QString::number(IconSize.height()));
+        xml.writeAttribute("key",icons->add(*icon,IconSize));
     }
-    return true;
-}
-
-QString ItemWidget::getXMLLocal()
-{
-    QString exportedXML;
-    exportedXML.append("<links>");
-    for (int i=0;i<links.count();i++)
+    else
     {
-        exportedXML.append("<link>");
-        Link * link = (Link *) links[i];
+        QByteArray iconData;
+        QBuffer iconDataBuffer(&iconData);
+        iconDataBuffer.open(QIODevice::WriteOnly);
+        icon->pixmap(IconSize.width(), IconSize.height()).save(&iconDataBuffer, "PNG");
 
-        ItemWidget *xitem1=(ItemWidget *)link->getItem1();
-        ItemWidget *xitem2=(ItemWidget *)link->getItem2();
-
-        exportedXML.append(QString("<id1>%1</id1>").arg( QString( xitem1->getID().toUtf8().toBase64()) ));
-        exportedXML.append(QString("<id2>%1</id2>").arg( QString( xitem2->getID().toUtf8().toBase64()) ));
-        exportedXML.append(QString("<description>%1</description>").arg( QString(link->getDescription().toUtf8().toBase64()) ));
-        exportedXML.append(QString("<color r=\"%1\" g=\"%2\" b=\"%3\"></color>").arg(
-                               QString().setNum(link->getColor().red()),
-                               QString().setNum(link->getColor().green()),
-                               QString().setNum(link->getColor().blue()))
-                           );
-        exportedXML.append(QString("<linkType>%1</linkType>").arg( QString().setNum(link->getType()) ));
-        exportedXML.append(QString("<linkDirection>%1</linkDirection>").arg( QString().setNum(link->getArcDirection()) ));
-
-        exportedXML.append("</link>");
+        xml.writeStartElement("icon");
+        xml.writeAttribute("x",QString::number(IconSize.width()));
+        xml.writeAttribute("y",QString::number(IconSize.height()));
+        xml.writeCharacters(QString(iconData.toBase64()));
+        xml.writeEndElement();
     }
-    exportedXML.append("</links>");
-    return exportedXML;
-}
-
-QString ItemWidget::getXMLLocalProperties()
-{
-    QString exportedXML;
 
-    QByteArray iconData;
-    QBuffer iconDataBuffer(&iconData);
-    iconDataBuffer.open(QIODevice::WriteOnly);
-    icon->pixmap(IconSize.width(), IconSize.height()).save(&iconDataBuffer, "PNG");
-
-    exportedXML.append( getXMLTags() );
-    exportedXML.append( XMLFunctions::createSimpleTag("zoomOutLevel", (uint64_t)zoomOutLevel));
-    exportedXML.append(QString("<icon x=\"%1\" y=\"%2\">%3</icon>").arg(
-                           QString().setNum(IconSize.width()),
-                           QString().setNum(IconSize.height()),
-                           QString(iconData.toBase64())
-                           ));
-
-    exportedXML.append( XMLFunctions::createSimpleTag("textPosition", (uint64_t)textPosition));
-    exportedXML.append( XMLFunctions::createSimpleTag("shape", (uint64_t)shape));
-    exportedXML.append( XMLFunctions::createSimpleTag("belongsToLayerZero", belongsToLayerZero));
-    return exportedXML;
+    XMLFunctions::writeSimpleTag(xml, "textPosition", (uint64_t)textPosition);
+    XMLFunctions::writeSimpleTag(xml, "shape", (uint64_t)shape);
+    XMLFunctions::writeSimpleTag(xml, "belongsToLayerZero", belongsToLayerZero);
 }
 
-QString ItemWidget::getXMLTags()
+void ItemWidget::writeXMLTags(QXmlStreamWriter &xml)
 {
-    QString r;
-    r+="<tags>\n";
+    xml.writeStartElement("tags");
     for (const auto &tag: qAsConst(tags))
-        r+=QString::asprintf("<tag>%s</tag>\n", tag.toUtf8().toBase64().toStdString().c_str());
-    r+="</tags>\n";
-
-    return r;
+        xml.writeTextElement("tag", QString(tag.toUtf8().toBase64()));
+    xml.writeEndElement();
 }
 
 void ItemWidget::selectRecursivelyAllLinkedItems()
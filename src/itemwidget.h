@@ -3,6 +3,7 @@
 
 #include "abstractnodewidget.h"
 #include "link.h"
+#include "linkdescriptor.h"
 
 #include <QSet>
 
@@ -22,6 +23,14 @@ public:
      * @param xml XML to initialize this node.
      */
     ItemWidget(QWidget *parent, const QString &xml);
+    /**
+     * @brief ItemWidget Constructor
+     * @param parent items container (group or graph)
+     * @param xml XML reader positioned at the ItemWidget start element (it is left after the end element)
+     *            (the links to the items already in the graph are created, the others are dropped)
+     * @param icons document icon table (to resolve the icon keys), or nullptr
+     */
+    ItemWidget(QWidget *parent, QXmlStreamReader &xml, IconTable * icons = nullptr);
     /**
      * @brief ItemWidget Constructor
      * @param id new item id
@@ -89,6 +98,16 @@ public:
      * @return Get links pointer addresss (of type Link*)
      */
     QList<void *> getLinks();
+    /**
+     * @brief getLinksCount Get how many links this item have (without copying the links list)
+     * @return links count
+     */
+    int getLinksCount() const;
+    /**
+     * @brief takeLinkDescriptors Take the links read from XML and not created yet (see GraphWidget::resolveLinks)
+     * @return link descriptors
+     */
+    QList<LinkDescriptor> takeLinkDescriptors();
 
     /* Item Configuration Scheme */
 
@@ -109,6 +128,16 @@ public:
      * @param h height
      */
     void setIconSize(int w, int h);
+    /**
+     * @brief getIcon Get Icon
+     * @return icon data
+     */
+    QIcon getIcon() const;
+    /**
+     * @brief getIconSize Get Icon Size
+     * @return icon size
+     */
+    QSize getIconSize() const;
     /**
      * @brief getIconCenterPoint Get Icon Center Point
      * @return item position of the icon center
@@ -234,13 +263,14 @@ protected:
     virtual void paintEvent( QPaintEvent* );
     void localInit();
 
-    QString getXMLLocal();
-    QString getXMLLocalProperties();
+    void writeXMLLocal(QXmlStreamWriter & xml, IconTable * icons);
+    void writeXMLLocalProperties(QXmlStreamWriter & xml, IconTable * icons);
 
-    QString getXMLTags();
+    void writeXMLTags(QXmlStreamWriter & xml);
 
-    bool setXMLLocalProperties(const QDomNode &child);
-    bool setXMLLocal(const QDomNode & child);
+    bool readXMLLocal(QXmlStreamReader & xml, IconTable * icons);
+    void setNodeDescriptorLocal(const NodeDescriptor & node, IconTable * icons);
+    void getNodeDescriptorLocal(NodeDescriptor * node) const;
 
     void setInternalObjectID();
 
@@ -262,6 +292,8 @@ private:
 
     // Linked Nodes
     QList<void *> links;
+    // Links read from XML, until every item of the document exists
+    QList<LinkDescriptor> linkDescriptors;
     bool isOneLinkedNodeFiltered();
 
     // Temp vars
@@ -269,10 +301,6 @@ private:
 
     // Private methods
     void recalculateSize();
-
-    // XML
-    bool setNodeXMLLinks(const QDomNode & master);
-    bool setXMLLinks(const QDomNode & master);
 };
 
 }
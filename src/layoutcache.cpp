@@ -0,0 +1,331 @@
+#include "layoutcache.h"
+#include "graphwidget.h"
+#include "groupwidget.h"
+#include "itemwidget.h"
+#include "link.h"
+#include "arrange.h"
+
+#include <QDataStream>
+#include <QFile>
+#include <QSaveFile>
+
+using namespace QNodeGraph;
+
+// Results kept (the oldest is removed when full)
+#define LAYOUTCACHE_ENTRIES 16
+// Cache file header
+#define LAYOUTCACHE_MAGIC 0x514E4743
+#define LAYOUTCACHE_VERSION 3
+// Delay of the cache file write (a burst of arranges is written once)
+#define LAYOUTCACHE_SAVE_INTERVAL 3000
+
+namespace
+{
+
+// FNV-1a (64 bits), stable across runs and Qt versions
+class Fingerprint
+{
+public:
+    Fingerprint() : hash(0xcbf29ce484222325ULL) {}
+
+    void add(const void * data, int size)
+    {
+        const unsigned char * bytes = (const unsigned char *)data;
+        for (int i=0; i<size; i++)
+        {
+            hash ^= bytes[i];
+            hash *= 0x100000001b3ULL;
+        }
+    }
+    void add(qint32 value)
+    {
+        add(&value,sizeof(value));
+    }
+    void add(const QSize & size)
+    {
+        add(size.width());
+        add(size.height());
+    }
+    void add(const QString & text)
+    {
+        add(text.size());
+        add(text.constData(),text.size()*sizeof(QChar));
+    }
+
+    quint64 hash;
+};
+
+}
+
+LayoutCache::LayoutCache()
+{
+    enabled = true;
+
+    saveTimer.setSingleShot(true);
+    saveTimer.setInterval(LAYOUTCACHE_SAVE_INTERVAL);
+    QObject::connect(&saveTimer, &QTimer::timeout, [this]() { save(); });
+}
+
+LayoutCache::~LayoutCache()
+{
+    if (saveTimer.isActive())
+        save();
+}
+
+quint64 LayoutCache::fingerprint(QWidget *v, int mode, int sortBy, int spacing, bool byComponents)
+{
+    Fingerprint f;
+    f.add(mode);
+    f.add(sortBy);
+    f.add(spacing);
+    f.add(byComponents? 1 : 0);
+    // (The container size is not an input: the arrange resizes it)
+    f.add(v->objectName().startsWith("GROUP-")? ((AbstractNodeWidget *)v)->getVerticalOffset() : 0);
+
+    QList<AbstractNodeWidget *> nodes;
+    collectNodes(v,mode,&nodes);
+    f.add(nodes.count());
+
+    for (auto node : nodes)
+    {
+        // The object name contains the node type and ID
+        f.add(node->objectName());
+        f.add(node->parentWidget()->objectName());
+        // The size of the groups arranged by the hierarchical layout is a result
+        bool nested = mode==Arrange::ARRANGEALG_HIERARCHICAL && node->objectName().startsWith("GROUP-") && ((GroupWidget *)node)->getAutoArrange();
+        if (!nested)
+            f.add(node->size());
+
+        // Anchored nodes are obstacles for the other nodes
+        f.add(node->getAnchor()? 1 : 0);
+        if (node->getAnchor())
+        {
+            f.add(node->pos().x());
+            f.add(node->pos().y());
+        }
+
+        if (sortBy!=0)
+        {
+            f.add(node->getText());
+            f.add(node->getSubText());
+        }
+
+        if (node->objectName().startsWith("ITEM-"))
+        {
+            ItemWidget * item = (ItemWidget *)node;
+            f.add(item->getBelongsToLayerZero()? 1 : 0);
+            for (auto _link : item->getLinks())
+            {
+                Link * link = (Link *)_link;
+                AbstractNodeWidget * peer = (AbstractNodeWidget *)(link->getItem1()==item ? link->getItem2() : link->getItem1());
+                f.add(peer->objectName());
+                // The direction as seen from this item (the layered layouts follow it)
+                f.add(link->getItem1()==item? 1 : 2);
+                f.add((int)link->getArcDirection());
+            }
+        }
+        else if (mode==Arrange::ARRANGEALG_HIERARCHICAL)
+        {
+            // The groups contents are arranged with their own options by the hierarchical layout
+            GroupWidget * group = (GroupWidget *)node;
+            f.add(group->getAutoArrange()? 1 : 0);
+            f.add(group->getVerticalOffset());
+            f.add(group->getAutoArrangeAlgorithm());
+            f.add(group->getAutoArrangeSpacing());
+            f.add(group->getSortBy());
+        }
+    }
+
+    return f.hash;
+}
+
+bool LayoutCache::restore(QWidget *v, quint64 key, int mode)
+{
+    if (!enabled)
+        return false;
+
+    auto it = entries.constFind(key);
+    if (it==entries.constEnd())
+        return false;
+
+    QList<AbstractNodeWidget *> nodes;
+    collectNodes(v,mode,&nodes);
+
+    const Entry & entry = it.value();
+    if (entry.geometries.count()!=nodes.count())
+        return false;
+
+    for (int i=0; i<nodes.count(); i++)
+    {
+        AbstractNodeWidget * node = nodes[i];
+        const QRect & geometry = entry.geometries[i];
+
+        if (node->objectName().startsWith("ITEM-"))
+        {
+            ((ItemWidget *)node)->setLayer(entry.layers[i]);
+            ((ItemWidget *)node)->setSortPosition(entry.sortPositions[i]);
+        }
+
+        if (node->size()!=geometry.size())
+            node->resize(geometry.size());
+        if (!node->getAnchor() && node->pos()!=geometry.topLeft())
+            node->move(geometry.topLeft());
+    }
+
+    if (v->size()!=entry.containerSize)
+        v->resize(entry.containerSize);
+
+    return true;
+}
+
+void LayoutCache::store(QWidget *v, quint64 key, int mode)
+{
+    if (!enabled)
+        return;
+
+    QList<AbstractNodeWidget *> nodes;
+    collectNodes(v,mode,&nodes);
+
+    Entry entry;
+    entry.containerSize = v->size();
+    entry.geometries.reserve(nodes.count());
+    entry.layers.reserve(nodes.count());
+    entry.sortPositions.reserve(nodes.count());
+    for (auto node : nodes)
+    {
+        bool isItem = node->objectName().startsWith("ITEM-");
+        entry.geometries.append(node->geometry());
+        entry.layers.append(isItem? ((ItemWidget *)node)->getLayer() : -1);
+        entry.sortPositions.append(isItem? ((ItemWidget *)node)->getSortPosition() : -1);
+    }
+
+    if (entries.contains(key))
+        order.removeOne(key);
+    else if (order.count()>=LAYOUTCACHE_ENTRIES)
+        entries.remove(order.takeFirst());
+
+    entries.insert(key,entry);
+    order.append(key);
+
+    if (!file.isEmpty())
+        saveTimer.start();
+}
+
+void LayoutCache::clear()
+{
+    entries.clear();
+    order.clear();
+}
+
+bool LayoutCache::getEnabled() const
+{
+    return enabled;
+}
+
+void LayoutCache::setEnabled(bool newEnabled)
+{
+    enabled = newEnabled;
+}
+
+QString LayoutCache::getFile() const
+{
+    return file;
+}
+
+int LayoutCache::setFile(const QString &newFile)
+{
+    if (saveTimer.isActive())
+    {
+        saveTimer.stop();
+        save();
+    }
+
+    file = newFile;
+    if (file.isEmpty())
+        return 0;
+    return load();
+}
+
+void LayoutCache::collectNodes(QWidget *v, int mode, QList<AbstractNodeWidget *> *nodes)
+{
+    for (auto node : GraphWidget::allChildrenItemsAndGroups(v))
+    {
+        if (mode==Arrange::ARRANGEALG_HIERARCHICAL && node->objectName().startsWith("GROUP-") && ((GroupWidget *)node)->getAutoArrange())
+            collectNodes(node,mode,nodes);
+        nodes->append(node);
+    }
+}
+
+int LayoutCache::load()
+{
+    QFile f(file);
+    if (!f.exists())
+        return 1;
+    if (!f.open(QIODevice::ReadOnly))
+        return -1;
+
+    QDataStream in(&f);
+    in.setVersion(QDataStream::Qt_5_0);
+
+    quint32 magic, version;
+    qint32 count;
+    in >> magic >> version >> count;
+    if (magic!=LAYOUTCACHE_MAGIC || version!=LAYOUTCACHE_VERSION || count<0)
+        return -2;
+
+    QHash<quint64, Entry> loadedEntries;
+    QList<quint64> loadedOrder;
+    for (int e=0; e<count; e++)
+    {
+        quint64 key;
+        qint32 nodesCount;
+        Entry entry;
+        in >> key >> entry.containerSize >> nodesCount;
+        // Every node takes 24 bytes (don't trust the count of a broken file)
+        if (in.status()!=QDataStream::Ok || nodesCount<0 || nodesCount>(f.size()-f.pos())/24)
+            return -3;
+
+        entry.geometries.resize(nodesCount);
+        entry.layers.resize(nodesCount);
+        entry.sortPositions.resize(nodesCount);
+        for (int i=0; i<nodesCount; i++)
+        {
+            qint32 layer, sortPosition;
+            in >> entry.geometries[i] >> layer >> sortPosition;
+            entry.layers[i] = layer;
+            entry.sortPositions[i] = sortPosition;
+        }
+        if (in.status()!=QDataStream::Ok)
+            return -3;
+
+        loadedEntries.insert(key,entry);
+        loadedOrder.removeOne(key);
+        loadedOrder.append(key);
+    }
+
+    entries = loadedEntries;
+    order = loadedOrder;
+    return 0;
+}
+
+int LayoutCache::save() const
+{
+    // Written into a temporary file and renamed, so a crash never leaves a broken cache
+    QSaveFile f(file);
+    if (!f.open(QIODevice::WriteOnly))
+        return -1;
+
+    QDataStream out(&f);
+    out.setVersion(QDataStream::Qt_5_0);
+    out << (quint32)LAYOUTCACHE_MAGIC << (quint32)LAYOUTCACHE_VERSION << (qint32)order.count();
+
+    for (quint64 key : order)
+    {
+        const Entry & entry = *entries.constFind(key);
+        out << key << entry.containerSize << (qint32)entry.geometries.count();
+        for (int i=0; i<entry.geometries.count(); i++)
+            out << entry.geometries[i] << (qint32)entry.layers[i] << (qint32)entry.sortPositions[i];
+    }
+
+    return f.commit()? 0 : -2;
+}
@@ -0,0 +1,124 @@
+#ifndef LAYOUTCACHE_H
+#define LAYOUTCACHE_H
+
+#include <QWidget>
+#include <QHash>
+#include <QList>
+#include <QVector>
+#include <QRect>
+#include <QString>
+#include <QTimer>
+
+namespace QNodeGraph
+{
+
+class AbstractNodeWidget;
+
+/**
+ * @brief The LayoutCache class Results of the last arranges, keyed by a fingerprint of the container
+ *
+ * The fingerprint is a stable hash (the same across runs) of the arrange inputs: node IDs, links (and their direction), sizes
+ * and arrange options, so when nothing changed the stored geometries are applied instead of running the
+ * algorithm again. Only the nodes placed by the algorithm are considered (the contents of the nested groups
+ * only for the hierarchical mode). The cache can be persisted into a local file, written a few seconds after
+ * the last change.
+ */
+class LayoutCache
+{
+public:
+    LayoutCache();
+    ~LayoutCache();
+
+    /**
+     * @brief fingerprint Compute the fingerprint of a container for an arrange
+     * @param v group or graph
+     * @param mode algorithm (cast from Arrange::Mode)
+     * @param sortBy sort by policy (cast from Arrange::SortBy)
+     * @param spacing spacing
+     * @param byComponents arrange by connected components
+     * @return fingerprint
+     */
+    static quint64 fingerprint(QWidget * v, int mode, int sortBy, int spacing, bool byComponents);
+
+    /**
+     * @brief restore Apply the stored result of an arrange (anchored nodes are not moved)
+     * @param v group or graph
+     * @param key fingerprint
+     * @param mode algorithm used for the fingerprint
+     * @return true if the result was found and applied
+     */
+    bool restore(QWidget * v, quint64 key, int mode);
+    /**
+     * @brief store Store the current geometries of the container nodes as the result of an arrange
+     *              (and schedule the write of the cache file if configured)
+     * @param v group or graph
+     * @param key fingerprint
+     * @param mode algorithm used for the fingerprint
+     */
+    void store(QWidget * v, quint64 key, int mode);
+    /**
+     * @brief clear Remove every stored result (the cache file is not modified)
+     */
+    void clear();
+
+    /**
+     * @brief getEnabled Get if the arrange results are cached
+     * @return true if enabled
+     */
+    bool getEnabled() const;
+    /**
+     * @brief setEnabled Enable or disable the cache
+     * @param newEnabled true to enable
+     */
+    void setEnabled(bool newEnabled);
+
+    /**
+     * @brief getFile Get the cache file
+     * @return file path (empty when the cache is only kept in memory)
+     */
+    QString getFile() const;
+    /**
+     * @brief setFile Set the cache file and load the results stored on it (the pending results are written to the previous file)
+     * @param newFile file path (empty to keep the cache only in memory)
+     * @return 0 if loaded, 1 if the file does not exist yet, negative on errors
+     */
+    int setFile(const QString & newFile);
+
+private:
+    struct Entry
+    {
+        QSize containerSize;
+        QVector<QRect> geometries;
+        QVector<int> layers, sortPositions;
+    };
+
+    /**
+     * @brief collectNodes Get the nodes placed by an arrange of the container: his nodes, and for the hierarchical mode
+     *                     the contents of the nested groups with auto arrange enabled (groups after their contents)
+     * @param v container
+     * @param mode algorithm
+     * @param nodes output nodes
+     */
+    static void collectNodes(QWidget * v, int mode, QList<AbstractNodeWidget *> * nodes);
+    /**
+     * @brief load Load the cache file
+     * @return 0 if loaded, 1 if the file does not exist yet, negative on errors
+     */
+    int load();
+    /**
+     * @brief save Write the cache file
+     * @return 0 if succeed
+     */
+    int save() const;
+
+    QHash<quint64, Entry> entries;
+    // Keys from the oldest to the newest (the oldest is removed when full)
+    QList<quint64> order;
+    QString file;
+    bool enabled;
+    QTimer saveTimer;
+};
+
+}
+
+#endif // LAYOUTCACHE_H
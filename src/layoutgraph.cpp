@@ -0,0 +1,313 @@
+#include "layoutgraph.h"
+#include "graphwidget.h"
+#include "groupwidget.h"
+#include "itemwidget.h"
+#include "link.h"
+
+#include <algorithm>
+
+using namespace QNodeGraph;
+
+LayoutGraph::LayoutGraph()
+{
+    verticalOffset = 0;
+}
+
+LayoutGraph LayoutGraph::fromContainer(QWidget *v)
+{
+    int pVerticalOffset = v->objectName().startsWith("GROUP-")? ((AbstractNodeWidget *)v)->getVerticalOffset() : 0;
+    return fromItems(GraphWidget::allChildrenItems(v), v->size(), pVerticalOffset);
+}
+
+LayoutGraph LayoutGraph::fromItems(const QList<ItemWidget *> &items, const QSize &area, int verticalOffset)
+{
+    LayoutGraph g;
+    g.area = area;
+    g.verticalOffset = verticalOffset;
+
+    int n = items.count();
+    g.nodes.reserve(n);
+    g.sizes.reserve(n);
+    g.positions.reserve(n);
+    g.anchored.reserve(n);
+    g.layerZero.reserve(n);
+    g.index.reserve(n);
+
+    for (auto item : items)
+    {
+        g.index.insert(item, g.nodes.count());
+        g.nodes.append(item);
+        g.sizes.append(item->size());
+        g.positions.append(item->pos());
+        g.anchored.append(item->getAnchor());
+        g.layerZero.append(item->getBelongsToLayerZero());
+    }
+
+    // Build the adjacency array
+    QVector<QList<void *>> itemLinks(n);
+    int linksCount = 0;
+    for (int i=0; i<n; i++)
+    {
+        itemLinks[i] = items[i]->getLinks();
+        linksCount += itemLinks[i].count();
+    }
+
+    g.adjacencyOffsets.resize(n+1);
+    g.adjacency.reserve(linksCount);
+    for (int i=0; i<n; i++)
+    {
+        g.adjacencyOffsets[i] = g.adjacency.count();
+        for (auto _link : itemLinks[i])
+        {
+            Link * link = (Link *)_link;
+            ItemWidget * peer = (ItemWidget *)(link->getItem1()==items[i] ? link->getItem2() : link->getItem1());
+            int peerIndex = g.index.value(peer,-1);
+            // Links to items outside of this container are not part of the layout
+            if (peerIndex>=0 && peerIndex!=i)
+                g.adjacency.append(peerIndex);
+        }
+    }
+    g.adjacencyOffsets[n] = g.adjacency.count();
+
+    return g;
+}
+
+LayoutGraph LayoutGraph::fromHierarchy(QWidget *v)
+{
+    LayoutGraph g;
+    g.area = v->size();
+    g.verticalOffset = v->objectName().startsWith("GROUP-")? ((AbstractNodeWidget *)v)->getVerticalOffset() : 0;
+
+    QList<AbstractNodeWidget *> children = GraphWidget::allChildrenItemsAndGroups(v);
+    int n = children.count();
+    g.nodes.reserve(n);
+    g.sizes.reserve(n);
+    g.positions.reserve(n);
+    g.anchored.reserve(n);
+    g.layerZero.reserve(n);
+    g.index.reserve(n);
+
+    // Items represented by every node (a group represents all his nested items)
+    QVector<QList<ItemWidget *>> represented(n);
+    QHash<AbstractNodeWidget *, int> owners;
+    for (auto child : children)
+    {
+        int i = g.nodes.count();
+        bool isItem = child->objectName().startsWith("ITEM-");
+
+        g.index.insert(child, i);
+        g.nodes.append(child);
+        g.sizes.append(child->size());
+        g.positions.append(child->pos());
+        g.anchored.append(child->getAnchor());
+        g.layerZero.append(isItem && ((ItemWidget *)child)->getBelongsToLayerZero());
+
+        if (isItem)
+            represented[i].append((ItemWidget *)child);
+        else
+            represented[i] = GraphWidget::allRecursiveItems(child);
+
+        for (auto item : represented[i])
+            owners.insert(item, i);
+    }
+
+    // Aggregate the links between different nodes into weighted edges
+    QVector<int> slot(n,-1);
+    g.adjacencyOffsets.resize(n+1);
+    for (int i=0; i<n; i++)
+    {
+        g.adjacencyOffsets[i] = g.adjacency.count();
+        for (auto item : represented[i])
+        {
+            for (auto _link : item->getLinks())
+            {
+                Link * link = (Link *)_link;
+                ItemWidget * peer = (ItemWidget *)(link->getItem1()==item ? link->getItem2() : link->getItem1());
+                int peerIndex = owners.value(peer,-1);
+                // Links inside the node or to items outside of this container are not part of the layout
+                if (peerIndex<0 || peerIndex==i)
+                    continue;
+
+                if (slot[peerIndex]<g.adjacencyOffsets[i])
+                {
+                    slot[peerIndex] = g.adjacency.count();
+                    g.adjacency.append(peerIndex);
+                    g.weights.append(1);
+                }
+                else
+                    g.weights[slot[peerIndex]] += 1;
+            }
+        }
+    }
+    g.adjacencyOffsets[n] = g.adjacency.count();
+
+    return g;
+}
+
+int LayoutGraph::count() const
+{
+    return nodes.count();
+}
+
+int LayoutGraph::degree(int node) const
+{
+    return adjacencyOffsets[node+1]-adjacencyOffsets[node];
+}
+
+int LayoutGraph::neighbour(int node, int i) const
+{
+    return adjacency[adjacencyOffsets[node]+i];
+}
+
+int LayoutGraph::indexOf(AbstractNodeWidget *node) const
+{
+    return index.value(node,-1);
+}
+
+LayoutComponents LayoutGraph::findComponents() const
+{
+    LayoutComponents r;
+    int n = count();
+    r.membership.fill(-1,n);
+
+    // Bucket the nodes by degree (counting sort, descending and stable)
+    int maxDegree = 0;
+    for (int i=0; i<n; i++)
+        maxDegree = std::max(maxDegree,degree(i));
+
+    QVector<int> bucketOffsets(maxDegree+2,0);
+    for (int i=0; i<n; i++)
+        bucketOffsets[maxDegree-degree(i)+1]++;
+    for (int d=1; d<bucketOffsets.count(); d++)
+        bucketOffsets[d]+=bucketOffsets[d-1];
+
+    QVector<int> order(n);
+    for (int i=0; i<n; i++)
+        order[bucketOffsets[maxDegree-degree(i)]++] = i;
+
+    // The first unvisited node in degree order is the root of a new component
+    QVector<int> queue;
+    queue.reserve(n);
+    for (int root : order)
+    {
+        if (r.membership[root]!=-1)
+            continue;
+
+        int component = r.roots.count();
+        r.roots.append(root);
+        r.membership[root] = component;
+
+        queue.clear();
+        queue.append(root);
+        for (int head=0; head<queue.count(); head++)
+        {
+            int node = queue[head];
+            for (int i=0; i<degree(node); i++)
+            {
+                int next = neighbour(node,i);
+                if (r.membership[next]==-1)
+                {
+                    r.membership[next] = component;
+                    queue.append(next);
+                }
+            }
+        }
+    }
+
+    return r;
+}
+
+LayoutGraph LayoutGraph::subGraph(const QVector<int> &members) const
+{
+    LayoutGraph g;
+    g.area = area;
+    g.verticalOffset = verticalOffset;
+
+    int n = members.count();
+    g.nodes.reserve(n);
+    g.sizes.reserve(n);
+    g.positions.reserve(n);
+    g.anchored.reserve(n);
+    g.layerZero.reserve(n);
+    g.index.reserve(n);
+
+    for (int node : members)
+    {
+        g.index.insert(nodes[node], g.nodes.count());
+        g.nodes.append(nodes[node]);
+        g.sizes.append(sizes[node]);
+        g.positions.append(positions[node]);
+        g.anchored.append(anchored[node]);
+        g.layerZero.append(layerZero[node]);
+    }
+
+    g.adjacencyOffsets.resize(n+1);
+    for (int i=0; i<n; i++)
+    {
+        g.adjacencyOffsets[i] = g.adjacency.count();
+        for (int k=0; k<degree(members[i]); k++)
+        {
+            int peerIndex = g.index.value(nodes[neighbour(members[i],k)],-1);
+            if (peerIndex>=0)
+            {
+                g.adjacency.append(peerIndex);
+                if (!weights.isEmpty())
+                    g.weights.append(weights[adjacencyOffsets[members[i]]+k]);
+            }
+        }
+    }
+    g.adjacencyOffsets[n] = g.adjacency.count();
+
+    return g;
+}
+
+void LayoutGraph::fitCenters(const QVector<double> &x, const QVector<double> &y)
+{
+    int n = count();
+    if (!n)
+        return;
+
+    double minX = x[0], maxX = x[0], minY = y[0], maxY = y[0];
+    int maxWidth = 0, maxHeight = 0;
+    for (int i=0; i<n; i++)
+    {
+        minX = std::min(minX,x[i]);
+        maxX = std::max(maxX,x[i]);
+        minY = std::min(minY,y[i]);
+        maxY = std::max(maxY,y[i]);
+        maxWidth = std::max(maxWidth,sizes[i].width());
+        maxHeight = std::max(maxHeight,sizes[i].height());
+    }
+
+    double availableWidth = std::max(1, area.width()-maxWidth);
+    double availableHeight = std::max(1, area.height()-verticalOffset-maxHeight);
+    double scale = std::min( availableWidth/std::max(1.0,maxX-minX), availableHeight/std::max(1.0,maxY-minY) );
+    double offsetX = (maxWidth/2.0) + (availableWidth-(maxX-minX)*scale)/2;
+    double offsetY = verticalOffset + (maxHeight/2.0) + (availableHeight-(maxY-minY)*scale)/2;
+
+    for (int i=0; i<n; i++)
+    {
+        int cx = offsetX + (x[i]-minX)*scale;
+        int cy = offsetY + (y[i]-minY)*scale;
+        positions[i] = QPoint( cx-(sizes[i].width()/2), cy-(sizes[i].height()/2) );
+    }
+}
+
+void LayoutGraph::apply() const
+{
+    for (int i=0; i<nodes.count(); i++)
+    {
+        AbstractNodeWidget * node = nodes[i];
+
+        if (node->objectName().startsWith("ITEM-"))
+        {
+            if (!layers.isEmpty())
+                ((ItemWidget *)node)->setLayer(layers[i]);
+            if (!sortPositions.isEmpty())
+                ((ItemWidget *)node)->setSortPosition(sortPositions[i]);
+        }
+
+        if (!anchored[i] && node->pos()!=positions[i])
+            node->move(positions[i]);
+    }
+}
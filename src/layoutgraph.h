@@ -0,0 +1,137 @@
+#ifndef LAYOUTGRAPH_H
+#define LAYOUTGRAPH_H
+
+#include <QWidget>
+#include <QVector>
+#include <QHash>
+#include <QPoint>
+#include <QSize>
+
+namespace QNodeGraph
+{
+
+class AbstractNodeWidget;
+class ItemWidget;
+
+/**
+ * @brief The LayoutComponents struct Connected components of a layout graph
+ */
+struct LayoutComponents
+{
+    // One root for each component (the node with more links), sorted by links count
+    QVector<int> roots;
+    // Component number (index in roots) for each node
+    QVector<int> membership;
+};
+
+/**
+ * @brief The LayoutGraph class Plain snapshot of the nodes of a container used by the layout algorithms
+ *
+ * Layout algorithms work over this snapshot (sizes, positions and a compact adjacency array)
+ * without touching the widgets, then apply() moves the widgets in one batch.
+ */
+class LayoutGraph
+{
+public:
+    LayoutGraph();
+
+    /**
+     * @brief fromContainer Take a snapshot of the children items of a container (group or graph)
+     * @param v container
+     * @return layout graph
+     */
+    static LayoutGraph fromContainer(QWidget * v);
+    /**
+     * @brief fromItems Take a snapshot of a list of items (links to items outside the list are ignored)
+     * @param items items
+     * @param area available area
+     * @param verticalOffset reserved pixels on the top of the area
+     * @return layout graph
+     */
+    static LayoutGraph fromItems(const QList<ItemWidget *> & items, const QSize & area, int verticalOffset = 0);
+    /**
+     * @brief fromHierarchy Take a snapshot of the children items and groups of a container, the links of the items
+     *                      nested into a group are attributed to the group and aggregated into weighted edges
+     * @param v container
+     * @return layout graph (with weights)
+     */
+    static LayoutGraph fromHierarchy(QWidget * v);
+
+    /**
+     * @brief count Get the nodes count
+     * @return nodes count
+     */
+    int count() const;
+    /**
+     * @brief degree Get how many neighbours the node have
+     * @param node node index
+     * @return neighbours count
+     */
+    int degree(int node) const;
+    /**
+     * @brief neighbour Get a neighbour of the node
+     * @param node node index
+     * @param i neighbour number (from 0 to degree-1)
+     * @return neighbour node index
+     */
+    int neighbour(int node, int i) const;
+    /**
+     * @brief indexOf Get the index of a node in the graph
+     * @param node node widget
+     * @return index or -1 if not found
+     */
+    int indexOf(AbstractNodeWidget * node) const;
+    /**
+     * @brief findComponents Discover the connected components and select the node with more links of each one as root
+     *                       (on ties, the first node in the container order)
+     * @return roots and component membership
+     */
+    LayoutComponents findComponents() const;
+    /**
+     * @brief subGraph Take a snapshot of some nodes of this graph (links to other nodes are ignored)
+     * @param members node indexes in this graph, they will be the nodes 0..n-1 of the new graph
+     * @return layout graph (with the same area and vertical offset)
+     */
+    LayoutGraph subGraph(const QVector<int> & members) const;
+
+    /**
+     * @brief fitCenters Scale uniformly a set of node centers into the area and store them as the node positions
+     * @param x center x coordinate of each node (any unit)
+     * @param y center y coordinate of each node (any unit)
+     */
+    void fitCenters(const QVector<double> & x, const QVector<double> & y);
+
+    /**
+     * @brief apply Move the widgets to the computed positions (anchored nodes are not moved)
+     *              and store the layer/sort information into the items.
+     */
+    void apply() const;
+
+    // Nodes
+    QVector<AbstractNodeWidget *> nodes;
+    QVector<QSize> sizes;
+    QVector<QPoint> positions;
+    QVector<bool> anchored;
+    QVector<bool> layerZero;
+
+    // Layer information (empty if not computed by the algorithm)
+    QVector<int> layers;
+    QVector<int> sortPositions;
+
+    // Compact adjacency array (CSR): neighbours of i are adjacency[adjacencyOffsets[i]..adjacencyOffsets[i+1]-1]
+    QVector<int> adjacencyOffsets;
+    QVector<int> adjacency;
+    // Weight of each adjacency entry (aggregated links), empty when every link weights 1
+    QVector<double> weights;
+
+    // Container
+    QSize area;
+    int verticalOffset;
+
+private:
+    QHash<AbstractNodeWidget *, int> index;
+};
+
+}
+
+#endif // LAYOUTGRAPH_H
@@ -0,0 +1,72 @@
+#include "layoutrandom.h"
+
+#include <random>
+
+using namespace QNodeGraph;
+
+static inline quint64 rotl(quint64 x, int k)
+{
+    return (x << k) | (x >> (64 - k));
+}
+
+LayoutRandom::LayoutRandom()
+{
+    std::random_device rd;
+    setSeed((((quint64)rd())<<32) | rd());
+}
+
+LayoutRandom::LayoutRandom(quint64 seed)
+{
+    setSeed(seed);
+}
+
+void LayoutRandom::setSeed(quint64 seed)
+{
+    this->seed = seed;
+
+    // Expand the seed using splitmix64 (the state can not be all zeros)
+    quint64 x = seed;
+    for (int i=0; i<4; i++)
+    {
+        quint64 z = (x += 0x9E3779B97F4A7C15ULL);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        state[i] = z ^ (z >> 31);
+    }
+}
+
+quint64 LayoutRandom::getSeed() const
+{
+    return seed;
+}
+
+quint64 LayoutRandom::next()
+{
+    const quint64 result = rotl(state[1] * 5, 7) * 9;
+    const quint64 t = state[1] << 17;
+
+    state[2] ^= state[0];
+    state[3] ^= state[1];
+    state[1] ^= state[2];
+    state[0] ^= state[3];
+    state[2] ^= t;
+    state[3] = rotl(state[3], 45);
+
+    return result;
+}
+
+int LayoutRandom::bounded(int min, int max)
+{
+    if (max<=min)
+        return min;
+
+    // Multiply-shift range reduction (the bias is negligible for layout purposes)
+    quint64 range = (quint64)((qint64)max - (qint64)min) + 1;
+    quint64 r = next() >> 32;
+    return (int)((qint64)min + (qint64)((r * range) >> 32));
+}
+
+double LayoutRandom::nextDouble()
+{
+    return (next() >> 11) * (1.0 / 9007199254740992.0);
+}
@@ -0,0 +1,63 @@
+#ifndef LAYOUTRANDOM_H
+#define LAYOUTRANDOM_H
+
+#include <QtGlobal>
+
+namespace QNodeGraph
+{
+
+/**
+ * @brief The LayoutRandom class Fast and reproducible random generator (xoshiro256**) for the randomized layouts
+ *
+ * The same seed always produces the same sequence, so layouts can be repeated across runs and builds.
+ */
+class LayoutRandom
+{
+public:
+    /**
+     * @brief LayoutRandom Constructor (seeded from the system entropy source)
+     */
+    LayoutRandom();
+    /**
+     * @brief LayoutRandom Constructor
+     * @param seed seed
+     */
+    LayoutRandom(quint64 seed);
+
+    /**
+     * @brief setSeed Restart the sequence using a seed
+     * @param seed seed
+     */
+    void setSeed(quint64 seed);
+    /**
+     * @brief getSeed Get the seed used to start the current sequence
+     * @return seed
+     */
+    quint64 getSeed() const;
+
+    /**
+     * @brief next Get the next 64bit random number
+     * @return random number
+     */
+    quint64 next();
+    /**
+     * @brief bounded Get a random integer in the closed range [min,max]
+     * @param min minimum value
+     * @param max maximum value (if lower than min, min is returned)
+     * @return random integer
+     */
+    int bounded(int min, int max);
+    /**
+     * @brief nextDouble Get a random double in [0,1)
+     * @return random double
+     */
+    double nextDouble();
+
+private:
+    quint64 seed;
+    quint64 state[4];
+};
+
+}
+
+#endif // LAYOUTRANDOM_H
@@ -25,7 +25,7 @@ bool Link::operator ==( const Link & other) const
         return false;
 }
 
-void Link::paint(QPainter &painter, const QColor & backgroundColor)
+void Link::paint(QPainter &painter, const QColor & backgroundColor, const QPolygon * route)
 {
     ItemWidget * item1 = (ItemWidget *) this->getItem1();
     ItemWidget * item2 = (ItemWidget *) this->getItem2();
@@ -79,8 +79,10 @@ void Link::paint(QPainter &painter, const QColor & backgroundColor)
     {
         if (1)
         {
-            int a = element1Pos.y()-element2Pos.y();
-            int b = element1Pos.x()-element2Pos.x();
+            // Routed links leave the item in the direction of their first segment
+            QPoint toward = route? route->at(1) : element2Pos;
+            int a = element1Pos.y()-toward.y();
+            int b = element1Pos.x()-toward.x();
 
             auto alpha = atan( (double)a/(double)b );
             if (b>=0) alpha+=PI;
@@ -122,8 +124,9 @@ void Link::paint(QPainter &painter, const QColor & backgroundColor)
 
         if (1)
         {
-            int a = element2Pos.y()-element1Pos.y();
-            int b = element2Pos.x()-element1Pos.x();
+            QPoint toward = route? route->at(route->count()-2) : element1Pos;
+            int a = element2Pos.y()-toward.y();
+            int b = element2Pos.x()-toward.x();
 
             auto alpha = atan( (double)a/(double)b )+PI;
             if (b<0) alpha+=PI;
@@ -170,10 +173,18 @@ void Link::paint(QPainter &painter, const QColor & backgroundColor)
         element2Pos = item2->getAbsolutePos() + item2->getIconCenterPoint();
     }
 
-    painter.drawLine(
-                element1Pos,
-                element2Pos
-                );
+    if (route)
+    {
+        QPolygon line = *route;
+        line.first() = element1Pos;
+        line.last() = element2Pos;
+        painter.drawPolyline(line);
+    }
+    else
+        painter.drawLine(
+                    element1Pos,
+                    element2Pos
+                    );
 }
 
 void Link::setItems(void * item1, void * item2)
@@ -25,8 +25,9 @@ public:
      * @brief paint paint this link into the painter object
      * @param painter painter object
      * @param backgroundColor background color (to avoid non-visible links)
+     * @param route routed polyline from the first item to the second one (nullptr for a straight line)
      */
-    void paint(QPainter & painter, const QColor &backgroundColor);
+    void paint(QPainter & painter, const QColor &backgroundColor, const QPolygon * route = nullptr);
 
     // Items:
     /**
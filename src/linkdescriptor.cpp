@@ -0,0 +1,73 @@
+#include "linkdescriptor.h"
+#include "link.h"
+#include "itemwidget.h"
+#include "xmlfunctions.h"
+
+using namespace QNodeGraph;
+
+LinkDescriptor::LinkDescriptor()
+{
+    type = Link::TYPE_UNDIRECTED;
+    direction = Link::DIR_BOTH;
+}
+
+bool LinkDescriptor::read(QXmlStreamReader &xml, LinkDescriptor *link)
+{
+    while (xml.readNextStartElement())
+    {
+        auto name = xml.name();
+
+        if (name == QLatin1String("id1"))
+            link->id1 = XMLFunctions::fromBase64(xml.readElementText());
+        else if (name == QLatin1String("id2"))
+            link->id2 = XMLFunctions::fromBase64(xml.readElementText());
+        else if (name == QLatin1String("description"))
+            link->description = XMLFunctions::fromBase64(xml.readElementText());
+        else if (name == QLatin1String("color"))
+        {
+            // Links are stored without alpha
+            QXmlStreamAttributes attributes = xml.attributes();
+            link->color.setRgb(attributes.value("r").toInt(),attributes.value("g").toInt(),attributes.value("b").toInt());
+            xml.skipCurrentElement();
+        }
+        else if (name == QLatin1String("linkType"))
+            link->type = xml.readElementText().toInt();
+        else if (name == QLatin1String("linkDirection"))
+            link->direction = xml.readElementText().toInt();
+        else
+            xml.skipCurrentElement();
+    }
+
+    return !xml.hasError();
+}
+
+LinkDescriptor LinkDescriptor::fromLink(Link *link)
+{
+    LinkDescriptor r;
+    r.id1 = ((ItemWidget *)link->getItem1())->getID();
+    r.id2 = ((ItemWidget *)link->getItem2())->getID();
+    r.description = link->getDescription();
+    r.color = link->getColor();
+    r.type = link->getType();
+    r.direction = link->getArcDirection();
+    return r;
+}
+
+void LinkDescriptor::write(QXmlStreamWriter &xml) const
+{
+    xml.writeStartElement("link");
+
+    xml.writeTextElement("id1", QString( id1.toUtf8().toBase64()) );
+    xml.writeTextElement("id2", QString( id2.toUtf8().toBase64()) );
+    xml.writeTextElement("description", QString(description.toUtf8().toBase64()) );
+
+    xml.writeEmptyElement("color");
+    xml.writeAttribute("r",QString::number(color.red()));
+    xml.writeAttribute("g",QString::number(color.green()));
+    xml.writeAttribute("b",QString::number(color.blue()));
+
+    xml.writeTextElement("linkType", QString::number(type) );
+    xml.writeTextElement("linkDirection", QString::number(direction) );
+
+    xml.writeEndElement();
+}
@@ -0,0 +1,50 @@
+#ifndef LINKDESCRIPTOR_H
+#define LINKDESCRIPTOR_H
+
+#include <QString>
+#include <QColor>
+#include <QXmlStreamReader>
+#include <QXmlStreamWriter>
+
+namespace QNodeGraph
+{
+
+class Link;
+
+/**
+ * @brief The LinkDescriptor class Link read from a document (items referenced by ID)
+ */
+class LinkDescriptor
+{
+public:
+    LinkDescriptor();
+
+    /**
+     * @brief read Read a <link> element
+     * @param xml XML reader positioned at the <link> start element (it is left after the end element)
+     * @param link output descriptor
+     * @return true if succeed
+     */
+    static bool read(QXmlStreamReader & xml, LinkDescriptor * link);
+    /**
+     * @brief fromLink Get the descriptor of a link between two items
+     * @param link link
+     * @return descriptor
+     */
+    static LinkDescriptor fromLink(Link * link);
+
+    /**
+     * @brief write Write this link as a <link> element
+     * @param xml XML writer
+     */
+    void write(QXmlStreamWriter & xml) const;
+
+    QString id1, id2, description;
+    QColor color;
+    // Cast from Link::Type and Link::Direction
+    int type, direction;
+};
+
+}
+
+#endif // LINKDESCRIPTOR_H
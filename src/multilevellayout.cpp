@@ -0,0 +1,316 @@
+#include "multilevellayout.h"
+#include "layoutgraph.h"
+#include "layoutrandom.h"
+#include "parallel.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace QNodeGraph;
+
+// Nodes computed by each parallel task in the refinement
+#define REFINE_CHUNK 1024
+// Stop coarsening at this size
+#define COARSEST_SIZE 50
+
+MultilevelLayout::MultilevelLayout()
+{
+}
+
+int MultilevelLayout::layout(LayoutGraph *graph)
+{
+    int n = graph->count();
+    if (!n)
+        return 0;
+
+    // Finest level from the layout graph
+    QVector<Level> levels(1);
+    Level & finest = levels[0];
+    finest.offsets = graph->adjacencyOffsets;
+    finest.adjacency = graph->adjacency;
+    if (graph->weights.isEmpty())
+        finest.weights.fill(1.0,graph->adjacency.count());
+    else
+        finest.weights = graph->weights;
+    finest.mass.fill(1.0,n);
+
+    // Ideal edge length from the node sizes
+    double k = 0;
+    for (const QSize & s : graph->sizes)
+        k += std::max(s.width(),s.height());
+    k = std::max(10.0, 1.5*k/n);
+
+    // Coarsening
+    while (levels.last().count()>COARSEST_SIZE)
+    {
+        Level coarse;
+        if (!coarsen(&levels.last(),&coarse))
+            break;
+        levels.append(coarse);
+    }
+
+    // Coarsest level: nodes spread in a square (fixed seed, so the result is deterministic).
+    // Each level uses his own natural length (coarse nodes represent more nodes, so they are farther)
+    LayoutRandom rg(0x51F1D00DULL);
+    const Level & coarsest = levels.last();
+    double coarsestK = k*std::sqrt(((double)n)/coarsest.count());
+    double side = coarsestK*std::sqrt((double)coarsest.count());
+    QVector<double> x(coarsest.count()), y(coarsest.count());
+    for (int i=0; i<coarsest.count(); i++)
+    {
+        x[i] = rg.nextDouble()*side;
+        y[i] = rg.nextDouble()*side;
+    }
+    refine(coarsest,x,y,coarsestK,100,side);
+
+    // Interpolate and refine every finer level
+    for (int l=levels.count()-2; l>=0; l--)
+    {
+        const Level & level = levels[l];
+        double levelK = k*std::sqrt(((double)n)/level.count());
+        QVector<double> fineX(level.count()), fineY(level.count());
+        for (int i=0; i<level.count(); i++)
+        {
+            fineX[i] = x[level.parent[i]] + (rg.nextDouble()-0.5)*levelK*0.5;
+            fineY[i] = y[level.parent[i]] + (rg.nextDouble()-0.5)*levelK*0.5;
+        }
+        x.swap(fineX);
+        y.swap(fineY);
+
+        int iterations = level.count()<1000? 50 : (level.count()<10000? 30 : (level.count()<50000? 15 : 10));
+        refine(level,x,y,levelK,iterations,levelK*2);
+    }
+
+    graph->fitCenters(x,y);
+
+    return 0;
+}
+
+bool MultilevelLayout::coarsen(Level *fine, Level *coarse)
+{
+    int n = fine->count();
+    fine->parent.fill(-1,n);
+
+    // Visit the nodes with fewer links first, so the leaves are matched before the hubs
+    QVector<int> order(n);
+    for (int i=0; i<n; i++)
+        order[i] = i;
+    std::stable_sort(order.begin(),order.end(), [fine](int a, int b) -> bool {
+        return (fine->offsets[a+1]-fine->offsets[a]) < (fine->offsets[b+1]-fine->offsets[b]);
+    });
+
+    // Heavy edge matching
+    int coarseCount = 0;
+    for (int node : order)
+    {
+        if (fine->parent[node]!=-1)
+            continue;
+
+        int best = -1;
+        double bestWeight = 0;
+        for (int e=fine->offsets[node]; e<fine->offsets[node+1]; e++)
+        {
+            int peer = fine->adjacency[e];
+            // Prefer heavy edges between light nodes
+            double w = fine->weights[e] / (fine->mass[node]+fine->mass[peer]);
+            if (peer!=node && fine->parent[peer]==-1 && w>bestWeight)
+            {
+                best = peer;
+                bestWeight = w;
+            }
+        }
+
+        if (best>=0)
+        {
+            fine->parent[node] = coarseCount;
+            fine->parent[best] = coarseCount;
+            coarseCount++;
+        }
+    }
+
+    // Unmatched nodes join a matched neighbour (collapses stars), isolated nodes stay alone
+    for (int node : order)
+    {
+        if (fine->parent[node]!=-1)
+            continue;
+
+        for (int e=fine->offsets[node]; e<fine->offsets[node+1]; e++)
+        {
+            int peer = fine->adjacency[e];
+            if (fine->parent[peer]!=-1)
+            {
+                fine->parent[node] = fine->parent[peer];
+                break;
+            }
+        }
+        if (fine->parent[node]==-1)
+            fine->parent[node] = coarseCount++;
+    }
+
+    // Not enough reduction
+    if (coarseCount > (n*9)/10)
+        return false;
+
+    // Coarse masses
+    coarse->mass.fill(0,coarseCount);
+    QVector<QVector<int>> members(coarseCount);
+    for (int i=0; i<n; i++)
+    {
+        coarse->mass[fine->parent[i]] += fine->mass[i];
+        members[fine->parent[i]].append(i);
+    }
+
+    // Coarse edges (merged, with the weights summed)
+    QVector<int> slot(coarseCount,-1);
+    coarse->offsets.resize(coarseCount+1);
+    for (int c=0; c<coarseCount; c++)
+    {
+        coarse->offsets[c] = coarse->adjacency.count();
+        for (int node : members[c])
+        {
+            for (int e=fine->offsets[node]; e<fine->offsets[node+1]; e++)
+            {
+                int peer = fine->parent[fine->adjacency[e]];
+                if (peer==c)
+                    continue;
+                if (slot[peer]<coarse->offsets[c])
+                {
+                    slot[peer] = coarse->adjacency.count();
+                    coarse->adjacency.append(peer);
+                    coarse->weights.append(fine->weights[e]);
+                }
+                else
+                    coarse->weights[slot[peer]] += fine->weights[e];
+            }
+        }
+    }
+    coarse->offsets[coarseCount] = coarse->adjacency.count();
+
+    return true;
+}
+
+void MultilevelLayout::refine(const Level &level, QVector<double> &x, QVector<double> &y, double k, int iterations, double temperature)
+{
+    int n = level.count();
+    if (n<2)
+        return;
+
+    QVector<double> dispX(n), dispY(n);
+    QVector<int> cellOf(n), cellStart, cellNodes(n);
+    double k2 = k*k;
+
+    for (int iteration=0; iteration<iterations; iteration++)
+    {
+        // Bucket the nodes into a grid (repulsion is only computed between near nodes)
+        double minX = x[0], maxX = x[0], minY = y[0], maxY = y[0];
+        for (int i=1; i<n; i++)
+        {
+            minX = std::min(minX,x[i]);
+            maxX = std::max(maxX,x[i]);
+            minY = std::min(minY,y[i]);
+            maxY = std::max(maxY,y[i]);
+        }
+
+        double cellSize = 2*k;
+        // Keep the grid about the size of the node count
+        cellSize = std::max(cellSize, std::sqrt(((maxX-minX+1)*(maxY-minY+1))/(4.0*n)));
+        int gridWidth = (int)((maxX-minX)/cellSize)+1;
+        int gridHeight = (int)((maxY-minY)/cellSize)+1;
+
+        cellStart.fill(0,gridWidth*gridHeight+1);
+        for (int i=0; i<n; i++)
+        {
+            int cx = (int)((x[i]-minX)/cellSize);
+            int cy = (int)((y[i]-minY)/cellSize);
+            cellOf[i] = cy*gridWidth+cx;
+            cellStart[cellOf[i]+1]++;
+        }
+        for (int c=1; c<cellStart.count(); c++)
+            cellStart[c] += cellStart[c-1];
+        {
+            QVector<int> fillPos = cellStart;
+            for (int i=0; i<n; i++)
+                cellNodes[fillPos[cellOf[i]]++] = i;
+        }
+
+        // Forces (each task writes only the displacement of his own nodes)
+        const double * px = x.constData();
+        const double * py = y.constData();
+        double * pdx = dispX.data();
+        double * pdy = dispY.data();
+        const int * pcellStart = cellStart.constData();
+        const int * pcellNodes = cellNodes.constData();
+        const int * pcellOf = cellOf.constData();
+        const int * offsets = level.offsets.constData();
+        const int * adjacency = level.adjacency.constData();
+        const double * weights = level.weights.constData();
+
+        Parallel::forEach( (n+REFINE_CHUNK-1)/REFINE_CHUNK, [=](int chunk) {
+            int end = std::min(n,(chunk+1)*REFINE_CHUNK);
+            for (int i=chunk*REFINE_CHUNK; i<end; i++)
+            {
+                double fx = 0, fy = 0;
+                int cx = pcellOf[i]%gridWidth;
+                int cy = pcellOf[i]/gridWidth;
+
+                // Repulsion from the nodes of the neighbour cells
+                for (int ny=std::max(0,cy-1); ny<=std::min(gridHeight-1,cy+1); ny++)
+                {
+                    for (int nx=std::max(0,cx-1); nx<=std::min(gridWidth-1,cx+1); nx++)
+                    {
+                        int cell = ny*gridWidth+nx;
+                        for (int p=pcellStart[cell]; p<pcellStart[cell+1]; p++)
+                        {
+                            int j = pcellNodes[p];
+                            if (j==i)
+                                continue;
+                            double dx = px[i]-px[j];
+                            double dy = py[i]-py[j];
+                            double d2 = dx*dx+dy*dy;
+                            if (d2<1e-4)
+                            {
+                                // Coincident nodes, push apart in a fixed direction
+                                dx = (i<j)? 0.01 : -0.01;
+                                dy = 0;
+                                d2 = 1e-4;
+                            }
+                            double f = k2/d2;
+                            fx += dx*f;
+                            fy += dy*f;
+                        }
+                    }
+                }
+
+                // Attraction from the links
+                for (int e=offsets[i]; e<offsets[i+1]; e++)
+                {
+                    int j = adjacency[e];
+                    double dx = px[i]-px[j];
+                    double dy = py[i]-py[j];
+                    double d = std::sqrt(dx*dx+dy*dy);
+                    double f = weights[e]*d/k;
+                    fx -= dx*f;
+                    fy -= dy*f;
+                }
+
+                pdx[i] = fx;
+                pdy[i] = fy;
+            }
+        });
+
+        // Move limited by the temperature
+        for (int i=0; i<n; i++)
+        {
+            double d = std::sqrt(dispX[i]*dispX[i]+dispY[i]*dispY[i]);
+            if (d>temperature)
+            {
+                dispX[i] *= temperature/d;
+                dispY[i] *= temperature/d;
+            }
+            x[i] += dispX[i];
+            y[i] += dispY[i];
+        }
+
+        temperature *= 0.92;
+    }
+}
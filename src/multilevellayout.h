@@ -0,0 +1,65 @@
+#ifndef MULTILEVELLAYOUT_H
+#define MULTILEVELLAYOUT_H
+
+#include <QVector>
+
+namespace QNodeGraph
+{
+
+class LayoutGraph;
+
+/**
+ * @brief The MultilevelLayout class Force directed layout over a hierarchy of coarsened graphs (FM3/sfdp style)
+ *
+ * The graph is coarsened by matching neighbours until it is small, the coarsest graph is laid out,
+ * and then every level is interpolated from the coarser one and refined with a grid accelerated
+ * Fruchterman-Reingold pass. The result is deterministic.
+ */
+class MultilevelLayout
+{
+public:
+    MultilevelLayout();
+
+    /**
+     * @brief layout Compute the positions of the layout graph (fitted into the graph area)
+     * @param graph layout graph
+     * @return 0 if succeed
+     */
+    static int layout(LayoutGraph * graph);
+
+private:
+    struct Level
+    {
+        // Compact weighted adjacency array
+        QVector<int> offsets, adjacency;
+        QVector<double> weights;
+        // Nodes represented by each node of this level
+        QVector<double> mass;
+        // Node of the coarser level where each node was merged
+        QVector<int> parent;
+
+        int count() const { return mass.count(); }
+    };
+
+    /**
+     * @brief coarsen Merge the nodes of a level (heavy edge matching, unmatched nodes join a matched neighbour)
+     * @param fine level to coarsen (his parent vector will be filled)
+     * @param coarse output coarser level
+     * @return false if the level can not be reduced anymore
+     */
+    static bool coarsen(Level * fine, Level * coarse);
+    /**
+     * @brief refine Fruchterman-Reingold refinement with grid accelerated repulsion
+     * @param level level graph
+     * @param x x coordinates
+     * @param y y coordinates
+     * @param k ideal edge length
+     * @param iterations iterations
+     * @param temperature initial maximum displacement
+     */
+    static void refine(const Level & level, QVector<double> & x, QVector<double> & y, double k, int iterations, double temperature);
+};
+
+}
+
+#endif // MULTILEVELLAYOUT_H
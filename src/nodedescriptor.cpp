@@ -0,0 +1,240 @@
+#include "nodedescriptor.h"
+#include "xmlfunctions.h"
+
+using namespace QNodeGraph;
+
+NodeDescriptor::NodeDescriptor()
+{
+    properties = 0;
+    fillMode = 0;
+    borderRoundRectPixels = 0;
+    anchored = false;
+    zoomOutLevel = 0;
+    textPosition = 0;
+    shape = 0;
+    belongsToLayerZero = false;
+    textAlignFlags = 0;
+    subTextAlignFlags = 0;
+    width = 0;
+    height = 0;
+    group = false;
+    parent = -1;
+}
+
+bool NodeDescriptor::readProperties(QXmlStreamReader &xml, NodeDescriptor *node)
+{
+    while (xml.readNextStartElement())
+    {
+        auto name = xml.name();
+
+        if (name == QLatin1String("id"))
+        {
+            node->id = XMLFunctions::fromBase64(xml.readElementText());
+            node->properties |= PROP_ID;
+        }
+        else if (name == QLatin1String("pos"))
+        {
+            node->pos = QPoint(xml.attributes().value("x").toInt(), xml.attributes().value("y").toInt());
+            node->properties |= PROP_POS;
+            xml.skipCurrentElement();
+        }
+        else if (name == QLatin1String("text"))
+        {
+            node->text = XMLFunctions::fromBase64(xml.readElementText());
+            node->properties |= PROP_TEXT;
+        }
+        else if (name == QLatin1String("subText"))
+        {
+            node->subText = XMLFunctions::fromBase64(xml.readElementText());
+            node->properties |= PROP_SUBTEXT;
+        }
+        else if (name == QLatin1String("description"))
+        {
+            node->description = EncodedText::fromBase64(xml.readElementText().toLatin1());
+            node->properties |= PROP_DESCRIPTION;
+        }
+        else if (name == QLatin1String("textFont"))
+        {
+            node->textFont = XMLFunctions::fromBase64(xml.readElementText());
+            node->properties |= PROP_TEXTFONT;
+        }
+        else if (name == QLatin1String("subTextFont"))
+        {
+            node->subTextFont = XMLFunctions::fromBase64(xml.readElementText());
+            node->properties |= PROP_SUBTEXTFONT;
+        }
+        else if (name == QLatin1String("borderColor"))
+        {
+            node->borderColor = XMLFunctions::colorFromXML(xml.attributes());
+            node->properties |= PROP_BORDERCOLOR;
+            xml.skipCurrentElement();
+        }
+        else if (name == QLatin1String("selectedBorderColor"))
+        {
+            node->selectedBorderColor = XMLFunctions::colorFromXML(xml.attributes());
+            node->properties |= PROP_SELECTEDBORDERCOLOR;
+            xml.skipCurrentElement();
+        }
+        else if (name == QLatin1String("textColor"))
+        {
+            node->textColor = XMLFunctions::colorFromXML(xml.attributes());
+            node->properties |= PROP_TEXTCOLOR;
+            xml.skipCurrentElement();
+        }
+        else if (name == QLatin1String("subTextColor"))
+        {
+            node->subTextColor = XMLFunctions::colorFromXML(xml.attributes());
+            node->properties |= PROP_SUBTEXTCOLOR;
+            xml.skipCurrentElement();
+        }
+        else if (name == QLatin1String("fillColor"))
+        {
+            node->fillColor = XMLFunctions::colorFromXML(xml.attributes());
+            node->properties |= PROP_FILLCOLOR;
+            xml.skipCurrentElement();
+        }
+        else if (name == QLatin1String("fillColor2"))
+        {
+            node->fillColor2 = XMLFunctions::colorFromXML(xml.attributes());
+            node->properties |= PROP_FILLCOLOR2;
+            xml.skipCurrentElement();
+        }
+        else if (name == QLatin1String("fillMode"))
+        {
+            node->fillMode = xml.readElementText().toInt();
+            node->properties |= PROP_FILLMODE;
+        }
+        else if (name == QLatin1String("borderRoundRectPixels"))
+        {
+            node->borderRoundRectPixels = xml.readElementText().toInt();
+            node->properties |= PROP_BORDERROUNDRECTPIXELS;
+        }
+        else if (name == QLatin1String("anchored"))
+        {
+            node->anchored = xml.readElementText().toUInt()==1;
+            node->properties |= PROP_ANCHORED;
+        }
+        else if (name == QLatin1String("tags"))
+        {
+            node->tags.clear();
+            while (xml.readNextStartElement())
+            {
+                if (xml.name() == QLatin1String("tag"))
+                    node->tags.append(XMLFunctions::fromBase64(xml.readElementText()));
+                else
+                    xml.skipCurrentElement();
+            }
+            node->properties |= PROP_TAGS;
+        }
+        else if (name == QLatin1String("zoomOutLevel"))
+        {
+            node->zoomOutLevel = xml.readElementText().toInt();
+            node->properties |= PROP_ZOOMOUTLEVEL;
+        }
+        else if (name == QLatin1String("icon"))
+        {
+            node->iconSize = QSize(xml.attributes().value("x").toInt(), xml.attributes().value("y").toInt());
+            node->iconKey = xml.attributes().value("key").toString();
+            // Inline icon (documents without icon table)
+            if (node->iconKey.isEmpty())
+                node->icon.loadFromData(QByteArray::fromBase64(xml.readElementText().toLatin1()));
+            else
+                xml.skipCurrentElement();
+            node->properties |= PROP_ICON;
+        }
+        else if (name == QLatin1String("textPosition"))
+        {
+            node->textPosition = xml.readElementText().toInt();
+            node->properties |= PROP_TEXTPOSITION;
+        }
+        else if (name == QLatin1String("shape"))
+        {
+            node->shape = xml.readElementText().toInt();
+            node->properties |= PROP_SHAPE;
+        }
+        else if (name == QLatin1String("belongsToLayerZero"))
+        {
+            node->belongsToLayerZero = xml.readElementText().toUInt()==1;
+            node->properties |= PROP_BELONGSTOLAYERZERO;
+        }
+        else if (name == QLatin1String("textAlignFlags"))
+        {
+            node->textAlignFlags = xml.readElementText().toInt();
+            node->properties |= PROP_TEXTALIGNFLAGS;
+        }
+        else if (name == QLatin1String("subTextAlignFlags"))
+        {
+            node->subTextAlignFlags = xml.readElementText().toInt();
+            node->properties |= PROP_SUBTEXTALIGNFLAGS;
+        }
+        else if (name == QLatin1String("titleBackgroundColor"))
+        {
+            node->titleBackgroundColor = XMLFunctions::colorFromXML(xml.attributes());
+            node->properties |= PROP_TITLEBACKGROUNDCOLOR;
+            xml.skipCurrentElement();
+        }
+        else if (name == QLatin1String("width"))
+        {
+            node->width = xml.readElementText().toInt();
+            node->properties |= PROP_WIDTH;
+        }
+        else if (name == QLatin1String("height"))
+        {
+            node->height = xml.readElementText().toInt();
+            node->properties |= PROP_HEIGHT;
+        }
+        else
+            xml.skipCurrentElement();
+    }
+
+    return !xml.hasError();
+}
+
+bool NodeDescriptor::has(Property property) const
+{
+    return (properties & property)!=0;
+}
+
+bool NodeDescriptor::differs(const NodeDescriptor &current) const
+{
+    if ((has(PROP_ID) && id!=current.id) ||
+        (has(PROP_POS) && pos!=current.pos) ||
+        (has(PROP_TEXT) && text!=current.text) ||
+        (has(PROP_SUBTEXT) && subText!=current.subText) ||
+        (has(PROP_DESCRIPTION) && !description.equals(current.description)) ||
+        (has(PROP_TEXTFONT) && textFont!=current.textFont) ||
+        (has(PROP_SUBTEXTFONT) && subTextFont!=current.subTextFont) ||
+        (has(PROP_BORDERCOLOR) && borderColor!=current.borderColor) ||
+        (has(PROP_SELECTEDBORDERCOLOR) && selectedBorderColor!=current.selectedBorderColor) ||
+        (has(PROP_TEXTCOLOR) && textColor!=current.textColor) ||
+        (has(PROP_SUBTEXTCOLOR) && subTextColor!=current.subTextColor) ||
+        (has(PROP_FILLCOLOR) && fillColor!=current.fillColor) ||
+        (has(PROP_FILLCOLOR2) && fillColor2!=current.fillColor2) ||
+        (has(PROP_FILLMODE) && fillMode!=current.fillMode) ||
+        (has(PROP_BORDERROUNDRECTPIXELS) && borderRoundRectPixels!=current.borderRoundRectPixels) ||
+        (has(PROP_ANCHORED) && anchored!=current.anchored) ||
+        (has(PROP_ZOOMOUTLEVEL) && zoomOutLevel!=current.zoomOutLevel) ||
+        (has(PROP_TEXTPOSITION) && textPosition!=current.textPosition) ||
+        (has(PROP_SHAPE) && shape!=current.shape) ||
+        (has(PROP_BELONGSTOLAYERZERO) && belongsToLayerZero!=current.belongsToLayerZero) ||
+        (has(PROP_TEXTALIGNFLAGS) && textAlignFlags!=current.textAlignFlags) ||
+        (has(PROP_SUBTEXTALIGNFLAGS) && subTextAlignFlags!=current.subTextAlignFlags) ||
+        (has(PROP_TITLEBACKGROUNDCOLOR) && titleBackgroundColor!=current.titleBackgroundColor) ||
+        (has(PROP_WIDTH) && width!=current.width) ||
+        (has(PROP_HEIGHT) && height!=current.height) ||
+        (has(PROP_DATA) && !embeddedData.equals(current.embeddedData)))
+        return true;
+
+    if (has(PROP_TAGS))
+    {
+        // The node keeps the tags as a set
+        QStringList a = tags, b = current.tags;
+        a.removeDuplicates();
+        b.removeDuplicates();
+        a.sort();
+        b.sort();
+        if (a!=b)
+            return true;
+    }
+    return false;
+}
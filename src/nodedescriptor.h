@@ -0,0 +1,118 @@
+#ifndef NODEDESCRIPTOR_H
+#define NODEDESCRIPTOR_H
+
+#include <QString>
+#include <QStringList>
+#include <QPoint>
+#include <QSize>
+#include <QColor>
+#include <QImage>
+#include <QXmlStreamReader>
+
+#include "encodedtext.h"
+
+namespace QNodeGraph
+{
+
+/**
+ * @brief The NodeDescriptor class Properties of an item or group read from a document, without any widget
+ *
+ * Only the properties found in the document are applied to the node (see has()), the others keep the
+ * graph defaults.
+ */
+class NodeDescriptor
+{
+public:
+    NodeDescriptor();
+
+    enum Property {
+        // Items and groups
+        PROP_ID=1<<0,
+        PROP_POS=1<<1,
+        PROP_TEXT=1<<2,
+        PROP_SUBTEXT=1<<3,
+        PROP_DESCRIPTION=1<<4,
+        PROP_TEXTFONT=1<<5,
+        PROP_SUBTEXTFONT=1<<6,
+        PROP_BORDERCOLOR=1<<7,
+        PROP_SELECTEDBORDERCOLOR=1<<8,
+        PROP_TEXTCOLOR=1<<9,
+        PROP_SUBTEXTCOLOR=1<<10,
+        PROP_FILLCOLOR=1<<11,
+        PROP_FILLCOLOR2=1<<12,
+        PROP_FILLMODE=1<<13,
+        PROP_BORDERROUNDRECTPIXELS=1<<14,
+        PROP_ANCHORED=1<<15,
+        // Items
+        PROP_TAGS=1<<16,
+        PROP_ZOOMOUTLEVEL=1<<17,
+        PROP_ICON=1<<18,
+        PROP_TEXTPOSITION=1<<19,
+        PROP_SHAPE=1<<20,
+        PROP_BELONGSTOLAYERZERO=1<<21,
+        // Groups
+        PROP_TEXTALIGNFLAGS=1<<22,
+        PROP_SUBTEXTALIGNFLAGS=1<<23,
+        PROP_TITLEBACKGROUNDCOLOR=1<<24,
+        PROP_WIDTH=1<<25,
+        PROP_HEIGHT=1<<26,
+        // Embedded data (<data> element, outside the properties)
+        PROP_DATA=1<<27
+    };
+
+    /**
+     * @brief readProperties Read a <properties> element
+     * @param xml XML reader positioned at the <properties> start element (it is left after the end element)
+     * @param node output descriptor
+     * @return true if succeed
+     */
+    static bool readProperties(QXmlStreamReader & xml, NodeDescriptor * node);
+
+    /**
+     * @brief has Check if a property was found in the document
+     * @param property property
+     * @return true if found
+     */
+    bool has(Property property) const;
+    /**
+     * @brief differs Check if a property found in the document differs from a node (the icon is not compared)
+     * @param current current node properties (see AbstractNodeWidget::getNodeDescriptor)
+     * @return true if some property differs
+     */
+    bool differs(const NodeDescriptor & current) const;
+
+    quint32 properties;
+
+    QString id, text, subText;
+    // Payloads kept encoded until used
+    EncodedText description;
+    QPoint pos;
+    // Fonts are kept as QFont::toString() descriptions
+    QString textFont, subTextFont;
+    QColor borderColor, selectedBorderColor, textColor, subTextColor, fillColor, fillColor2;
+    int fillMode, borderRoundRectPixels;
+    bool anchored;
+
+    QStringList tags;
+    int zoomOutLevel;
+    // Decoded icon (QImage can be decoded out of the GUI thread), or key of the document icon table
+    QImage icon;
+    QString iconKey;
+    QSize iconSize;
+    int textPosition, shape;
+    bool belongsToLayerZero;
+
+    int textAlignFlags, subTextAlignFlags;
+    QColor titleBackgroundColor;
+    int width, height;
+
+    EncodedText embeddedData;
+
+    // Position in the document (see GraphLoader): group or item, and index of the group containing the item (-1 for the graph)
+    bool group;
+    int parent;
+};
+
+}
+
+#endif // NODEDESCRIPTOR_H
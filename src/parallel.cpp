@@ -0,0 +1,82 @@
+#include "parallel.h"
+
+#include <QThreadPool>
+#include <QRunnable>
+#include <QSemaphore>
+#include <QAtomicInt>
+
+using namespace QNodeGraph;
+
+namespace
+{
+
+struct ParallelJob
+{
+    const std::function<void (int)> * function;
+    QAtomicInt next;
+    int count;
+
+    void work()
+    {
+        int i;
+        while ((i = next.fetchAndAddRelaxed(1)) < count)
+            (*function)(i);
+    }
+};
+
+class ParallelRunnable : public QRunnable
+{
+public:
+    ParallelRunnable(ParallelJob * job, QSemaphore * done)
+    {
+        this->job = job;
+        this->done = done;
+        setAutoDelete(true);
+    }
+
+    void run() override
+    {
+        job->work();
+        done->release();
+    }
+
+private:
+    ParallelJob * job;
+    QSemaphore * done;
+};
+
+}
+
+Parallel::Parallel()
+{
+}
+
+void Parallel::forEach(int count, const std::function<void (int)> &function)
+{
+    if (count<=0)
+        return;
+
+    ParallelJob job;
+    job.function = &function;
+    job.next = 0;
+    job.count = count;
+
+    QSemaphore done;
+    int started = 0;
+
+    // Only use the threads that are available now, the calling thread does the rest of the work
+    QThreadPool * pool = QThreadPool::globalInstance();
+    for (int i=1; i<count && i<pool->maxThreadCount(); i++)
+    {
+        ParallelRunnable * runnable = new ParallelRunnable(&job,&done);
+        if (!pool->tryStart(runnable))
+        {
+            delete runnable;
+            break;
+        }
+        started++;
+    }
+
+    job.work();
+    done.acquire(started);
+}
@@ -0,0 +1,24 @@
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include <functional>
+
+namespace QNodeGraph
+{
+class Parallel
+{
+public:
+    Parallel();
+
+    /**
+     * @brief forEach Execute function(0)...function(count-1) using the global thread pool and wait for them.
+     *                The calling thread also executes tasks, so it is safe to nest calls or use it when the pool is busy.
+     * @param count number of tasks
+     * @param function task function (receives the task number, must not touch widgets)
+     */
+    static void forEach(int count, const std::function<void (int)> & function);
+};
+
+}
+
+#endif // PARALLEL_H
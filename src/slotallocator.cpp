@@ -0,0 +1,86 @@
+#include "slotallocator.h"
+
+using namespace QNodeGraph;
+
+SlotAllocator::SlotAllocator(int count)
+{
+    this->slotCount = count<0? 0 : count;
+    this->freeSlots = this->slotCount;
+
+    right.resize(this->slotCount+1);
+    left.resize(this->slotCount+1);
+
+    for (int i=0; i<=this->slotCount; i++)
+    {
+        right[i] = i;
+        left[i] = i;
+    }
+}
+
+int SlotAllocator::allocate(int preferred)
+{
+    if (!freeSlots)
+        return -1;
+
+    // adjust into his borders
+    if (preferred>=slotCount)
+        preferred = slotCount-1;
+    if (preferred<0)
+        preferred = 0;
+
+    int r = findRight(preferred);
+    int l = findLeft(preferred);
+
+    int slot;
+    if (r==slotCount)
+        slot = l;
+    else if (l<0)
+        slot = r;
+    else
+        slot = (preferred-l)<=(r-preferred) ? l : r;
+
+    // Mark as taken: link to the neighbours
+    right[slot] = slot+1;
+    left[slot+1] = slot;
+    freeSlots--;
+
+    return slot;
+}
+
+int SlotAllocator::getFreeSlots() const
+{
+    return freeSlots;
+}
+
+int SlotAllocator::findRight(int slot)
+{
+    int root = slot;
+    while (right[root]!=root)
+        root = right[root];
+
+    // Path compression
+    while (right[slot]!=root)
+    {
+        int next = right[slot];
+        right[slot] = root;
+        slot = next;
+    }
+    return root;
+}
+
+int SlotAllocator::findLeft(int slot)
+{
+    int pos = slot+1;
+    int root = pos;
+    while (left[root]!=root)
+        root = left[root];
+
+    // Path compression
+    while (left[pos]!=root)
+    {
+        int next = left[pos];
+        left[pos] = root;
+        pos = next;
+    }
+    return root-1;
+}
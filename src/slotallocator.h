@@ -0,0 +1,60 @@
+#ifndef SLOTALLOCATOR_H
+#define SLOTALLOCATOR_H
+
+#include <QVector>
+
+namespace QNodeGraph
+{
+
+/**
+ * @brief The SlotAllocator class Nearest free slot allocation over a fixed line of slots
+ *
+ * Two union-find "next free" structures (one looking to the right, one to the left) are used,
+ * so every allocation is amortized O(α(n)) instead of probing slot by slot.
+ */
+class SlotAllocator
+{
+public:
+    /**
+     * @brief SlotAllocator Constructor
+     * @param count number of slots (all of them free)
+     */
+    SlotAllocator(int count);
+
+    /**
+     * @brief allocate Take the nearest free slot to the preferred one (on ties, the lower slot)
+     * @param preferred preferred slot (will be adjusted into the borders)
+     * @return allocated slot, or -1 if every slot is already taken
+     */
+    int allocate(int preferred);
+    /**
+     * @brief getFreeSlots Get how many slots are still free
+     * @return free slots count
+     */
+    int getFreeSlots() const;
+
+private:
+    /**
+     * @brief findRight Get the first free slot at or after the slot
+     * @param slot slot
+     * @return free slot or the slots count if there is not free slots to the right
+     */
+    int findRight(int slot);
+    /**
+     * @brief findLeft Get the first free slot at or before the slot
+     * @param slot slot
+     * @return free slot or -1 if there is not free slots to the left
+     */
+    int findLeft(int slot);
+
+    // right[i]: next candidate >= i (index slotCount is the sentinel)
+    QVector<int> right;
+    // left[i+1]: next candidate <= i (index 0 is the sentinel)
+    QVector<int> left;
+
+    int slotCount, freeSlots;
+};
+
+}
+
+#endif // SLOTALLOCATOR_H
@@ -0,0 +1,112 @@
+#include "sortkeys.h"
+
+#include <algorithm>
+#include <cstring>
+
+using namespace QNodeGraph;
+
+// Buckets smaller than this are sorted by comparison
+#define RADIX_CUTOFF 32
+// Marks a number in natural keys (sorts where the digits sort)
+#define NUMBER_MARK '0'
+
+SortKeys::SortKeys()
+{
+}
+
+QByteArray SortKeys::makeKey(const QString &text, bool natural)
+{
+    QString folded = text.normalized(QString::NormalizationForm_KD).toCaseFolded();
+
+    QByteArray key;
+    key.reserve(folded.size()+8);
+
+    QString segment;
+    for (int i=0; i<folded.size(); i++)
+    {
+        QChar c = folded.at(i);
+
+        // Accents (combining marks) are ignored
+        if (c.isMark())
+            continue;
+
+        if (natural && c>=QLatin1Char('0') && c<=QLatin1Char('9'))
+        {
+            key.append(segment.toUtf8());
+            segment.clear();
+
+            // Digits without the leading zeros, prefixed by their count: shorter numbers are smaller
+            int start = i, end = i;
+            while (end<folded.size() && folded.at(end)>=QLatin1Char('0') && folded.at(end)<=QLatin1Char('9'))
+                end++;
+            while (start<end-1 && folded.at(start)==QLatin1Char('0'))
+                start++;
+
+            key.append(NUMBER_MARK);
+            key.append((char)std::min(end-start,255));
+            for (int d=start; d<end; d++)
+                key.append((char)folded.at(d).unicode());
+
+            i = end-1;
+            continue;
+        }
+
+        segment.append(c);
+    }
+    key.append(segment.toUtf8());
+
+    return key;
+}
+
+QVector<int> SortKeys::sortedOrder(const QVector<QByteArray> &keys)
+{
+    int n = keys.count();
+    QVector<int> order(n), buffer(n);
+    for (int i=0; i<n; i++)
+        order[i] = i;
+
+    radixSort(keys,order.data(),buffer.data(),n,0);
+    return order;
+}
+
+void SortKeys::radixSort(const QVector<QByteArray> &keys, int *order, int *buffer, int count, int depth)
+{
+    if (count<RADIX_CUTOFF)
+    {
+        std::stable_sort(order,order+count, [&keys,depth](int a, int b) -> bool {
+            const QByteArray & ka = keys[a];
+            const QByteArray & kb = keys[b];
+            int la = ka.size()-depth, lb = kb.size()-depth;
+            int r = memcmp(ka.constData()+depth, kb.constData()+depth, std::min(la,lb));
+            return r<0 || (r==0 && la<lb);
+        });
+        return;
+    }
+
+    // Bucket 0 for the keys that end here, then one bucket per byte value (stable counting sort)
+    int offsets[258] = {0};
+    for (int i=0; i<count; i++)
+    {
+        const QByteArray & key = keys[order[i]];
+        offsets[ (key.size()>depth? (unsigned char)key.at(depth)+1 : 0) + 1 ]++;
+    }
+    for (int b=1; b<258; b++)
+        offsets[b] += offsets[b-1];
+
+    int next[257];
+    std::copy(offsets,offsets+257,next);
+    for (int i=0; i<count; i++)
+    {
+        const QByteArray & key = keys[order[i]];
+        buffer[ next[ key.size()>depth? (unsigned char)key.at(depth)+1 : 0 ]++ ] = order[i];
+    }
+    std::copy(buffer,buffer+count,order);
+
+    // The keys that ended are equal, the other buckets continue with the next byte
+    for (int b=1; b<257; b++)
+    {
+        int size = offsets[b+1]-offsets[b];
+        if (size>1)
+            radixSort(keys,order+offsets[b],buffer+offsets[b],size,depth+1);
+    }
+}
@@ -0,0 +1,56 @@
+#ifndef SORTKEYS_H
+#define SORTKEYS_H
+
+#include <QVector>
+#include <QByteArray>
+#include <QString>
+
+namespace QNodeGraph
+{
+
+/**
+ * @brief The SortKeys class Normalized byte sort keys and a stable radix sort over them
+ *
+ * Keys are extracted once per node (compatibility decomposition, case folded, without accents), so
+ * sorting compares plain bytes instead of copying and comparing strings on every comparison.
+ */
+class SortKeys
+{
+public:
+    SortKeys();
+
+    enum Field {
+        FIELD_ID=0,
+        FIELD_TEXT=1,
+        FIELD_SUBTEXT=2
+    };
+
+    /**
+     * @brief makeKey Make the sort key of a text
+     * @param text text
+     * @param natural compare the numbers by value ("host2" before "host10")
+     * @return byte key (compared byte by byte, shorter first on ties)
+     */
+    static QByteArray makeKey(const QString & text, bool natural);
+    /**
+     * @brief sortedOrder Sort the keys (stable MSD radix sort, equal keys keep their order)
+     * @param keys keys
+     * @return key indexes in sorted order
+     */
+    static QVector<int> sortedOrder(const QVector<QByteArray> & keys);
+
+private:
+    /**
+     * @brief radixSort Sort a bucket of key indexes
+     * @param keys keys
+     * @param order key indexes of the bucket (sorted in place)
+     * @param buffer working buffer (same size as the bucket)
+     * @param count bucket size
+     * @param depth bytes already sorted (equal for every key of the bucket)
+     */
+    static void radixSort(const QVector<QByteArray> & keys, int * order, int * buffer, int count, int depth);
+};
+
+}
+
+#endif // SORTKEYS_H
@@ -0,0 +1,125 @@
+#include "spatialindex.h"
+
+#include <algorithm>
+#include <climits>
+#include <cstdlib>
+
+using namespace QNodeGraph;
+
+SpatialIndex::SpatialIndex(int cellSize)
+{
+    this->cellSize = std::max(8,cellSize);
+    bottom = INT_MIN;
+}
+
+int SpatialIndex::cellSizeFor(const QVector<QSize> &sizes)
+{
+    if (sizes.isEmpty())
+        return 8;
+
+    qint64 sum = 0;
+    for (const QSize & s : sizes)
+        sum += std::max(s.width(),s.height());
+
+    return std::max<qint64>(8,sum/sizes.count());
+}
+
+void SpatialIndex::insert(const QRect &r)
+{
+    int id = rects.count();
+    rects.append(r);
+    bottom = std::max(bottom,r.bottom());
+
+    for (int cy=cellOf(r.top()); cy<=cellOf(r.bottom()); cy++)
+    {
+        for (int cx=cellOf(r.left()); cx<=cellOf(r.right()); cx++)
+            cells[cellKey(cx,cy)].append(id);
+    }
+}
+
+bool SpatialIndex::intersects(const QRect &r, int spacing) const
+{
+    QRect area = r.adjusted(-spacing,-spacing,spacing,spacing);
+
+    for (int cy=cellOf(area.top()); cy<=cellOf(area.bottom()); cy++)
+    {
+        for (int cx=cellOf(area.left()); cx<=cellOf(area.right()); cx++)
+        {
+            auto cell = cells.constFind(cellKey(cx,cy));
+            if (cell == cells.constEnd())
+                continue;
+
+            for (int id : *cell)
+            {
+                if (rects[id].intersects(area))
+                    return true;
+            }
+        }
+    }
+    return false;
+}
+
+QPoint SpatialIndex::findFreePosition(const QSize &size, const QPoint &preferred, const QRect &bounds, int spacing) const
+{
+    int step = std::max(4,std::min(size.width(),size.height())/2);
+    int minX = bounds.left();
+    int maxX = std::max(minX,bounds.right()+1-size.width());
+    int minY = bounds.top();
+    int maxY = std::max(minY,bounds.bottom()+1-size.height());
+
+    QPoint origin( std::min(std::max(preferred.x(),minX),maxX), std::min(std::max(preferred.y(),minY),maxY) );
+
+    // Rings needed to cover the whole bounds
+    int maxRing = (std::max(std::max(origin.x()-minX,maxX-origin.x()),std::max(origin.y()-minY,maxY-origin.y()))/step)+1;
+
+    QVector<QPoint> candidates;
+    for (int ring=0; ring<=maxRing; ring++)
+    {
+        candidates.clear();
+
+        // Ring perimeter (only the positions inside the bounds)
+        int minDx = std::max(-ring, -((origin.x()-minX)/step)-1);
+        int maxDx = std::min(ring, ((maxX-origin.x())/step)+1);
+        for (int dx=minDx; dx<=maxDx; dx++)
+        {
+            bool side = (dx==-ring || dx==ring);
+            for (int dy=-ring; dy<=ring; dy+= (side||ring==0)? 1 : 2*ring)
+            {
+                QPoint p( std::min(std::max(origin.x()+(dx*step),minX),maxX), origin.y()+(dy*step) );
+                if (p.y()<minY || p.y()>maxY)
+                    continue;
+                candidates.append(p);
+            }
+        }
+
+        // Nearest candidates first
+        std::stable_sort(candidates.begin(),candidates.end(), [&origin](const QPoint & a, const QPoint & b) -> bool {
+            return (a-origin).manhattanLength() < (b-origin).manhattanLength();
+        });
+
+        for (const QPoint & p : candidates)
+        {
+            if (!intersects(QRect(p,size),spacing))
+                return p;
+        }
+    }
+
+    // No space left in the bounds, everything below the lowest rectangle is free
+    return QPoint(origin.x(), std::max(maxY, bottom+spacing+1));
+}
+
+int SpatialIndex::getBottom() const
+{
+    return bottom;
+}
+
+qint64 SpatialIndex::cellKey(int cx, int cy)
+{
+    return (((qint64)cx)<<32) | ((quint32)cy);
+}
+
+int SpatialIndex::cellOf(int coordinate) const
+{
+    // floor division (coordinates can be negative)
+    return coordinate>=0 ? coordinate/cellSize : -((-coordinate+cellSize-1)/cellSize);
+}
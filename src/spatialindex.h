@@ -0,0 +1,75 @@
+#ifndef SPATIALINDEX_H
+#define SPATIALINDEX_H
+
+#include <QVector>
+#include <QHash>
+#include <QRect>
+#include <QSize>
+#include <QPoint>
+
+namespace QNodeGraph
+{
+
+/**
+ * @brief The SpatialIndex class Uniform grid of rectangles used to find overlaps and free space
+ *
+ * Each rectangle is registered in every cell it touches, so an overlap query only checks the
+ * rectangles near the queried area instead of every sibling.
+ */
+class SpatialIndex
+{
+public:
+    /**
+     * @brief SpatialIndex Constructor
+     * @param cellSize grid cell size in pixels (about the size of the nodes works well)
+     */
+    SpatialIndex(int cellSize);
+
+    /**
+     * @brief cellSizeFor Get a good cell size for a set of node sizes
+     * @param sizes node sizes
+     * @return cell size (at least 8px)
+     */
+    static int cellSizeFor(const QVector<QSize> & sizes);
+
+    /**
+     * @brief insert Register a rectangle
+     * @param r rectangle
+     */
+    void insert(const QRect & r);
+    /**
+     * @brief intersects Check if the rectangle intersects any registered rectangle
+     * @param r rectangle
+     * @param spacing required distance between the rectangles
+     * @return true if intersects
+     */
+    bool intersects(const QRect & r, int spacing = 0) const;
+    /**
+     * @brief findFreePosition Find the nearest free position for a rectangle (searching in rings around the preferred position)
+     * @param size rectangle size
+     * @param preferred preferred top left position
+     * @param bounds area where the rectangle should be placed, if there is no space the position will be below the area
+     * @param spacing required distance between the rectangles
+     * @return free top left position
+     */
+    QPoint findFreePosition(const QSize & size, const QPoint & preferred, const QRect & bounds, int spacing = 0) const;
+
+    /**
+     * @brief getBottom Get the bottom of the lowest registered rectangle
+     * @return bottom coordinate (or INT_MIN if empty)
+     */
+    int getBottom() const;
+
+private:
+    static qint64 cellKey(int cx, int cy);
+    int cellOf(int coordinate) const;
+
+    int cellSize;
+    int bottom;
+    QVector<QRect> rects;
+    QHash<qint64, QVector<int>> cells;
+};
+
+}
+
+#endif // SPATIALINDEX_H
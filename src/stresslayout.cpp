@@ -0,0 +1,421 @@
+#include "stresslayout.h"
+#include "layoutgraph.h"
+#include "layoutrandom.h"
+#include "parallel.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace QNodeGraph;
+
+// Biggest graph where all the distances are computed (n*n floats)
+#define STRESS_EXACT_LIMIT 3000
+// Pivots used by the initial placement and the sparse approximation
+#define STRESS_PIVOTS 100
+// Nodes computed by each parallel task
+#define STRESS_CHUNK 256
+// Iterations limit and relative stress improvement to stop
+#define STRESS_ITERATIONS 200
+#define STRESS_TOLERANCE 0.0001
+
+StressLayout::StressLayout()
+{
+}
+
+int StressLayout::layout(LayoutGraph *graph)
+{
+    int n = graph->count();
+    if (!n)
+        return 0;
+
+    QVector<int> pivots, pivotDistances, region;
+    selectPivots(*graph,std::min(n,STRESS_PIVOTS),&pivots,&pivotDistances,&region);
+
+    QVector<double> x(n), y(n);
+    pivotMds(pivots,pivotDistances,x,y);
+
+    if (n<=STRESS_EXACT_LIMIT)
+        exactStress(*graph,x,y);
+    else
+        sparseStress(*graph,pivots,pivotDistances,region,x,y);
+
+    graph->fitCenters(x,y);
+
+    return 0;
+}
+
+void StressLayout::selectPivots(const LayoutGraph &graph, int pivotCount, QVector<int> *pivots, QVector<int> *pivotDistances, QVector<int> *region)
+{
+    int n = graph.count();
+    pivots->resize(pivotCount);
+    pivotDistances->resize(pivotCount*n);
+    region->fill(0,n);
+
+    // Max-min pivots: the first one is the node with more links, then the farthest node from the selected pivots
+    QVector<int> queue, row(n), nearestDistance(n,-1);
+    int maxDistance = 0;
+    int pivot = graph.findComponents().roots.first();
+    for (int p=0; p<pivotCount; p++)
+    {
+        (*pivots)[p] = pivot;
+        distancesFrom(graph,pivot,row.data(),queue);
+
+        int farthest = 0;
+        qint64 farthestDistance = -1;
+        for (int i=0; i<n; i++)
+        {
+            // Node major, so the pivots of a node are contiguous
+            (*pivotDistances)[i*pivotCount+p] = row[i];
+            maxDistance = std::max(maxDistance,row[i]);
+            if (row[i]>=0 && (nearestDistance[i]<0 || row[i]<nearestDistance[i]))
+            {
+                nearestDistance[i] = row[i];
+                (*region)[i] = p;
+            }
+            // Nodes not reachable from any pivot are the farthest
+            qint64 d = nearestDistance[i]<0? n : nearestDistance[i];
+            if (d>farthestDistance)
+            {
+                farthest = i;
+                farthestDistance = d;
+            }
+        }
+        pivot = farthest;
+    }
+
+    // Unreachable nodes (other components) are kept a bit farther than the farthest reachable node
+    for (int & d : *pivotDistances)
+    {
+        if (d<0)
+            d = maxDistance+1;
+    }
+}
+
+void StressLayout::pivotMds(const QVector<int> &pivots, const QVector<int> &pivotDistances, QVector<double> &x, QVector<double> &y)
+{
+    int n = x.count();
+    int k = pivots.count();
+
+    // Double centered squared distances (n x k)
+    QVector<double> c(n*k), columnMeans(k,0);
+    double mean = 0;
+    for (int i=0; i<n; i++)
+    {
+        double rowMean = 0;
+        for (int p=0; p<k; p++)
+        {
+            double d = pivotDistances[i*k+p];
+            c[i*k+p] = d*d;
+            rowMean += d*d;
+            columnMeans[p] += d*d/n;
+        }
+        rowMean /= k;
+        for (int p=0; p<k; p++)
+            c[i*k+p] -= rowMean;
+        mean += rowMean/n;
+    }
+    for (int i=0; i<n; i++)
+    {
+        for (int p=0; p<k; p++)
+            c[i*k+p] = -0.5*(c[i*k+p]-columnMeans[p]+mean);
+    }
+
+    // C^T C (k x k)
+    QVector<double> b(k*k,0);
+    for (int i=0; i<n; i++)
+    {
+        const double * ci = c.constData()+i*k;
+        for (int p=0; p<k; p++)
+        {
+            for (int q=0; q<k; q++)
+                b[p*k+q] += ci[p]*ci[q];
+        }
+    }
+
+    // Two dominant eigenvectors by power iteration (fixed start vectors, so the result is deterministic)
+    LayoutRandom rg(0x57E55EEDULL);
+    QVector<double> vectors[2];
+    QVector<double> next(k);
+    for (int e=0; e<2; e++)
+    {
+        QVector<double> & v = vectors[e];
+        v.resize(k);
+        for (int p=0; p<k; p++)
+            v[p] = rg.nextDouble()-0.5;
+
+        for (int iteration=0; iteration<100; iteration++)
+        {
+            for (int p=0; p<k; p++)
+            {
+                next[p] = 0;
+                for (int q=0; q<k; q++)
+                    next[p] += b[p*k+q]*v[q];
+            }
+            // Keep the second one orthogonal to the first one
+            if (e==1)
+            {
+                double dot = 0;
+                for (int p=0; p<k; p++)
+                    dot += next[p]*vectors[0][p];
+                for (int p=0; p<k; p++)
+                    next[p] -= dot*vectors[0][p];
+            }
+            double norm = 0;
+            for (int p=0; p<k; p++)
+                norm += next[p]*next[p];
+            norm = std::sqrt(norm);
+            if (norm<1e-12)
+                break;
+            for (int p=0; p<k; p++)
+                v[p] = next[p]/norm;
+        }
+    }
+
+    // Project the nodes
+    for (int i=0; i<n; i++)
+    {
+        x[i] = 0;
+        y[i] = 0;
+        for (int p=0; p<k; p++)
+        {
+            x[i] += c[i*k+p]*vectors[0][p];
+            y[i] += c[i*k+p]*vectors[1][p];
+        }
+    }
+
+    // Scale to the graph distances (least squares over the distances to the pivots)
+    double sumDistance = 0, sumNorm = 0;
+    for (int i=0; i<n; i++)
+    {
+        for (int p=0; p<k; p++)
+        {
+            double dx = x[i]-x[pivots[p]];
+            double dy = y[i]-y[pivots[p]];
+            double norm = std::sqrt(dx*dx+dy*dy);
+            sumDistance += norm*pivotDistances[i*k+p];
+            sumNorm += norm*norm;
+        }
+    }
+
+    // Degenerated projection (e.g. no links): spread the nodes in a square
+    if (sumNorm<1e-9)
+    {
+        double side = std::sqrt((double)n);
+        for (int i=0; i<n; i++)
+        {
+            x[i] = rg.nextDouble()*side;
+            y[i] = rg.nextDouble()*side;
+        }
+        return;
+    }
+
+    // Small jitter, so the nodes projected into the same point can be separated
+    double scale = sumDistance/sumNorm;
+    for (int i=0; i<n; i++)
+    {
+        x[i] = x[i]*scale + (rg.nextDouble()-0.5)*0.01;
+        y[i] = y[i]*scale + (rg.nextDouble()-0.5)*0.01;
+    }
+}
+
+void StressLayout::exactStress(const LayoutGraph &graph, QVector<double> &x, QVector<double> &y)
+{
+    int n = graph.count();
+    int chunks = (n+STRESS_CHUNK-1)/STRESS_CHUNK;
+
+    // All pairs shortest paths, one BFS per node
+    QVector<float> distances(n*n);
+    QVector<int> maxDistances(chunks,0);
+    float * pdistances = distances.data();
+    int * pmaxDistances = maxDistances.data();
+    Parallel::forEach( chunks, [&](int chunk) {
+        QVector<int> queue, row(n);
+        int end = std::min(n,(chunk+1)*STRESS_CHUNK);
+        for (int i=chunk*STRESS_CHUNK; i<end; i++)
+        {
+            distancesFrom(graph,i,row.data(),queue);
+            float * out = pdistances+((qint64)i)*n;
+            for (int j=0; j<n; j++)
+            {
+                out[j] = row[j];
+                pmaxDistances[chunk] = std::max(pmaxDistances[chunk],row[j]);
+            }
+        }
+    });
+
+    // Unreachable nodes (other components) are kept a bit farther than the farthest reachable node
+    float unreachable = *std::max_element(maxDistances.constBegin(),maxDistances.constEnd())+1;
+    for (float & d : distances)
+    {
+        if (d<0)
+            d = unreachable;
+    }
+
+    QVector<double> nextX(n), nextY(n), stresses(chunks);
+    double lastStress = -1;
+    for (int iteration=0; iteration<STRESS_ITERATIONS; iteration++)
+    {
+        const double * px = x.constData();
+        const double * py = y.constData();
+        const float * prows = distances.constData();
+        double * pnx = nextX.data();
+        double * pny = nextY.data();
+        double * pstresses = stresses.data();
+
+        // Every node moves to the weighted mean of the positions proposed by the other nodes (weight 1/d^2)
+        Parallel::forEach( chunks, [=](int chunk) {
+            double stress = 0;
+            int end = std::min(n,(chunk+1)*STRESS_CHUNK);
+            for (int i=chunk*STRESS_CHUNK; i<end; i++)
+            {
+                const float * row = prows+((qint64)i)*n;
+                double xi = px[i], yi = py[i];
+                double sumW = 0, sumX = 0, sumY = 0;
+
+                // Branch free over structure of arrays, so the compiler can vectorize it (d is 0 for the node itself)
+                for (int j=0; j<n; j++)
+                {
+                    double dx = xi-px[j];
+                    double dy = yi-py[j];
+                    double norm = std::sqrt(dx*dx+dy*dy);
+                    double d = row[j];
+                    double w = d>0? 1.0/(d*d) : 0.0;
+                    double r = norm>1e-9? d/norm : 0.0;
+                    sumW += w;
+                    sumX += w*(px[j]+r*dx);
+                    sumY += w*(py[j]+r*dy);
+                    stress += w*(norm-d)*(norm-d);
+                }
+
+                pnx[i] = sumW>0? sumX/sumW : xi;
+                pny[i] = sumW>0? sumY/sumW : yi;
+            }
+            pstresses[chunk] = stress;
+        });
+
+        x.swap(nextX);
+        y.swap(nextY);
+
+        // The stress was measured over the previous positions, stop when it does not improve enough
+        double stress = 0;
+        for (double s : stresses)
+            stress += s;
+        if (lastStress>=0 && lastStress-stress < STRESS_TOLERANCE*lastStress)
+            break;
+        lastStress = stress;
+    }
+}
+
+void StressLayout::sparseStress(const LayoutGraph &graph, const QVector<int> &pivots, const QVector<int> &pivotDistances, const QVector<int> &region, QVector<double> &x, QVector<double> &y)
+{
+    int n = graph.count();
+    int pivotCount = pivots.count();
+    int chunks = (n+STRESS_CHUNK-1)/STRESS_CHUNK;
+
+    // Every pivot represents the nodes of his region
+    QVector<double> pivotWeights(pivotCount,0);
+    for (int i=0; i<n; i++)
+        pivotWeights[region[i]] += 1;
+
+    QVector<double> pivotX(pivotCount), pivotY(pivotCount);
+    QVector<double> nextX(n), nextY(n), stresses(chunks);
+    double lastStress = -1;
+    for (int iteration=0; iteration<STRESS_ITERATIONS; iteration++)
+    {
+        for (int p=0; p<pivotCount; p++)
+        {
+            pivotX[p] = x[pivots[p]];
+            pivotY[p] = y[pivots[p]];
+        }
+
+        const double * px = x.constData();
+        const double * py = y.constData();
+        const double * ppx = pivotX.constData();
+        const double * ppy = pivotY.constData();
+        const double * pweights = pivotWeights.constData();
+        const int * pdistances = pivotDistances.constData();
+        const int * offsets = graph.adjacencyOffsets.constData();
+        const int * adjacency = graph.adjacency.constData();
+        double * pnx = nextX.data();
+        double * pny = nextY.data();
+        double * pstresses = stresses.data();
+
+        Parallel::forEach( chunks, [=](int chunk) {
+            double stress = 0;
+            int end = std::min(n,(chunk+1)*STRESS_CHUNK);
+            for (int i=chunk*STRESS_CHUNK; i<end; i++)
+            {
+                double xi = px[i], yi = py[i];
+                double sumW = 0, sumX = 0, sumY = 0;
+
+                // Neighbours (distance 1, weight 1)
+                for (int e=offsets[i]; e<offsets[i+1]; e++)
+                {
+                    int j = adjacency[e];
+                    double dx = xi-px[j];
+                    double dy = yi-py[j];
+                    double norm = std::sqrt(dx*dx+dy*dy);
+                    double r = norm>1e-9? 1.0/norm : 0.0;
+                    sumW += 1;
+                    sumX += px[j]+r*dx;
+                    sumY += py[j]+r*dy;
+                    stress += (norm-1)*(norm-1);
+                }
+
+                // Pivots (weighted by the size of their region), branch free over structure of arrays
+                const int * row = pdistances+((qint64)i)*pivotCount;
+                for (int p=0; p<pivotCount; p++)
+                {
+                    double dx = xi-ppx[p];
+                    double dy = yi-ppy[p];
+                    double norm = std::sqrt(dx*dx+dy*dy);
+                    double d = row[p];
+                    double w = d>0? pweights[p]/(d*d) : 0.0;
+                    double r = norm>1e-9? d/norm : 0.0;
+                    sumW += w;
+                    sumX += w*(ppx[p]+r*dx);
+                    sumY += w*(ppy[p]+r*dy);
+                    stress += w*(norm-d)*(norm-d);
+                }
+
+                pnx[i] = sumW>0? sumX/sumW : xi;
+                pny[i] = sumW>0? sumY/sumW : yi;
+            }
+            pstresses[chunk] = stress;
+        });
+
+        x.swap(nextX);
+        y.swap(nextY);
+
+        double stress = 0;
+        for (double s : stresses)
+            stress += s;
+        if (lastStress>=0 && lastStress-stress < STRESS_TOLERANCE*lastStress)
+            break;
+        lastStress = stress;
+    }
+}
+
+void StressLayout::distancesFrom(const LayoutGraph &graph, int source, int *distances, QVector<int> &queue)
+{
+    int n = graph.count();
+    for (int i=0; i<n; i++)
+        distances[i] = -1;
+
+    queue.clear();
+    queue.append(source);
+    distances[source] = 0;
+    for (int head=0; head<queue.count(); head++)
+    {
+        int node = queue[head];
+        for (int i=0; i<graph.degree(node); i++)
+        {
+            int next = graph.neighbour(node,i);
+            if (distances[next]<0)
+            {
+                distances[next] = distances[node]+1;
+                queue.append(next);
+            }
+        }
+    }
+}
@@ -0,0 +1,78 @@
+#ifndef STRESSLAYOUT_H
+#define STRESSLAYOUT_H
+
+#include <QVector>
+
+namespace QNodeGraph
+{
+
+class LayoutGraph;
+
+/**
+ * @brief The StressLayout class Stress majorization layout (the geometric distances follow the graph distances)
+ *
+ * The nodes start from a PivotMDS projection. Small and medium graphs use the exact all-pairs shortest
+ * paths (one BFS per node, in parallel), bigger graphs use a sparse approximation where every node is
+ * only attracted by his neighbours and by a set of pivots. The result is deterministic.
+ */
+class StressLayout
+{
+public:
+    StressLayout();
+
+    /**
+     * @brief layout Compute the positions of the layout graph (fitted into the graph area)
+     * @param graph layout graph
+     * @return 0 if succeed
+     */
+    static int layout(LayoutGraph * graph);
+
+private:
+    /**
+     * @brief selectPivots Select the pivots (max-min: each one is the farthest node from the previous ones)
+     * @param graph layout graph
+     * @param pivotCount pivots to select
+     * @param pivots output pivot nodes
+     * @param pivotDistances output distances from every node to every pivot (node major: node*pivotCount+pivot)
+     * @param region output nearest pivot of every node
+     */
+    static void selectPivots(const LayoutGraph & graph, int pivotCount, QVector<int> * pivots, QVector<int> * pivotDistances, QVector<int> * region);
+    /**
+     * @brief pivotMds Initial positions by classical scaling over the distances to the pivots (PivotMDS)
+     * @param pivots pivot nodes
+     * @param pivotDistances distances from every node to every pivot
+     * @param x output x coordinates (in links)
+     * @param y output y coordinates (in links)
+     */
+    static void pivotMds(const QVector<int> & pivots, const QVector<int> & pivotDistances, QVector<double> & x, QVector<double> & y);
+    /**
+     * @brief exactStress Majorization using the distances between all the nodes
+     * @param graph layout graph
+     * @param x x coordinates
+     * @param y y coordinates
+     */
+    static void exactStress(const LayoutGraph & graph, QVector<double> & x, QVector<double> & y);
+    /**
+     * @brief sparseStress Majorization using the distances to the neighbours and to the pivots
+     * @param graph layout graph
+     * @param pivots pivot nodes
+     * @param pivotDistances distances from every node to every pivot
+     * @param region nearest pivot of every node
+     * @param x x coordinates
+     * @param y y coordinates
+     */
+    static void sparseStress(const LayoutGraph & graph, const QVector<int> & pivots, const QVector<int> & pivotDistances, const QVector<int> & region,
+                             QVector<double> & x, QVector<double> & y);
+    /**
+     * @brief distancesFrom Compute the graph distances (in links) from a node by BFS
+     * @param graph layout graph
+     * @param source source node
+     * @param distances output distances for each node (-1 for unreachable nodes)
+     * @param queue working queue (reused between calls)
+     */
+    static void distancesFrom(const LayoutGraph & graph, int source, int * distances, QVector<int> & queue);
+};
+
+}
+
+#endif // STRESSLAYOUT_H
@@ -37,11 +37,51 @@ QString XMLFunctions::createColorXMLTag(const QString &tag, const QColor &color)
                 color.red(),color.green(),color.blue()).arg(color.alpha());
 }
 
-QColor XMLFunctions::colorFromXML(const QDomNode &child)
+void XMLFunctions::writeSimpleTag(QXmlStreamWriter &xml, const QString &tag, const QString &text)
 {
-    int a = child.toElement().attribute("a").toUInt();
-    int r = child.toElement().attribute("r").toUInt();
-    int g = child.toElement().attribute("g").toUInt();
-    int b = child.toElement().attribute("b").toUInt();
+    xml.writeTextElement(tag,text);
+}
+
+void XMLFunctions::writeSimpleTag(QXmlStreamWriter &xml, const QString &tag, const uint64_t &text)
+{
+    xml.writeTextElement(tag,QString::number((qulonglong)text));
+}
+
+void XMLFunctions::writeSimpleTag(QXmlStreamWriter &xml, const QString &tag, const int64_t &text)
+{
+    xml.writeTextElement(tag,QString::number((qlonglong)text));
+}
+
+void XMLFunctions::writeSimpleTag(QXmlStreamWriter &xml, const QString &tag, const double &text)
+{
+    xml.writeTextElement(tag,QString::number(text));
+}
+
+void XMLFunctions::writeSimpleTag(QXmlStreamWriter &xml, const QString &tag, const bool &text)
+{
+    xml.writeTextElement(tag,text?"1":"0");
+}
+
+void XMLFunctions::writeColorXMLTag(QXmlStreamWriter &xml, const QString &tag, const QColor &color)
+{
+    xml.writeEmptyElement(tag);
+    xml.writeAttribute("r",QString::number(color.red()));
+    xml.writeAttribute("g",QString::number(color.green()));
+    xml.writeAttribute("b",QString::number(color.blue()));
+    xml.writeAttribute("a",QString::number(color.alpha()));
+}
+
+QColor XMLFunctions::colorFromXML(const QXmlStreamAttributes &attributes)
+{
+    int a = attributes.value("a").toUInt();
+    int r = attributes.value("r").toUInt();
+    int g = attributes.value("g").toUInt();
+    int b = attributes.value("b").toUInt();
     return QColor(r,g,b,a);
 }
+
+QString XMLFunctions::fromBase64(const QString &text)
+{
+    QByteArray bArrayElement = QByteArray::fromBase64(text.toLatin1());
+    return QString::fromUtf8(bArrayElement.data(),bArrayElement.size());
+}
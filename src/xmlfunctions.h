@@ -2,8 +2,9 @@
 #define XMLFUNCTIONS_H
 
 #include <QString>
-#include <QDomNode>
 #include <QColor>
+#include <QXmlStreamWriter>
+#include <QXmlStreamReader>
 
 namespace QNodeGraph
 {
@@ -56,11 +57,60 @@ public:
     static QString createColorXMLTag(const QString &tag, const QColor &color);
 
     /**
-     * @brief colorFromXML Create color from XML entity
-     * @param child XML dom node entity
+     * @brief writeSimpleTag Write simple XML entity from qstring
+     * @param xml XML writer
+     * @param tag tag name
+     * @param text qstring
+     */
+    static void writeSimpleTag(QXmlStreamWriter & xml, const QString &tag, const QString &text);
+    /**
+     * @brief writeSimpleTag Write simple XML entity from uint64_t
+     * @param xml XML writer
+     * @param tag tag name
+     * @param text uint64_t
+     */
+    static void writeSimpleTag(QXmlStreamWriter & xml, const QString &tag, const uint64_t &text);
+    /**
+     * @brief writeSimpleTag Write simple XML entity from int64_t
+     * @param xml XML writer
+     * @param tag tag name
+     * @param text int64_t
+     */
+    static void writeSimpleTag(QXmlStreamWriter & xml, const QString &tag, const int64_t &text);
+    /**
+     * @brief writeSimpleTag Write simple XML entity from double
+     * @param xml XML writer
+     * @param tag tag name
+     * @param text double
+     */
+    static void writeSimpleTag(QXmlStreamWriter & xml, const QString &tag, const double &text);
+    /**
+     * @brief writeSimpleTag Write simple XML entity from bool
+     * @param xml XML writer
+     * @param tag tag name
+     * @param text bool
+     */
+    static void writeSimpleTag(QXmlStreamWriter & xml, const QString &tag, const bool &text);
+    /**
+     * @brief writeColorXMLTag Write XML entity from QColor
+     * @param xml XML writer
+     * @param tag tag name
+     * @param color QColor
+     */
+    static void writeColorXMLTag(QXmlStreamWriter & xml, const QString &tag, const QColor &color);
+
+    /**
+     * @brief colorFromXML Create color from the attributes of a XML entity
+     * @param attributes XML stream reader attributes
      * @return QColor type color
      */
-    static QColor colorFromXML(const QDomNode &child);
+    static QColor colorFromXML(const QXmlStreamAttributes &attributes);
+    /**
+     * @brief fromBase64 Decode a base64 encoded UTF-8 text
+     * @param text base64 text
+     * @return decoded text
+     */
+    static QString fromBase64(const QString &text);
 
 };
 